@@ -39,6 +39,32 @@ AccessKey::getData() const
     return mData;
 }
 
+inline AccessKey &
+AccessKey::setAlgorithm(RsaKey::Algorithm algorithm)
+{
+    mAlgorithm = algorithm;
+    return *this;
+}
+
+inline RsaKey::Algorithm
+AccessKey::getAlgorithm() const
+{
+    return mAlgorithm;
+}
+
+inline AccessKey &
+AccessKey::setVersion(unsigned int version)
+{
+    mVersion = version;
+    return *this;
+}
+
+inline unsigned int
+AccessKey::getVersion() const
+{
+    return mVersion;
+}
+
 } // End of main namespace
 
 #endif /* __KM_ACCESS_KEY_INL_HPP__ */
@@ -14,6 +14,7 @@
 #include <km.hpp>
 #include <km/Exception.hpp>
 #include <km/Buffer.hpp>
+#include <km/RsaKey.hpp>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/regex.hpp>
@@ -109,6 +110,34 @@ public:
      */
     const Buffer &getData() const;
 
+    /*!
+     * Sets the algorithm of the recipient key.
+     *
+     * @param[in] algorithm The key algorithm.
+     *
+     * @return The access key.
+     */
+    AccessKey &setAlgorithm(RsaKey::Algorithm algorithm);
+
+    /*!
+     * Returns the algorithm of the recipient key.
+     */
+    RsaKey::Algorithm getAlgorithm() const;
+
+    /*!
+     * Sets the version of the key (incremented on every rotation).
+     *
+     * @param[in] version The key version.
+     *
+     * @return The access key.
+     */
+    AccessKey &setVersion(unsigned int version);
+
+    /*!
+     * Returns the version of the key.
+     */
+    unsigned int getVersion() const;
+
 protected:
 
     /*!
@@ -120,6 +149,16 @@ protected:
      * The key data.
      */
     Buffer mData;
+
+    /*!
+     * The algorithm of the recipient key (the data is wrapped accordingly).
+     */
+    RsaKey::Algorithm mAlgorithm;
+
+    /*!
+     * The key version.
+     */
+    unsigned int mVersion;
 };
 
 } // End of main namespace
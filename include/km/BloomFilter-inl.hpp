@@ -0,0 +1,24 @@
+/*!
+ * Title ---- km/BloomFilter-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_BLOOM_FILTER_INL_HPP__
+#define __KM_BLOOM_FILTER_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline std::size_t
+BloomFilter::getCapacity() const
+{
+    return mBits.size() * 8 / BITS_PER_ITEM;
+}
+
+} // End of main namespace
+
+#endif /* __KM_BLOOM_FILTER_INL_HPP__ */
@@ -0,0 +1,129 @@
+/*!
+ * Title ---- km/BloomFilter.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_BLOOM_FILTER_HPP__
+#define __KM_BLOOM_FILTER_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+
+#include <cstdint>
+
+#include <openssl/evp.h>
+
+namespace km { // Begin main namespace
+
+/*!
+ * A Bloom filter over a set of buffers.
+ *
+ * Answers "certainly not" or "maybe" to the membership queries; with the
+ * default parameters about one query in a hundred is a false positive,
+ * as long as the filter holds at most the number of items it was sized for.
+ */
+class BloomFilter
+{
+
+public:
+
+    /*!
+     * Filter parameters.
+     */
+    enum {
+
+        BITS_PER_ITEM = 10,
+        NUM_HASHES    = 7,
+        MIN_CAPACITY  = 64
+    };
+
+    /*!
+     * Creates an empty filter.
+     *
+     * @param[in] capacity The expected number of items.
+     *
+     * @return The filter.
+     */
+    static BloomFilter create(std::size_t capacity);
+
+    /*!
+     * Builds a filter from a buffer.
+     *
+     * @param[in] data The filter bits.
+     *
+     * @return The filter.
+     */
+    static BloomFilter fromBuffer(const Buffer &data);
+
+    /*!
+     * Converts a filter into a buffer.
+     *
+     * @param[in] filter The filter.
+     *
+     * @return The filter bits.
+     */
+    static Buffer toBuffer(const BloomFilter &filter);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~BloomFilter();
+
+    /*!
+     * Adds an item to the filter.
+     *
+     * @param[in] item The item.
+     *
+     * @return The filter instance.
+     */
+    BloomFilter &add(const Buffer &item);
+
+    /*!
+     * Checks whether an item may be in the filter.
+     *
+     * @param[in] item The item.
+     *
+     * @return `false` if the item has certainly not been added.
+     */
+    bool mayContain(const Buffer &item) const;
+
+    /*!
+     * Returns the number of items the filter has been sized for.
+     */
+    std::size_t getCapacity() const;
+
+protected:
+
+    /*!
+     * Constructor method.
+     */
+    BloomFilter();
+
+    /*!
+     * Computes the base hashes of an item.
+     *
+     * @param[in]  item   The item.
+     * @param[out] first  The first hash.
+     * @param[out] second The second hash (used as the step).
+     */
+    static void hash(const Buffer &item, std::uint64_t &first, std::uint64_t &second);
+
+
+    /*!
+     * The filter bits.
+     */
+    Buffer mBits;
+};
+
+} // End of main namespace
+
+#endif /* __KM_BLOOM_FILTER_HPP__ */
+
+// Include inline methods
+#include <km/BloomFilter-inl.hpp>
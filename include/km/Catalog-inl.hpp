@@ -0,0 +1,24 @@
+/*!
+ * Title ---- km/Catalog-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_CATALOG_INL_HPP__
+#define __KM_CATALOG_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline bool
+Catalog::hasRepository(const Buffer &id) const
+{
+    return mRepositories.find(id) != mRepositories.end();
+}
+
+} // End of main namespace
+
+#endif /* __KM_CATALOG_INL_HPP__ */
@@ -0,0 +1,241 @@
+/*!
+ * Title ---- km/Catalog.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_CATALOG_HPP__
+#define __KM_CATALOG_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/PrivateKey.hpp>
+#include <km/PublicKey.hpp>
+#include <km/AccessKey.hpp>
+#include <km/EntryNode.hpp>
+#include <km/KeyringNode.hpp>
+#include <km/Encrypter.hpp>
+#include <km/BloomFilter.hpp>
+
+#include <memory>
+#include <functional>
+#include <vector>
+#include <map>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The local catalog of the keyrings.
+ *
+ * Maps the repositories to their names and the entries to their
+ * repositories, so that an entry can be located without opening every
+ * keyring. Every repository also has a Bloom filter of its entry IDs and
+ * names, which rules out most of the repositories when an entry is
+ * looked up by name.
+ *
+ * The catalog is stored encrypted under a random key wrapped for the user.
+ */
+class Catalog
+{
+
+public:
+
+    /*!
+     * The catalog file.
+     */
+    static const filesystem::path CatalogFile;
+
+    /*!
+     * Creates an empty catalog with a new key.
+     *
+     * @param[in] publicKey  The public key of the user.
+     * @param[in] privateKey The private key of the user.
+     *
+     * @return The catalog.
+     */
+    static Catalog create(const PublicKey &publicKey, const PrivateKey &privateKey);
+
+    /*!
+     * Reads a catalog from a file.
+     *
+     * @param[in] path       The file path.
+     * @param[in] privateKey The private key of the user.
+     *
+     * @return The catalog.
+     */
+    static Catalog fromFile(const filesystem::path &path, const PrivateKey &privateKey);
+
+    /*!
+     * Stores a catalog into a file (replacing it atomically).
+     *
+     * @param[in] path    The file path.
+     * @param[in] catalog The catalog.
+     */
+    static void toFile(const filesystem::path &path, const Catalog &catalog);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~Catalog();
+
+    /*!
+     * Adds a repository, forgetting its previous entries.
+     *
+     * @param[in] id           The repository ID.
+     * @param[in] name         The repository name.
+     * @param[in] numOfEntries The expected number of entries.
+     *
+     * @return The catalog instance.
+     */
+    Catalog &setRepository(const Buffer &id, const Buffer &name, std::size_t numOfEntries);
+
+    /*!
+     * Adds an entry to a repository.
+     *
+     * @param[in] repositoryId The repository ID.
+     * @param[in] entryId      The entry ID.
+     * @param[in] entryName    The entry name (empty if unnamed).
+     *
+     * @return The catalog instance.
+     */
+    Catalog &setEntry(const Buffer &repositoryId, const Buffer &entryId, const Buffer &entryName);
+
+    /*!
+     * Adds an entry to a repository, by its name property.
+     *
+     * @param[in] repositoryId The repository ID.
+     * @param[in] entry        The decrypted entry.
+     *
+     * @return The catalog instance.
+     */
+    Catalog &setEntry(const Buffer &repositoryId, const EntryNode &entry);
+
+    /*!
+     * Adds a repository with all its entries.
+     *
+     * @param[in] repositoryId The repository ID.
+     * @param[in] keyring      The (encrypted) keyring.
+     * @param[in] encrypter    The encrypter of the keyring.
+     *
+     * @return The catalog instance.
+     */
+    Catalog &setKeyring(const Buffer &repositoryId, const KeyringNode &keyring, const Encrypter &encrypter);
+
+    /*!
+     * Removes a repository and its entries.
+     *
+     * @param[in] id The repository ID.
+     *
+     * @return The catalog instance.
+     */
+    Catalog &removeRepository(const Buffer &id);
+
+    /*!
+     * Checks whether a repository is in the catalog.
+     *
+     * @param[in] id The repository ID.
+     */
+    bool hasRepository(const Buffer &id) const;
+
+    /*!
+     * Iterates over the repositories.
+     *
+     * @param[in] callback The callback function.
+     *
+     * @return The catalog instance.
+     */
+    const Catalog &eachRepository(std::function<void (const Buffer &id, const Buffer &name, std::size_t numOfEntries)> callback) const;
+
+    /*!
+     * Looks up the repositories that may contain an entry.
+     *
+     * An entry ID is resolved exactly; an entry name returns the candidates
+     * passing the Bloom filters, which must be verified by the caller.
+     *
+     * @param[in]  reference The entry ID or name.
+     * @param[out] exact     Whether the result is exact.
+     *
+     * @return The repository IDs.
+     */
+    std::vector<Buffer> locate(const Buffer &reference, bool &exact) const;
+
+protected:
+
+    /*!
+     * A catalogued repository.
+     */
+    struct Record
+    {
+        /*!
+         * The repository name.
+         */
+        Buffer name;
+
+        /*!
+         * The filter of the entry IDs and names.
+         */
+        BloomFilter filter;
+
+        /*!
+         * The number of entries.
+         */
+        std::size_t numOfEntries;
+    };
+
+    /*!
+     * Constructor method.
+     */
+    Catalog();
+
+    /*!
+     * Serializes the content of the catalog.
+     *
+     * @return The plain content.
+     */
+    Buffer toBuffer() const;
+
+    /*!
+     * Parses the content of the catalog.
+     *
+     * @param[in] data The plain content.
+     */
+    void parse(const Buffer &data);
+
+
+    /*!
+     * The repositories.
+     */
+    std::map<Buffer, Record> mRepositories;
+
+    /*!
+     * The repository of each entry.
+     */
+    std::map<Buffer, Buffer> mEntries;
+
+    /*!
+     * The wrapped key of the catalog.
+     */
+    AccessKey mAccessKey;
+
+    /*!
+     * The encrypter (holding the unwrapped key).
+     */
+    std::shared_ptr<Encrypter> mEncrypter;
+};
+
+} // End of main namespace
+
+#endif /* __KM_CATALOG_HPP__ */
+
+// Include inline methods
+#include <km/Catalog-inl.hpp>
@@ -0,0 +1,25 @@
+/*!
+ * Title ---- km/ChunkStore-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_CHUNK_STORE_INL_HPP__
+#define __KM_CHUNK_STORE_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline bool
+ChunkStore::isManifest(const Buffer &content)
+{
+    return content.size() >= ManifestHeader.size()
+        && std::equal(ManifestHeader.begin(), ManifestHeader.end(), content.begin());
+}
+
+} // End of main namespace
+
+#endif /* __KM_CHUNK_STORE_INL_HPP__ */
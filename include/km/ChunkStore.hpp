@@ -0,0 +1,190 @@
+/*!
+ * Title ---- km/ChunkStore.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_CHUNK_STORE_HPP__
+#define __KM_CHUNK_STORE_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/Encrypter.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The encrypted chunks of the attachments of a repository.
+ *
+ * The files are split by content-defined chunking (a gear hash keyed by the
+ * access key), so an edit changes only the chunks around it; each chunk is
+ * encrypted and stored as `chunks/<ID>`, where the ID is a keyed digest of
+ * its content, so identical chunks are stored once.
+ *
+ * An attachment is a flagged property holding the manifest of its chunks; the files
+ * are written and read a chunk at a time.
+ */
+class ChunkStore
+{
+
+public:
+
+    /*!
+     * Chunking parameters (in bytes).
+     */
+    enum {
+
+        CHUNK_MIN_SIZE = 16 * 1024,
+        CHUNK_AVG_SIZE = 64 * 1024,
+        CHUNK_MAX_SIZE = 256 * 1024,
+        READ_BLOCK_SIZE = 64 * 1024,
+
+        ID_LENGTH = 32 // SHA-256
+    };
+
+    /*!
+     * The directory of the chunks.
+     */
+    static const filesystem::path ChunkDir;
+
+    /*!
+     * The header of the manifests.
+     */
+    static const std::string ManifestHeader;
+
+    /*!
+     * Indicates whether a property content has the format of a manifest.
+     *
+     * NOTE: the attachments are flagged on their nodes (see `PropertyNode::isAttachment()`),
+     *       an ordinary value may start with the header too.
+     *
+     * @param[in] content The property content.
+     */
+    static bool isManifest(const Buffer &content);
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] path      The path to the repository.
+     * @param[in] encrypter The encrypter of the repository.
+     */
+    ChunkStore(const filesystem::path &path, const Encrypter &encrypter);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~ChunkStore();
+
+    /*!
+     * Stores a file.
+     *
+     * @param[in] input The file content.
+     *
+     * @return The manifest of the file.
+     */
+    Buffer write(std::istream &input);
+
+    /*!
+     * Restores a file.
+     *
+     * @param[in]  manifest The manifest of the file.
+     * @param[out] output   The file content.
+     */
+    const ChunkStore &read(const Buffer &manifest, std::ostream &output) const;
+
+    /*!
+     * Copies a file to another store (of another repository).
+     *
+     * @param[in] manifest The manifest of the file.
+     * @param[in] target   The target store.
+     *
+     * @return The manifest of the copy.
+     */
+    Buffer copy(const Buffer &manifest, ChunkStore &target) const;
+
+protected:
+
+    /*!
+     * Builds the manifest of a file.
+     *
+     * @param[in] size The file size.
+     * @param[in] ids  The chunk IDs.
+     *
+     * @return The manifest.
+     */
+    static Buffer toManifest(std::uint64_t size, const std::vector<std::string> &ids);
+
+    /*!
+     * Parses the manifest of a file.
+     *
+     * @param[in]  manifest The manifest.
+     * @param[out] size     The file size.
+     *
+     * @return The chunk IDs.
+     */
+    static std::vector<std::string> fromManifest(const Buffer &manifest, std::uint64_t &size);
+
+    /*!
+     * Stores a chunk (unless already stored).
+     *
+     * @param[in] chunk The chunk content.
+     *
+     * @return The chunk ID.
+     */
+    std::string writeChunk(const Buffer &chunk);
+
+    /*!
+     * Loads a chunk, checking its content.
+     *
+     * @param[in] id The chunk ID.
+     *
+     * @return The chunk content.
+     */
+    Buffer readChunk(const std::string &id) const;
+
+
+    /*!
+     * The path to the chunks.
+     */
+    filesystem::path mPath;
+
+    /*!
+     * The encrypter of the repository.
+     */
+    const Encrypter &mEncrypter;
+
+    /*!
+     * The gear table of the rolling hash.
+     */
+    std::array<std::uint64_t, 256> mGear;
+
+    /*!
+     * The mask of the chunk boundaries.
+     */
+    std::uint64_t mMask;
+};
+
+} // End of main namespace
+
+#endif /* __KM_CHUNK_STORE_HPP__ */
+
+// Include inline methods
+#include <km/ChunkStore-inl.hpp>
@@ -96,6 +96,11 @@ protected:
      */
     void runList(const CommandArgs &args);
 
+    /*!
+     * Finds the repositories containing an entry.
+     */
+    void runFind(const CommandArgs &args);
+
     /*!
      * Creates a new repository.
      */
@@ -111,6 +116,26 @@ protected:
      */
     void runShare(const CommandArgs &args);
 
+    /*!
+     * Manages the groups.
+     */
+    void runGroup(const CommandArgs &args);
+
+    /*!
+     * Rotates the access key of a repository.
+     */
+    void runRotate(const CommandArgs &args);
+
+    /*!
+     * Copies (or moves) entries between repositories.
+     */
+    void runCopy(const CommandArgs &args);
+
+    /*!
+     * Stores (or restores) the file attachments of an entry.
+     */
+    void runAttachment(const CommandArgs &args);
+
     /*!
      * Commits the changes of a repository.
      */
@@ -126,6 +151,36 @@ protected:
      */
     void runFetch(const CommandArgs &args);
 
+    /*!
+     * Compacts the history of a repository.
+     */
+    void runCompact(const CommandArgs &args);
+
+    /*!
+     * Verifies the integrity of a repository.
+     */
+    void runVerify(const CommandArgs &args);
+
+    /*!
+     * Runs the SSH control master.
+     */
+    void runMaster(const CommandArgs &args);
+
+    /*!
+     * Runs the key agent.
+     */
+    void runAgent(const CommandArgs &args);
+
+    /*!
+     * Prints an entry through the key agent.
+     */
+    void runGet(const CommandArgs &args);
+
+    /*!
+     * Sets an entry property through the key agent.
+     */
+    void runSet(const CommandArgs &args);
+
     /*!
      * Prints the logs of a repository.
      */
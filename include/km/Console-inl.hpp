@@ -34,6 +34,18 @@ Console::getDebug()
     return mDebug;
 }
 
+inline void
+Console::setQuiet(bool state)
+{
+    mQuiet = state;
+}
+
+inline bool
+Console::getQuiet()
+{
+    return mQuiet;
+}
+
 } // End of main namespace
 
 #endif /* __KM_CONSOLE_INL_HPP__ */
\ No newline at end of file
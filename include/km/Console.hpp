@@ -49,7 +49,7 @@
         __tracker.done(); \
     } \
     catch (::km::TaskException e) { __tracker.fail(); } \
-    catch (::km::Exception e)     { __tracker.fail(); throw e; } \
+    catch (::km::Exception &e)    { __tracker.fail(); throw; } \
 }
 
 
@@ -92,12 +92,27 @@ public:
      */
     static bool getDebug();
 
+    /*!
+     * Silences the output of the current thread.
+     */
+    static void setQuiet(bool state);
+
+    /*!
+     * Returns the quiet state of the current thread.
+     */
+    static bool getQuiet();
+
 protected:
 
     /*!
      * The name of the agent that initiated the task.
      */
     static bool mDebug;
+
+    /*!
+     * The quiet state of the current thread.
+     */
+    static thread_local bool mQuiet;
 };
 
 
@@ -52,6 +52,12 @@ Core::getKeyring()
     return *mKeyringNode;
 }
 
+inline int
+Core::getHistoryRetention() const
+{
+    return mConfig.get<int>("repository.history_retention", HistoryRetention);
+}
+
 inline const std::vector<Buffer> &
 Core::getRepositoryList() const
 {
@@ -64,6 +70,12 @@ Core::getEntryList() const
     return mEntryList;
 }
 
+inline const PrivateKey &
+Core::getRecipientKey() const
+{
+    return mPrivateKey.canWrap() ? mPrivateKey : *mWrappingKey;
+}
+
 } // End of main namespace
 
 #endif /* __KM_CORE_INL_HPP__ */
\ No newline at end of file
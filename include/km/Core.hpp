@@ -17,9 +17,16 @@
 #include <km/AccessKey.hpp>
 #include <km/Encrypter.hpp>
 #include <km/KeyringNode.hpp>
+#include <km/ChunkStore.hpp>
+#include <km/Catalog.hpp>
 #include <km/TextNode.hpp>
 #include <km/Repository.hpp>
+#include <km/PushQueue.hpp>
 #include <km/SshClient.hpp>
+#include <km/ShellMaster.hpp>
+#include <km/KeyAgent.hpp>
+#include <km/JsonReader.hpp>
+#include <km/TaskPool.hpp>
 
 #include <iostream>
 #include <memory>
@@ -27,6 +34,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 
 #include <cstdlib>
 
@@ -65,6 +80,20 @@ public:
      */
     const Buffer ShellPort = Buffer::fromString("22");
 
+    /*!
+     * Rotation parameters.
+     */
+    enum {
+
+        ROTATION_BATCH_SIZE = 500, // entries per commit
+        TRANSFER_BATCH_SIZE = 500  // entries decrypted at once
+    };
+
+    /*!
+     * The default retention window of the repository history (in days).
+     */
+    const int HistoryRetention = 90;
+
 	/*!
      * Returns a pointer to the singleton.
      */
@@ -110,6 +139,56 @@ public:
      */
     Core &shareRepository(const Buffer &userId);
 
+    /*!
+     * Shares the repository with several users at once.
+     *
+     * The users are resolved concurrently and the keyring is rewritten and
+     * committed once.
+     *
+     * @param[in] userIds The user IDs.
+     */
+    Core &shareRepository(const std::vector<Buffer> &userIds);
+
+    /*!
+     * Shares the repository with a group.
+     *
+     * The access key is wrapped once, by the group key.
+     *
+     * @param[in] groupId The group ID.
+     */
+    Core &shareRepositoryWithGroup(const Buffer &groupId);
+
+    /*!
+     * Creates a new group.
+     *
+     * The group key is kept in a keyring of its own (in `~/.km/groups`),
+     * wrapped once per member.
+     *
+     * @param[in] name The group name.
+     */
+    Core &createGroup(const Buffer &name);
+
+    /*!
+     * Adds a member to a group.
+     *
+     * @param[in] groupId The group ID.
+     * @param[in] userId  The user ID.
+     */
+    Core &addGroupMember(const Buffer &groupId, const Buffer &userId);
+
+    /*!
+     * Rotates the access key of the repository.
+     *
+     * The new key is wrapped at once for the remaining recipients, then the
+     * entries are re-encrypted in batches, each one committed and recorded in
+     * a progress file (in `~/.km/rotations`): an interrupted rotation resumes
+     * from its last batch. Meanwhile the entries are read by the previous keys,
+     * which the keyring keeps encrypted by the new one.
+     *
+     * @param[in] revokedUserIds The users losing the access.
+     */
+    Core &rotateRepository(const std::vector<Buffer> &revokedUserIds);
+
     /*!
      * Sets an entry in the repository.
      *
@@ -117,6 +196,20 @@ public:
      */
     Core &setRepositoryEntry(const EntryNode &entry);
 
+    /*!
+     * Copies (or moves) entries to another local repository.
+     *
+     * The entries are decrypted by the source key and encrypted by the target
+     * one in parallel batches, so that only a batch is held in clear at once;
+     * each repository gets a single commit. The copies get new IDs, the
+     * attachments are copied a chunk at a time.
+     *
+     * @param[in] targetId The target repository ID.
+     * @param[in] entryIds The entry IDs (all the entries, if empty).
+     * @param[in] move     Whether the entries are removed from the source.
+     */
+    Core &copyRepositoryEntries(const Buffer &targetId, const std::vector<Buffer> &entryIds, bool move);
+
     /*!
      * Returns an entry in the repository.
      *
@@ -126,6 +219,38 @@ public:
      */
     EntryNode getRepositoryEntry(const Buffer &id);
 
+    /*!
+     * Looks up an entry in the repository by ID or by name (decrypting
+     * only the entry names).
+     *
+     * @param[in]  reference The entry ID or name.
+     * @param[out] id        The entry ID.
+     *
+     * @return `false` if no entry matches.
+     */
+    bool findRepositoryEntry(const Buffer &reference, Buffer &id);
+
+    /*!
+     * Stores a file as an attachment of an entry.
+     *
+     * The file is read a chunk at a time and stored in the chunks of the
+     * repository (see `ChunkStore`); the property holds their manifest.
+     *
+     * @param[in] entryId The entry ID.
+     * @param[in] name    The property name.
+     * @param[in] input   The file content.
+     */
+    Core &setRepositoryAttachment(const Buffer &entryId, const Buffer &name, std::istream &input);
+
+    /*!
+     * Restores an attachment of an entry, a chunk at a time.
+     *
+     * @param[in]  entryId The entry ID.
+     * @param[in]  name    The property name.
+     * @param[out] output  The file content.
+     */
+    Core &getRepositoryAttachment(const Buffer &entryId, const Buffer &name, std::ostream &output);
+
     /*!
      * Iterates over the repository entries.
      *
@@ -141,15 +266,49 @@ public:
     Core &commitRepository(const Buffer &message);
 
     /*!
-     * Pushes the repository.
+     * Schedules a background push of the repository.
      */
     Core &pushRepository();
 
+    /*!
+     * Waits until all the scheduled pushes are completed.
+     */
+    Core &flush();
+
+    /*!
+     * Returns the pushes rejected by the remote, with their errors.
+     */
+    std::map<Buffer, std::string> getPushFailures() const;
+
     /*!
      * Fetches changes of the repository.
      */
     Core &fetchRepository();
 
+    /*!
+     * Squashes the history older than the retention window and replaces the remote history.
+     *
+     * @param[in] retention The retention window (in days).
+     */
+    Core &compactRepository(int retention);
+
+    /*!
+     * Checks the entry files against the integrity tree of the repository,
+     * after checking the seal of the tree with the access key.
+     *
+     * @return The IDs of the missing, unknown or altered entries.
+     */
+    std::vector<Buffer> verifyRepository();
+
+    /*!
+     * Locates the entries that differ from another revision of the repository.
+     *
+     * @param[in] revision The revision (e.g. a remote snapshot).
+     *
+     * @return The IDs of the added, removed or modified entries.
+     */
+    std::vector<Buffer> diffRepository(const Buffer &revision);
+
     /*!
      * Iterates over the repository logs.
      */
@@ -160,6 +319,31 @@ public:
      */
     Core &destroyRepository();
 
+    /*!
+     * Runs the SSH control master used by the other invocations.
+     *
+     * @param[in] idleTimeout The time without requests after which the master exits.
+     */
+    Core &serveShell(std::chrono::seconds idleTimeout);
+
+    /*!
+     * Runs the key agent used by the other invocations.
+     *
+     * @param[in] idleTimeout The time without requests after which the keys are dropped.
+     * @param[in] memoryLock  Indicates whether the agent refuses to run without locked memory.
+     */
+    Core &serveAgent(std::chrono::seconds idleTimeout, bool memoryLock = true);
+
+    /*!
+     * Sends a request to the key agent.
+     *
+     * @param[in]  request  The request.
+     * @param[out] response The response.
+     *
+     * @return `false` if the agent is not running.
+     */
+    bool requestAgent(const IpcChannel::Message &request, IpcChannel::Message &response) const;
+
     /*!
      * Iterates over the repository entries.
      *
@@ -167,7 +351,14 @@ public:
      */
     Core &eachRepository(std::function<void (const Buffer &id, Repository &repository)> callback);
 
-    // FIXME: add const ??
+    /*!
+     * Iterates over the (decrypted) keyrings.
+     *
+     * The keyrings are parsed and unlocked by a pool of workers and reported
+     * in order of ID; their Git repositories are not opened.
+     *
+     * @param[in] callback The callback function.
+     */
     Core &eachKeyring(std::function<void (const Buffer &id, KeyringNode &)> callback);
 
 
@@ -181,6 +372,32 @@ public:
      */
     Core &fetchRepositories();
 
+    /*!
+     * Fetches the groups of the user.
+     */
+    Core &fetchGroups();
+
+    /*!
+     * Iterates over the repositories of the local catalog.
+     *
+     * @param[in] callback The callback function.
+     */
+    Core &eachCatalogRepository(std::function<void (const Buffer &id, const Buffer &name, std::size_t numOfEntries)> callback);
+
+    /*!
+     * Looks up the local repositories containing an entry.
+     *
+     * @param[in] reference The entry ID or name.
+     *
+     * @return The repository IDs.
+     */
+    std::vector<Buffer> locateEntry(const Buffer &reference);
+
+    /*!
+     * Rebuilds the local catalog from the keyrings.
+     */
+    Core &indexRepositories();
+
 
 
     /*!
@@ -194,6 +411,11 @@ public:
     template <typename T>
     T getEnvironment(const Buffer &name);
 
+    /*!
+     * Returns the retention window of the repository history (in days).
+     */
+    int getHistoryRetention() const;
+
     /*!
      * Returns the list of repositories.
      */
@@ -277,10 +499,44 @@ protected:
     /*!
      * Creates an access key.
      *
-     * @param[in] key       The access key data.
+     * @param[in] key       The (unwrapped) access key.
      * @param[in] publicKey The public key.
      */
-    AccessKey createAccessKey(const Buffer &key, const PublicKey &publicKey) const;
+    AccessKey createAccessKey(const AccessKey &key, const PublicKey &publicKey) const;
+
+    /*!
+     * Creates the access keys for several recipients (in parallel).
+     *
+     * @param[in] key        The (unwrapped) access key.
+     * @param[in] publicKeys The public keys.
+     */
+    std::vector<AccessKey> createAccessKeys(const AccessKey &key, const std::vector<PublicKey> &publicKeys) const;
+
+    /*!
+     * Wraps a new access key for the remaining recipients of the repository.
+     *
+     * @param[in] revokedUserIds The users losing the access.
+     */
+    void rotateAccessKey(const std::vector<Buffer> &revokedUserIds);
+
+    /*!
+     * Re-encrypts the entries still encrypted by a previous access key.
+     */
+    void reencryptEntries();
+
+    /*!
+     * Commits the keyring files of the repository.
+     *
+     * @param[in] message The commit message.
+     */
+    void commitKeyring(const Buffer &message);
+
+    /*!
+     * Returns the path to the progress file of a key rotation.
+     *
+     * @param[in] repositoryId The repository ID.
+     */
+    filesystem::path getRotationPath(const Buffer &repositoryId) const;
 
     /*!
      * Builds a Git repository.
@@ -301,20 +557,116 @@ protected:
      * Shares a Git repository.
      *
      * @param[in] repository The repository instance.
-     * @param[in] publicKey  The public key.
+     * @param[in] accessKeys The wrapped access keys of the new recipients.
      */
-    void shareGitRepository(Repository &repository, const PublicKey &publicKey) const;
+    void shareGitRepository(Repository &repository, const std::vector<AccessKey> &accessKeys) const;
+
+    /*!
+     * Returns the public keys of some users that can wrap the access keys.
+     *
+     * @param[in] userIds The user IDs.
+     *
+     * @return The keys of each user (in the same order).
+     */
+    std::vector<std::vector<PublicKey>> getUserKeys(const std::vector<Buffer> &userIds);
+
+    /*!
+     * Returns the local keyring of a group.
+     *
+     * @param[in] groupId The group ID.
+     */
+    Repository getGroupRepository(const Buffer &groupId) const;
+
+    /*!
+     * Looks up a local group through which a keyring is shared.
+     *
+     * @param[in] keyringNode The keyring.
+     *
+     * @return The group ID (empty if none).
+     */
+    Buffer findGroup(const KeyringNode &keyringNode) const;
 
     /*!
      * Parses the repository.
      */
     void parseRepository();
 
+    /*!
+     * Returns the key for which the access keys are wrapped.
+     *
+     * The Ed25519 and ECDSA keys can only authenticate, the access keys are
+     * wrapped for the X25519 key in their place.
+     */
+    const PrivateKey &getRecipientKey() const;
+
+    /*!
+     * Returns the encrypter of a keyring.
+     *
+     * The access key is unwrapped only the first time or when it has been
+     * replaced in the keyring configuration.
+     *
+     * @param[in] repositoryId The repository ID.
+     * @param[in] keyringNode  The (encrypted) keyring.
+     */
+    const Encrypter &unlockKeyring(const Buffer &repositoryId, const KeyringNode &keyringNode);
+
+    /*!
+     * Returns the local catalog, building it if missing or unreadable.
+     */
+    Catalog &getCatalog();
+
+    /*!
+     * Applies a change to the local catalog, if it exists.
+     *
+     * The catalog is dropped when the change fails, to be rebuilt on the
+     * next lookup.
+     *
+     * @param[in] update The change.
+     */
+    void updateCatalog(std::function<void (Catalog &)> update);
+
+    /*!
+     * Adds a keyring to a catalog, replacing its previous record.
+     *
+     * @param[in] catalog      The catalog.
+     * @param[in] repositoryId The repository ID.
+     * @param[in] keyringNode  The (encrypted) keyring.
+     */
+    void indexKeyring(Catalog &catalog, const Buffer &repositoryId, const KeyringNode &keyringNode);
+
+    /*!
+     * Reloads only the parts of the repository changed since a previous commit.
+     *
+     * @param[in] from The hash of the previous commit.
+     */
+    void refreshRepository(const Buffer &from);
+
 
     Repository  &getRepository();
     SshClient   &getShell();
     KeyringNode &getKeyring();
 
+    /*!
+     * Runs a shell command and parses its JSON response while it streams in.
+     *
+     * @param[in] command  The command to execute.
+     * @param[in] callback The callback of the values under `content`.
+     *
+     * @return The response status.
+     */
+    int execShell(const Buffer &command, JsonReader::Callback callback);
+
+    /*!
+     * Schedules a shell command whose JSON response is parsed while it
+     * streams in (the commands run with `getShell().run()`).
+     *
+     * @param[in] command  The command to execute.
+     * @param[in] callback The callback of the values under `content`.
+     *
+     * @return The future response status.
+     */
+    std::future<int> execShellAsync(const Buffer &command, JsonReader::Callback callback);
+
     filesystem::path mHomePath;
 
     /*!
@@ -327,6 +679,16 @@ protected:
      */
     filesystem::path mKeyringPath;
 
+    /*!
+     * The path to the group keyrings.
+     */
+    filesystem::path mGroupPath;
+
+    /*!
+     * The path to the progress files of the key rotations.
+     */
+    filesystem::path mRotationPath;
+
     /*!
      * The property tree of the application configuration.
      */
@@ -347,11 +709,21 @@ protected:
      */
     PrivateKey mPrivateKey;
 
+    /*!
+     * The X25519 key unwrapping the access keys, if configured (`security.wrapping_key`).
+     */
+    std::unique_ptr<PrivateKey> mWrappingKey;
+
     /*!
      * FIXME
      */
     std::unique_ptr<SshClient> mShell;
 
+    /*!
+     * The queue of the pending pushes.
+     */
+    std::unique_ptr<PushQueue> mPushQueue;
+
     /*!
      * The current repository.
      */
@@ -362,10 +734,41 @@ protected:
      */
     std::unique_ptr<Encrypter> mEncrypter;
 
+    /*!
+     * An unwrapped access key.
+     */
+    struct UnlockedKey
+    {
+        /*!
+         * The wrapped access key (as stored in the keyring configuration).
+         */
+        Buffer wrapped;
+
+        /*!
+         * The encrypter holding the unwrapped access key.
+         */
+        std::unique_ptr<Encrypter> encrypter;
+    };
+
+    /*!
+     * The access keys unwrapped during the session (by repository).
+     */
+    std::map<Buffer, UnlockedKey> mUnlockedKeys;
+
+    /*!
+     * The mutex of the unwrapped access keys.
+     */
+    std::mutex mUnlockedKeysMutex;
+
     /*!
      * FIXME
      */
     std::unique_ptr<KeyringNode> mKeyringNode;
+
+    /*!
+     * The local catalog (loaded on demand).
+     */
+    std::unique_ptr<Catalog> mCatalog;
 };
 
 } // End of main namespace
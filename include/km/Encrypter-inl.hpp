@@ -13,10 +13,48 @@
 
 namespace km { // Begin main namespace
 
+template <class T>
+PropertyNode
+Encrypter::decryptProperty(const PropertyContainer<T> &input, const Buffer &name) const
+{
+    const PropertyNode *output = nullptr;
+
+    input.eachProperty([this, &name, &output](const Buffer &key, const PropertyNode &property) {
+
+        if (!output && decryptName(property) == name) {
+            output = &property;
+        }
+    });
+
+    if (!output) {
+        throw PropertyNotFoundException("Property '%1%' does not exist", name);
+    }
+
+    return decrypt<PropertyNode>(*output);
+}
+
 template <class T>
 Buffer
 Encrypter::getFingerprint(const T &key)
 {
+    if (!key.mFingerprint.empty()) {
+        return key.mFingerprint;
+    }
+
+    Buffer fingerprint(KEY_FINGERPRINT_LENGTH);
+
+    if (key.mPkey) {
+
+        // NOTE: the encoding names the algorithm (and the curve)
+        auto publicKey = getPublicKeyInfo(key.mPkey.get());
+
+        if (!EVP_Digest(publicKey.data(), publicKey.size(), fingerprint.data(), NULL, EVP_sha256(), NULL)) {
+            throw Exception("Failed to generate fingerprint");
+        }
+
+        return fingerprint;
+    }
+
     const BIGNUM *n;
     const BIGNUM *e;
 
@@ -30,8 +68,6 @@ Encrypter::getFingerprint(const T &key)
     BN_bn2bin(n, buffer.data());
     BN_bn2bin(e, buffer.data() + nLenght);
 
-    Buffer fingerprint(KEY_FINGERPRINT_LENGTH);
-
     if (!EVP_Digest(buffer.data(), buffer.size(), fingerprint.data(), NULL, EVP_sha256(), NULL)) {
         throw Exception("Failed to generate fingerprint");
     }
@@ -39,6 +75,18 @@ Encrypter::getFingerprint(const T &key)
     return fingerprint;
 }
 
+inline std::size_t
+Encrypter::getPaddingSize()
+{
+    return mPaddingSize;
+}
+
+inline const AccessKey &
+Encrypter::getAccessKey() const
+{
+    return mAccessKey;
+}
+
 } // End of main namespace
 
 #endif /* __KM_ENCRYPTER_INL_HPP__ */
@@ -25,9 +25,17 @@
 
 #include <memory>
 #include <algorithm>
+#include <vector>
+#include <map>
 
 #include <openssl/aes.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
 #include <openssl/err.h>
+#include <openssl/x509.h>
+#include <openssl/hmac.h>
+
+#include <zlib.h>
 
 using namespace boost;
 
@@ -53,10 +61,17 @@ public:
 
         KEY_FINGERPRINT_LENGTH = 32,
 
-        TEXT_NODE_SIZE         = 1024,
-        PROPERTY_NODE_SIZE     = 128,
+        X25519_KEY_LENGTH      = 32,
+        WRAP_NONCE_LENGTH      = 12,             // 96 bit
+        WRAP_TAG_LENGTH        = 16,             // 128 bit
+
+        COMPRESSION_THRESHOLD  = 512,            // smallest compressed value
+        COMPRESSION_LIMIT      = 16777216,       // largest compressed value (16 MiB)
+        COMPRESSION_LEVEL      = Z_BEST_COMPRESSION,
 
-        PADDING_DIVISOR        = '\7'
+        PADDING_SIZE           = 32,             // smallest size class
+        PADDING_MARKER         = 0x80,
+        PADDING_DIVISOR        = '\7'            // legacy (fixed size) padding
     };
 
     /*!
@@ -91,6 +106,27 @@ public:
     template <class T>
     static Buffer getFingerprint(const T &key);
 
+    /*!
+     * Returns the recipient of the access keys wrapped for a group.
+     *
+     * @param[in] groupId The group ID.
+     *
+     * @return The fingerprint.
+     */
+    static Buffer getGroupFingerprint(const Buffer &groupId);
+
+    /*!
+     * Sets the smallest size class of the padding (`security.padding_size`).
+     *
+     * @param[in] size A power of two, not smaller than a cipher block.
+     */
+    static void setPaddingSize(std::size_t size);
+
+    /*!
+     * Returns the smallest size class of the padding.
+     */
+    static std::size_t getPaddingSize();
+
     /*!
      * Creates a new encrypter.
      *
@@ -101,6 +137,16 @@ public:
      */
     static Encrypter create(const AccessKey &accessKey, const PrivateKey &privateKey);
 
+    /*!
+     * Creates a new encrypter from an access key wrapped for a group.
+     *
+     * @param[in] accessKey      The access key.
+     * @param[in] groupEncrypter The encrypter of the group.
+     *
+     * @return The encrypter.
+     */
+    static Encrypter create(const AccessKey &accessKey, const Encrypter &groupEncrypter);
+
     /*!
      * Destructor method.
      */
@@ -126,6 +172,17 @@ public:
      */
     Buffer decrypt(const Buffer &input, const Buffer &iv) const;
 
+    /*!
+     * Decrypts data encrypted by a previous version of the access key.
+     *
+     * @param[in] input   The data to decrypt.
+     * @param[in] iv      The initialization vector.
+     * @param[in] version The version of the access key.
+     *
+     * @return The decrypted data.
+     */
+    Buffer decrypt(const Buffer &input, const Buffer &iv, unsigned int version) const;
+
     /*!
      * Encrypts data.
      *
@@ -146,6 +203,93 @@ public:
     template <class T>
     T decrypt(const T &data) const;
 
+    /*!
+     * Decrypts the name of a property.
+     *
+     * @param[in] input The encrypted property.
+     *
+     * @return The property name.
+     */
+    Buffer decryptName(const PropertyNode &input) const;
+
+    /*!
+     * Decrypts a single property of a node, decrypting only the names of
+     * the others (the encrypted nodes are keyed by the encrypted names).
+     *
+     * @param[in] input The encrypted node.
+     * @param[in] name  The property name.
+     *
+     * @return The decrypted property.
+     */
+    template <class T>
+    PropertyNode decryptProperty(const PropertyContainer<T> &input, const Buffer &name) const;
+
+    /*!
+     * Encrypts a new version of an entry, keeping the ciphertext of the
+     * properties that haven't changed (so that the entry file changes only
+     * by the modified properties).
+     *
+     * @param[in] input    The entry to encrypt.
+     * @param[in] previous The previous version of the entry (encrypted).
+     *
+     * @return The encrypted entry.
+     */
+    EntryNode reencrypt(const EntryNode &input, const EntryNode &previous) const;
+
+    /*!
+     * Returns the (unwrapped) access key.
+     */
+    const AccessKey &getAccessKey() const;
+
+    /*!
+     * Returns a keyed digest of data (HMAC-SHA256 under a key derived
+     * from the access key).
+     *
+     * @param[in] input   The data.
+     * @param[in] version The version of the access key.
+     *
+     * @return The digest.
+     */
+    Buffer getDigest(const Buffer &input, unsigned int version) const;
+
+    /*!
+     * Seals the root of an integrity tree with the current access key.
+     *
+     * @param[in] tree The integrity tree.
+     *
+     * @return The encrypter instance.
+     */
+    const Encrypter &seal(MerkleTree &tree) const;
+
+    /*!
+     * Checks the seal of an integrity tree.
+     *
+     * @param[in] tree The integrity tree.
+     */
+    bool isSealed(const MerkleTree &tree) const;
+
+    /*!
+     * Creates an encrypter with a new random access key, which can still
+     * decrypt the data encrypted by the previous versions of the key.
+     *
+     * @return The encrypter.
+     */
+    Encrypter rotate() const;
+
+    /*!
+     * Loads the previous versions of the access key.
+     *
+     * @param[in] history The previous keys (encrypted by the current key).
+     *
+     * @return The encrypter.
+     */
+    Encrypter &setKeyHistory(const std::vector<PropertyNode> &history);
+
+    /*!
+     * Returns the previous versions of the access key (encrypted by the current key).
+     */
+    std::vector<PropertyNode> getKeyHistory() const;
+
 protected:
 
     /*!
@@ -154,17 +298,109 @@ protected:
     Encrypter();
 
     /*!
-     * Adds padding to an buffer.
+     * Wraps an access key for an X25519 key (ECDH with an ephemeral key,
+     * HKDF-SHA256 and AES-256-GCM).
+     *
+     * @param[in] input     The access key.
+     * @param[in] publicKey The X25519 public key.
+     *
+     * @return The wrapped access key (ephemeral key, nonce, ciphertext and tag).
+     */
+    static AccessKey wrapX25519(const AccessKey &input, const PublicKey &publicKey);
+
+    /*!
+     * Unwraps an access key wrapped for an X25519 key.
+     *
+     * @param[in] input      The wrapped access key.
+     * @param[in] privateKey The X25519 private key.
+     *
+     * @return The access key.
+     */
+    static AccessKey unwrapX25519(const AccessKey &input, const PrivateKey &privateKey);
+
+    /*!
+     * Encrypts an access key with AES-GCM (`nonce || ciphertext || tag`).
+     *
+     * @param[in] key       The wrapping key.
+     * @param[in] recipient The recipient (authenticated).
+     * @param[in] input     The access key data.
+     *
+     * @return The wrapped data.
+     */
+    static Buffer seal(const Buffer &key, const Buffer &recipient, const Buffer &input);
+
+    /*!
+     * Decrypts an access key wrapped by `seal()`.
+     *
+     * @param[in] key       The wrapping key.
+     * @param[in] recipient The recipient (authenticated).
+     * @param[in] input     The wrapped data.
+     *
+     * @return The access key data.
+     */
+    static Buffer open(const Buffer &key, const Buffer &recipient, const Buffer &input);
+
+    /*!
+     * Derives the key wrapping an access key.
+     *
+     * @param[in] ownKey       The own X25519 key.
+     * @param[in] peerKey      The X25519 key of the other party.
+     * @param[in] ephemeralKey The raw ephemeral public key.
+     * @param[in] recipientKey The raw public key of the recipient.
+     *
+     * @return The wrapping key.
+     */
+    static Buffer deriveWrappingKey(EVP_PKEY *ownKey, EVP_PKEY *peerKey, const Buffer &ephemeralKey, const Buffer &recipientKey);
+
+    /*!
+     * Returns the raw public key of an X25519 key.
+     *
+     * @param[in] key The key.
+     */
+    static Buffer getRawPublicKey(EVP_PKEY *key);
+
+    /*!
+     * Returns the DER-encoded SubjectPublicKeyInfo of a key.
+     *
+     * @param[in] key The key.
+     */
+    static Buffer getPublicKeyInfo(EVP_PKEY *key);
+
+    /*!
+     * Compresses a buffer (zlib).
+     *
+     * @param[in] buffer The buffer to compress.
+     *
+     * @return The compressed buffer.
+     */
+    static Buffer compress(const Buffer &buffer);
+
+    /*!
+     * Decompresses a buffer compressed by `compress()`.
+     *
+     * @param[in] buffer The buffer to decompress.
+     *
+     * @return The original buffer.
+     *
+     * @throw Exception if the output exceeds `COMPRESSION_LIMIT`.
+     */
+    static Buffer decompress(const Buffer &buffer);
+
+    /*!
+     * Pads a buffer up to its size class.
+     *
+     * The size classes are the powers of two from `getPaddingSize()`; the
+     * buffer is followed by a marker and by zeros, one byte short of its
+     * class, so that the ciphertext fills it exactly.
      *
      * @param[in] buffer The buffer to which add the padding.
-     * @param[in] size   The final size of the data block.
      *
      * @return The processed buffer.
      */
-    Buffer addPadding(const Buffer &buffer, size_t size) const;
+    Buffer addPadding(const Buffer &buffer) const;
 
     /*!
-     * Removes padding from a buffer.
+     * Removes padding from a buffer (also the legacy, fixed size, one).
      *
      * @param[in] buffer The buffer from which remove the padding.
      *
@@ -172,16 +408,28 @@ protected:
      */
     Buffer removePadding(const Buffer &buffer) const;
 
+    /*!
+     * Returns a version of the access key.
+     *
+     * @param[in] version The key version.
+     */
+    const Buffer &getKey(unsigned int version) const;
+
 
     /*!
-     * The OpenSSL cipher context.
+     * The smallest size class of the padding.
      */
-    std::shared_ptr<EVP_CIPHER_CTX> mCipherContext;
+    static std::size_t mPaddingSize;
 
     /*!
      * The access key.
      */
     AccessKey mAccessKey;
+
+    /*!
+     * The previous versions of the access key.
+     */
+    std::map<unsigned int, Buffer> mKeyHistory;
 };
 
 } // End of main namespace
@@ -0,0 +1,24 @@
+/*!
+ * Title ---- km/IpcChannel-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_IPC_CHANNEL_INL_HPP__
+#define __KM_IPC_CHANNEL_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline IpcChannel::Socket &
+IpcChannel::getSocket()
+{
+    return mSocket;
+}
+
+} // End of main namespace
+
+#endif /* __KM_IPC_CHANNEL_INL_HPP__ */
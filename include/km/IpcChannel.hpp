@@ -0,0 +1,161 @@
+/*!
+ * Title ---- km/IpcChannel.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_IPC_CHANNEL_HPP__
+#define __KM_IPC_CHANNEL_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * A message channel over a Unix socket.
+ *
+ * Every message is a list of buffers, framed with big-endian lengths.
+ */
+class IpcChannel
+{
+
+public:
+
+    /*!
+     * Message limits.
+     */
+    enum {
+
+        MAX_FIELDS     = 64,
+        MAX_FIELD_SIZE = 64 * 1024 * 1024
+    };
+
+    /*!
+     * The message type.
+     */
+    typedef std::vector<Buffer> Message;
+
+    /*!
+     * The socket type.
+     */
+    typedef asio::local::stream_protocol::socket Socket;
+
+    /*!
+     * The clock type.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /*!
+     * Connects to a Unix socket.
+     *
+     * @param[in] path The socket path.
+     *
+     * @return The channel (`nullptr` if nobody is listening).
+     */
+    static std::shared_ptr<IpcChannel> connect(const filesystem::path &path);
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] ioService The I/O service.
+     */
+    explicit IpcChannel(asio::io_service &ioService);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~IpcChannel();
+
+    /*!
+     * Sends a message.
+     *
+     * @param[in] message The message.
+     */
+    void send(const Message &message);
+
+    /*!
+     * Receives a message.
+     *
+     * @return The message.
+     */
+    Message receive();
+
+    /*!
+     * Receives a message, failing if it doesn't arrive in time.
+     *
+     * @param[in] deadline The deadline.
+     *
+     * @return The message.
+     */
+    Message receive(Clock::time_point deadline);
+
+    /*!
+     * Closes the channel.
+     */
+    void close();
+
+    /*!
+     * Returns the underlying socket.
+     */
+    Socket &getSocket();
+
+protected:
+
+    /*!
+     * Writes a length.
+     *
+     * @param[out] output The output buffer.
+     * @param[in]  value  The length.
+     */
+    static void writeLength(Buffer &output, std::uint32_t value);
+
+    /*!
+     * Reads a length.
+     *
+     * @param[in] deadline The deadline.
+     */
+    std::uint32_t readLength(Clock::time_point deadline);
+
+    /*!
+     * Reads a block of data.
+     *
+     * @param[out] data     The output buffer.
+     * @param[in]  size     The size of the block.
+     * @param[in]  deadline The deadline.
+     */
+    void read(std::uint8_t *data, std::size_t size, Clock::time_point deadline);
+
+
+    /*!
+     * The I/O service (owned by client channels only).
+     */
+    std::shared_ptr<asio::io_service> mIoService;
+
+    /*!
+     * The socket.
+     */
+    Socket mSocket;
+};
+
+} // End of main namespace
+
+#endif /* __KM_IPC_CHANNEL_HPP__ */
+
+// Include inline methods
+#include <km/IpcChannel-inl.hpp>
@@ -0,0 +1,18 @@
+/*!
+ * Title ---- km/IpcServer-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_IPC_SERVER_INL_HPP__
+#define __KM_IPC_SERVER_INL_HPP__
+
+namespace km { // Begin main namespace
+
+} // End of main namespace
+
+#endif /* __KM_IPC_SERVER_INL_HPP__ */
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*!
+ * Title ---- km/IpcServer.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_IPC_SERVER_HPP__
+#define __KM_IPC_SERVER_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Console.hpp>
+#include <km/IpcChannel.hpp>
+
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The base class of the local daemons.
+ *
+ * Listens on a Unix socket reachable only by the owner and receives the
+ * messages of every client on a thread of its own.
+ */
+class IpcServer
+{
+
+public:
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] socketPath The path to the socket.
+     */
+    explicit IpcServer(const filesystem::path &socketPath);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~IpcServer();
+
+protected:
+
+    /*!
+     * The client connection type.
+     */
+    typedef std::shared_ptr<IpcChannel> Connection;
+
+    /*!
+     * Handles a message (called on the thread of the client).
+     *
+     * @param[in] connection The client connection.
+     * @param[in] message    The message.
+     */
+    virtual void receive(Connection connection, IpcChannel::Message &message) = 0;
+
+    /*!
+     * Opens the socket and starts accepting the clients.
+     */
+    void listen();
+
+    /*!
+     * Disconnects the clients and closes the socket.
+     *
+     * NOTE: the derived classes must call it before their members are destroyed.
+     */
+    void stop();
+
+    /*!
+     * Accepts the client connections.
+     */
+    void accept();
+
+    /*!
+     * Receives the messages of a client.
+     *
+     * @param[in] connection The client connection.
+     */
+    void serve(Connection connection);
+
+    /*!
+     * Checks that a client runs as the same user.
+     *
+     * @param[in] connection The client connection.
+     */
+    static bool checkPeer(Connection connection);
+
+    /*!
+     * Sends a message to a client.
+     *
+     * @param[in] connection The client connection.
+     * @param[in] message    The message.
+     */
+    static void reply(Connection connection, const IpcChannel::Message &message);
+
+
+    /*!
+     * The path to the socket.
+     */
+    filesystem::path mSocketPath;
+
+    /*!
+     * The I/O service.
+     */
+    asio::io_service mIoService;
+
+    /*!
+     * The socket acceptor.
+     */
+    std::unique_ptr<asio::local::stream_protocol::acceptor> mAcceptor;
+
+    /*!
+     * The acceptor thread.
+     */
+    std::thread mAcceptThread;
+
+    /*!
+     * The open client connections.
+     */
+    std::set<Connection> mConnections;
+
+    /*!
+     * Indicates whether the server is accepting messages.
+     */
+    bool mRunning;
+
+    /*!
+     * The mutex of the server state.
+     */
+    std::mutex mMutex;
+
+    /*!
+     * The condition variable notified on new messages and disconnections.
+     */
+    std::condition_variable mCondition;
+};
+
+} // End of main namespace
+
+#endif /* __KM_IPC_SERVER_HPP__ */
+
+// Include inline methods
+#include <km/IpcServer-inl.hpp>
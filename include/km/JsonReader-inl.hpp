@@ -0,0 +1,24 @@
+/*!
+ * Title ---- km/JsonReader-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_JSON_READER_INL_HPP__
+#define __KM_JSON_READER_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline JsonReader &
+JsonReader::feed(const std::string &data)
+{
+    return feed(data.data(), data.size());
+}
+
+} // End of main namespace
+
+#endif /* __KM_JSON_READER_INL_HPP__ */
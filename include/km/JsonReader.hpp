@@ -0,0 +1,266 @@
+/*!
+ * Title ---- km/JsonReader.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_JSON_READER_HPP__
+#define __KM_JSON_READER_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+
+#include <functional>
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace km { // Begin main namespace
+
+/*!
+ * The incremental JSON reader.
+ *
+ * The input is fed in chunks of any size; every scalar value is reported as
+ * soon as it is complete, together with its path (the object keys and the
+ * array indexes that lead to it). Only the current path and token are kept
+ * in memory.
+ */
+class JsonReader
+{
+
+public:
+
+    /*!
+     * Parser parameters.
+     */
+    enum {
+
+        MAX_DEPTH = 256
+    };
+
+    /*!
+     * The value path.
+     */
+    typedef std::vector<std::string> Path;
+
+    /*!
+     * The value callback.
+     */
+    typedef std::function<void (const Path &path, const std::string &value)> Callback;
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] callback The value callback.
+     */
+    explicit JsonReader(Callback callback);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~JsonReader();
+
+    /*!
+     * Parses a chunk of the input.
+     *
+     * @param[in] data The chunk data.
+     * @param[in] size The chunk size.
+     *
+     * @return The reader instance.
+     */
+    JsonReader &feed(const char *data, std::size_t size);
+
+    /*!
+     * Parses a chunk of the input.
+     *
+     * @param[in] data The chunk.
+     *
+     * @return The reader instance.
+     */
+    JsonReader &feed(const std::string &data);
+
+    /*!
+     * Checks that the input is complete.
+     *
+     * @return The reader instance.
+     */
+    JsonReader &finish();
+
+protected:
+
+    /*!
+     * The expected tokens.
+     */
+    enum Expect {
+
+        EXPECT_VALUE,
+        EXPECT_KEY,
+        EXPECT_COLON,
+        EXPECT_NEXT,
+        EXPECT_END
+    };
+
+    /*!
+     * The token types.
+     */
+    enum Token {
+
+        TOKEN_NONE,
+        TOKEN_STRING,
+        TOKEN_LITERAL
+    };
+
+    /*!
+     * An open object or array.
+     */
+    struct Frame
+    {
+        /*!
+         * Indicates whether the frame is an array.
+         */
+        bool array;
+
+        /*!
+         * The index of the current element.
+         */
+        std::size_t index;
+
+        /*!
+         * Indicates whether the frame has no elements yet.
+         */
+        bool empty;
+    };
+
+    /*!
+     * Parses a character.
+     *
+     * @param[in] c The character.
+     */
+    void parse(char c);
+
+    /*!
+     * Parses a character of a string.
+     *
+     * @param[in] c The character.
+     */
+    void parseString(char c);
+
+    /*!
+     * Opens an object or an array.
+     *
+     * @param[in] array Indicates whether the container is an array.
+     */
+    void beginContainer(bool array);
+
+    /*!
+     * Closes an object or an array.
+     *
+     * @param[in] array Indicates whether the container is an array.
+     */
+    void endContainer(bool array);
+
+    /*!
+     * Completes the current literal.
+     */
+    void endLiteral();
+
+    /*!
+     * Checks the JSON number grammar, `-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?`.
+     *
+     * @param[in] value The literal.
+     */
+    static bool isNumber(const std::string &value);
+
+    /*!
+     * Completes a value.
+     */
+    void endValue();
+
+    /*!
+     * Marks the current frame as not empty.
+     */
+    void markFrame();
+
+    /*!
+     * Appends a code point to the current token.
+     *
+     * @param[in] codePoint The code point.
+     */
+    void appendCodePoint(std::uint32_t codePoint);
+
+    /*!
+     * Throws a parse error.
+     *
+     * @param[in] message The error message.
+     */
+    [[noreturn]] void throwError(const std::string &message) const;
+
+
+    /*!
+     * The value callback.
+     */
+    Callback mCallback;
+
+    /*!
+     * The open objects and arrays.
+     */
+    std::vector<Frame> mFrames;
+
+    /*!
+     * The current path.
+     */
+    Path mPath;
+
+    /*!
+     * The expected token.
+     */
+    Expect mExpect;
+
+    /*!
+     * The current token type.
+     */
+    Token mToken;
+
+    /*!
+     * The current token.
+     */
+    std::string mValue;
+
+    /*!
+     * Indicates whether the current string is an object key.
+     */
+    bool mKey;
+
+    /*!
+     * Indicates whether the next string character is escaped.
+     */
+    bool mEscape;
+
+    /*!
+     * The pending hexadecimal digits of a `\u` escape.
+     */
+    std::string mUnicode;
+
+    /*!
+     * The pending high surrogate of a `\u` escape.
+     */
+    std::uint32_t mSurrogate;
+
+    /*!
+     * The number of parsed characters.
+     */
+    std::size_t mOffset;
+};
+
+} // End of main namespace
+
+#endif /* __KM_JSON_READER_HPP__ */
+
+// Include inline methods
+#include <km/JsonReader-inl.hpp>
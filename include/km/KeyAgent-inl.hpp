@@ -0,0 +1,25 @@
+/*!
+ * Title ---- km/KeyAgent-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_KEY_AGENT_INL_HPP__
+#define __KM_KEY_AGENT_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline KeyAgent &
+KeyAgent::setMemoryLock(bool memoryLock)
+{
+    mMemoryLock = memoryLock;
+    return *this;
+}
+
+} // End of main namespace
+
+#endif /* __KM_KEY_AGENT_INL_HPP__ */
\ No newline at end of file
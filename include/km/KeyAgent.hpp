@@ -0,0 +1,245 @@
+/*!
+ * Title ---- km/KeyAgent.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_KEY_AGENT_HPP__
+#define __KM_KEY_AGENT_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Console.hpp>
+#include <km/Buffer.hpp>
+#include <km/PrivateKey.hpp>
+#include <km/Encrypter.hpp>
+#include <km/KeyringNode.hpp>
+#include <km/EntryNode.hpp>
+#include <km/TextNode.hpp>
+#include <km/MerkleTree.hpp>
+#include <km/Repository.hpp>
+#include <km/PushQueue.hpp>
+#include <km/Catalog.hpp>
+#include <km/IpcChannel.hpp>
+#include <km/IpcServer.hpp>
+
+#include <memory>
+#include <chrono>
+#include <string>
+#include <map>
+
+#include <boost/filesystem.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The key agent.
+ *
+ * Keeps the unlocked private key, the access keys and the parsed keyrings
+ * in memory and answers the requests of the local clients:
+ *
+ *   - `[get, repository, entry]` returns `[ok, name, value, ...]`;
+ *   - `[get, repository, entry, property]` returns `[ok, value]`;
+ *   - `[list, repository]` returns `[ok, lines]` (an `id<TAB>name` line per entry);
+ *   - `[set, repository, entry, property, value]` returns `[ok]`;
+ *   - `[lock]` forgets the keys and stops the agent.
+ *
+ * The entries are referenced by ID or by name; the failures are answered
+ * with `[error, message]`.
+ */
+class KeyAgent : public IpcServer
+{
+
+public:
+
+    /*!
+     * Timing parameters (in seconds).
+     */
+    enum {
+
+        IDLE_TIMEOUT = 900
+    };
+
+    /*!
+     * The socket file.
+     */
+    static const filesystem::path SocketFile;
+
+    /*!
+     * Sends a request to the agent.
+     *
+     * @param[in]  path     The path to the socket.
+     * @param[in]  request  The request.
+     * @param[out] response The response (without the status).
+     *
+     * @return `false` if the agent is not running.
+     */
+    static bool request(const filesystem::path &path, const IpcChannel::Message &request, IpcChannel::Message &response);
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] socketPath  The path to the socket.
+     * @param[in] keyringPath The path to the keyrings.
+     * @param[in] privateKey  The private key.
+     * @param[in] pushQueue   The queue of the repositories to push.
+     */
+    KeyAgent(const filesystem::path &socketPath, const filesystem::path &keyringPath, const PrivateKey &privateKey, PushQueue &pushQueue);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~KeyAgent();
+
+    /*!
+     * Sets whether the agent refuses to run without locked memory (the default).
+     */
+    KeyAgent &setMemoryLock(bool memoryLock);
+
+    /*!
+     * Serves the clients until the agent is locked or left idle.
+     *
+     * @param[in] idleTimeout The time without requests after which the keys are dropped.
+     */
+    KeyAgent &run(std::chrono::seconds idleTimeout = std::chrono::seconds(IDLE_TIMEOUT));
+
+protected:
+
+    /*!
+     * The clock type.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /*!
+     * An unlocked keyring.
+     */
+    struct Keyring
+    {
+        /*!
+         * The repository.
+         */
+        std::unique_ptr<Repository> repository;
+
+        /*!
+         * The keyring.
+         */
+        std::unique_ptr<KeyringNode> node;
+
+        /*!
+         * The encrypter (holding the access key).
+         */
+        std::unique_ptr<Encrypter> encrypter;
+
+        /*!
+         * The state of the keyring files when the keyring has been parsed.
+         */
+        std::string stamp;
+    };
+
+    /*!
+     * Answers a request.
+     *
+     * @param[in] connection The client connection.
+     * @param[in] message    The request.
+     */
+    virtual void receive(Connection connection, IpcChannel::Message &message) override;
+
+    /*!
+     * Executes a request.
+     *
+     * @param[in] request The request.
+     *
+     * @return The response.
+     */
+    IpcChannel::Message handle(const IpcChannel::Message &request);
+
+    /*!
+     * Returns an unlocked keyring, parsing it again if it has changed on disk.
+     *
+     * @param[in] repositoryId The repository ID.
+     */
+    Keyring &getKeyring(const Buffer &repositoryId);
+
+    /*!
+     * Looks up an entry by ID or by name.
+     *
+     * @param[in] keyring   The keyring.
+     * @param[in] reference The entry ID or name.
+     *
+     * @return The decrypted entry.
+     */
+    EntryNode findEntry(Keyring &keyring, const Buffer &reference) const;
+
+    /*!
+     * Updates the catalog after an entry has been written (as the CLI does).
+     *
+     * @param[in] repositoryId The repository ID.
+     * @param[in] keyring      The keyring.
+     * @param[in] entry        The decrypted entry.
+     */
+    void updateCatalog(const Buffer &repositoryId, const Keyring &keyring, const EntryNode &entry) const;
+
+    /*!
+     * Returns the state of the keyring files.
+     *
+     * @param[in] repository The repository.
+     */
+    static std::string getStamp(const Repository &repository);
+
+    /*!
+     * Keeps the process memory out of the core dumps and, unless disabled,
+     * out of the swap.
+     *
+     * @param[in] memoryLock Indicates whether the memory must be locked.
+     */
+    static void lockMemory(bool memoryLock);
+
+
+    /*!
+     * The path to the keyrings.
+     */
+    filesystem::path mKeyringPath;
+
+    /*!
+     * The private key.
+     */
+    PrivateKey mPrivateKey;
+
+    /*!
+     * The queue of the repositories to push.
+     */
+    PushQueue &mPushQueue;
+
+    /*!
+     * The unlocked keyrings.
+     */
+    std::map<Buffer, Keyring> mKeyrings;
+
+    /*!
+     * The time of the last request.
+     */
+    Clock::time_point mLastActivity;
+
+    /*!
+     * Indicates whether the agent has been locked.
+     */
+    bool mLocked;
+
+    /*!
+     * Indicates whether the memory must be locked.
+     */
+    bool mMemoryLock;
+};
+
+} // End of main namespace
+
+#endif /* __KM_KEY_AGENT_HPP__ */
+
+// Include inline methods
+#include <km/KeyAgent-inl.hpp>
@@ -20,16 +20,47 @@ KeyringNode::getId() const
 }
 
 inline KeyringNode &
-KeyringNode::setAccessKeys(const AccessKeyMap &accessKeys)
+KeyringNode::upgrade()
 {
-    mAccessKeys = accessKeys;
+    mLegacy = false;
     return *this;
 }
 
-inline const AccessKeyMap &
-KeyringNode::getAccessKeys() const
+inline bool
+KeyringNode::isLegacy() const
 {
-    return mAccessKeys;
+    return mLegacy;
+}
+
+inline bool
+KeyringNode::hasAccessKey(const Buffer &recipient) const
+{
+    return mRecipients.count(recipient) > 0;
+}
+
+inline const std::set<Buffer> &
+KeyringNode::getRecipients() const
+{
+    return mRecipients;
+}
+
+inline KeyringNode &
+KeyringNode::setKeyHistory(const std::vector<PropertyNode> &history)
+{
+    mKeyHistory = history;
+    return *this;
+}
+
+inline const std::vector<PropertyNode> &
+KeyringNode::getKeyHistory() const
+{
+    return mKeyHistory;
+}
+
+inline bool
+KeyringNode::hasEntry(const Buffer &id) const
+{
+    return mEntries.count(id) > 0;
 }
 
 inline std::size_t
@@ -38,12 +69,10 @@ KeyringNode::getNumberOfEntries() const
     return mEntries.size();
 }
 
-inline KeyringNode &
-KeyringNode::save(const filesystem::path &path)
+inline const MerkleTree &
+KeyringNode::getMerkleTree() const
 {
-    KeyringNode::toPath(path, *this);
-
-    return *this;
+    return mMerkleTree;
 }
 
 } // End of main namespace
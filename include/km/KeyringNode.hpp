@@ -17,13 +17,16 @@
 #include <km/AccessKey.hpp>
 #include <km/PropertyContainer.hpp>
 #include <km/EntryNode.hpp>
+#include <km/MerkleTree.hpp>
 
 #include <algorithm>
 #include <vector>
+#include <set>
 #include <map>
 
 #include <boost/format.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
@@ -31,6 +34,8 @@ using namespace boost;
 
 namespace km { // Begin main namespace
 
+class Encrypter;
+
 /*!
  * The access key map.
  */
@@ -38,6 +43,11 @@ typedef std::map<Buffer, AccessKey> AccessKeyMap;
 
 /*!
  * The keyring.
+ *
+ * The access keys are stored one per file, in `access/<fingerprint>`, and
+ * listed by `access/manifest`; only the ones requested are parsed. The
+ * keyrings storing them in `keymaker.xml` are still read, and converted
+ * by `upgrade()`.
  */
 class KeyringNode : public PropertyContainer<KeyringNode>
 {
@@ -54,6 +64,16 @@ public:
      */
     static const filesystem::path EntryDir;
 
+    /*!
+     * The access keys directory path.
+     */
+    static const filesystem::path AccessDir;
+
+    /*!
+     * The manifest of the access keys (inside the access keys directory).
+     */
+    static const filesystem::path ManifestFile;
+
     /*!
      * Creates a keyring node.
      *
@@ -97,21 +117,70 @@ public:
      */
     const Buffer &getId() const;
 
+    /*!
+     * Reloads the properties and the access keys from the configuration file.
+     *
+     * @return The keyring instance.
+     */
+    KeyringNode &reloadConfig();
+
+    /*!
+     * Stores the access keys in their own files from the next save.
+     *
+     * @return The keyring instance.
+     */
+    KeyringNode &upgrade();
+
+    /*!
+     * Indicates whether the access keys are still stored in `keymaker.xml`.
+     */
+    bool isLegacy() const;
+
     /*!
      * TODO
      */
     KeyringNode &addAccessKey(const AccessKey &accessKey);
 
+    /*!
+     * Indicates whether the keyring has an access key for a recipient.
+     *
+     * @param[in] recipient The recipient fingerprint.
+     */
+    bool hasAccessKey(const Buffer &recipient) const;
+
     /*!
      * Returns the access key associated with a specified recipient.
-     * TODO
+     *
+     * The access key file is read on the first request.
      */
 	const AccessKey &getAccessKey(const Buffer &recipient) const;
 
+    /*!
+     * Returns the recipients of the access keys.
+     */
+    const std::set<Buffer> &getRecipients() const;
+
     // FIXME
     KeyringNode &setAccessKeys(const AccessKeyMap &accessKeys);
+
+    /*!
+     * Returns all the access keys (reading the missing files).
+     */
     const AccessKeyMap &getAccessKeys() const;
 
+    /*!
+     * Sets the previous versions of the access key.
+     *
+     * @param[in] history The previous keys (encrypted by the current key).
+     *
+     * @return The keyring instance.
+     */
+    KeyringNode &setKeyHistory(const std::vector<PropertyNode> &history);
+
+    /*!
+     * Returns the previous versions of the access key.
+     */
+    const std::vector<PropertyNode> &getKeyHistory() const;
 
     /*!
      * Sets an entry into the keyring.
@@ -122,6 +191,24 @@ public:
      */
     KeyringNode &setEntry(const EntryNode &entry);
 
+    /*!
+     * Reloads an entry from its file.
+     *
+     * @param[in] id The entry ID.
+     *
+     * @return The keyring instance.
+     */
+    KeyringNode &reloadEntry(const Buffer &id);
+
+    /*!
+     * Removes an entry from the keyring.
+     *
+     * @param[in] id The entry ID.
+     *
+     * @return The keyring instance.
+     */
+    KeyringNode &removeEntry(const Buffer &id);
+
     /*!
      * Returns an entry associated with the keyring.
      *
@@ -131,6 +218,13 @@ public:
      */
 	const EntryNode &getEntry(const Buffer &id) const;
 
+    /*!
+     * Indicates whether the keyring has an entry.
+     *
+     * @param[in] id The entry ID.
+     */
+    bool hasEntry(const Buffer &id) const;
+
     /*!
      * Iterates over the entries in the current keyring.
      *
@@ -148,11 +242,33 @@ public:
     // FIXME
     std::size_t getNumberOfEntries() const;
 
+    /*!
+     * Returns the integrity tree of the entries.
+     */
+    const MerkleTree &getMerkleTree() const;
+
     // FIXME
     KeyringNode &save(const filesystem::path &path);
 
+    /*!
+     * Saves the keyring, sealing its integrity tree with the access key.
+     *
+     * @param[in] path      The keyring path.
+     * @param[in] encrypter The encrypter of the keyring.
+     *
+     * @return The keyring instance.
+     */
+    KeyringNode &save(const filesystem::path &path, const Encrypter &encrypter);
+
 protected:
 
+    /*!
+     * Updates the integrity tree along the entries modified since the last save.
+     *
+     * @param[in] path The keyring path.
+     */
+    void updateMerkleTree(const filesystem::path &path);
+
     /*!
      * Constructor method.
      */
@@ -175,14 +291,46 @@ protected:
     PropertyMap mProperties;
 
     /*!
-     * The access keys.
+     * Reads the file of an access key.
+     *
+     * @param[in] recipient The recipient fingerprint.
+     */
+    const AccessKey &loadAccessKey(const Buffer &recipient) const;
+
+    /*!
+     * The access keys read so far.
+     */
+    mutable AccessKeyMap mAccessKeys;
+
+    /*!
+     * The recipients of the access keys.
      */
-    AccessKeyMap mAccessKeys;
+    std::set<Buffer> mRecipients;
+
+    /*!
+     * Indicates whether the access keys are stored in `keymaker.xml`.
+     */
+    bool mLegacy;
+
+    /*!
+     * The previous versions of the access key.
+     */
+    std::vector<PropertyNode> mKeyHistory;
 
     /*!
      * The keyring entries.
      */
     std::map<Buffer, EntryNode> mEntries;
+
+    /*!
+     * The entries modified since the last save.
+     */
+    std::set<Buffer> mModifiedEntries;
+
+    /*!
+     * The integrity tree of the entries.
+     */
+    MerkleTree mMerkleTree;
 };
 
 } // End of main namespace
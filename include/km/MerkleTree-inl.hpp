@@ -0,0 +1,57 @@
+/*!
+ * Title ---- km/MerkleTree-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_MERKLE_TREE_INL_HPP__
+#define __KM_MERKLE_TREE_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline bool
+MerkleTree::hasLeaf(const Buffer &id) const
+{
+    return mLeaves.find(id) != mLeaves.end();
+}
+
+inline std::size_t
+MerkleTree::size() const
+{
+    return mLeaves.size();
+}
+
+inline const Buffer &
+MerkleTree::getRoot() const
+{
+    return getNode("");
+}
+
+inline MerkleTree &
+MerkleTree::setSeal(const Buffer &seal, unsigned int version)
+{
+    mSeal        = seal;
+    mSealVersion = version;
+
+    return *this;
+}
+
+inline const Buffer &
+MerkleTree::getSeal() const
+{
+    return mSeal;
+}
+
+inline unsigned int
+MerkleTree::getSealVersion() const
+{
+    return mSealVersion;
+}
+
+} // End of main namespace
+
+#endif /* __KM_MERKLE_TREE_INL_HPP__ */
@@ -0,0 +1,289 @@
+/*!
+ * Title ---- km/MerkleTree.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_MERKLE_TREE_HPP__
+#define __KM_MERKLE_TREE_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <openssl/evp.h>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The integrity tree of the keyring entries.
+ *
+ * The leaves are the hashes of the entry files; they are grouped in buckets
+ * by the first digits of the hashed entry ID, so that every inner node
+ * covers a fixed slice of the ID space and two trees can be compared
+ * subtree by subtree.
+ *
+ * The hashes are plain SHA-256, so the root is authenticated by a seal (a
+ * digest keyed by the access key) stored next to it in the tree file.
+ */
+class MerkleTree
+{
+
+public:
+
+    /*!
+     * Tree parameters.
+     */
+    enum {
+
+        HASH_LENGTH = 32,
+        TREE_FANOUT = 16,
+        TREE_DEPTH  = 4
+    };
+
+    /*!
+     * The tree file.
+     */
+    static const filesystem::path TreeFile;
+
+    /*!
+     * Creates an empty tree.
+     *
+     * @return The tree.
+     */
+    static MerkleTree create();
+
+    /*!
+     * Builds a tree from a buffer.
+     *
+     * @param[in] data The serialized tree.
+     *
+     * @return The tree.
+     */
+    static MerkleTree fromBuffer(const Buffer &data);
+
+    /*!
+     * Converts a tree into a buffer.
+     *
+     * @param[in] tree The tree.
+     *
+     * @return The serialized tree.
+     */
+    static Buffer toBuffer(const MerkleTree &tree);
+
+    /*!
+     * Builds a tree from a file.
+     *
+     * @param[in] path The file path.
+     *
+     * @return The tree.
+     */
+    static MerkleTree fromFile(const filesystem::path &path);
+
+    /*!
+     * Stores a tree into a file.
+     *
+     * @param[in] path The file path.
+     * @param[in] tree The tree.
+     */
+    static void toFile(const filesystem::path &path, const MerkleTree &tree);
+
+    /*!
+     * Computes the hash of a buffer.
+     *
+     * @param[in] data The data buffer.
+     *
+     * @return The hash.
+     */
+    static Buffer hash(const Buffer &data);
+
+    /*!
+     * Computes the hash of a file.
+     *
+     * @param[in] path The file path.
+     *
+     * @return The hash.
+     */
+    static Buffer hashFile(const filesystem::path &path);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~MerkleTree();
+
+    /*!
+     * Sets the hash of an entry.
+     *
+     * @param[in] id   The entry ID.
+     * @param[in] hash The hash of the entry file.
+     *
+     * @return The tree instance.
+     */
+    MerkleTree &setLeaf(const Buffer &id, const Buffer &hash);
+
+    /*!
+     * Removes an entry from the tree.
+     *
+     * @param[in] id The entry ID.
+     *
+     * @return The tree instance.
+     */
+    MerkleTree &removeLeaf(const Buffer &id);
+
+    /*!
+     * Checks if the tree contains an entry.
+     *
+     * @param[in] id The entry ID.
+     */
+    bool hasLeaf(const Buffer &id) const;
+
+    /*!
+     * Returns the hash of an entry.
+     *
+     * @param[in] id The entry ID.
+     */
+    const Buffer &getLeaf(const Buffer &id) const;
+
+    /*!
+     * Iterates over the entries in the tree.
+     *
+     * @param[in] callback The callback function.
+     *
+     * @return The tree instance.
+     */
+    const MerkleTree &eachLeaf(std::function<void (const Buffer &id, const Buffer &hash)> callback) const;
+
+    /*!
+     * Returns the number of entries.
+     */
+    std::size_t size() const;
+
+    /*!
+     * Returns the root hash (empty if the tree is empty).
+     */
+    const Buffer &getRoot() const;
+
+    /*!
+     * Returns the entries that differ from another tree.
+     *
+     * @param[in] other The other tree.
+     *
+     * @return The IDs of the added, removed or modified entries.
+     */
+    std::vector<Buffer> diff(const MerkleTree &other) const;
+
+    /*!
+     * Sets the seal of the root hash.
+     *
+     * @param[in] seal    The keyed digest of the root hash.
+     * @param[in] version The version of the access key.
+     *
+     * @return The tree instance.
+     */
+    MerkleTree &setSeal(const Buffer &seal, unsigned int version);
+
+    /*!
+     * Returns the seal of the root hash (empty if the tree changed since sealed).
+     */
+    const Buffer &getSeal() const;
+
+    /*!
+     * Returns the version of the access key of the seal.
+     */
+    unsigned int getSealVersion() const;
+
+    /*!
+     * Checks the entry files against the tree.
+     *
+     * @param[in] path         The entries directory path.
+     * @param[in] numOfThreads The number of threads.
+     *
+     * @return The IDs of the missing, unknown or altered entries.
+     */
+    std::vector<Buffer> verify(const filesystem::path &path, unsigned int numOfThreads) const;
+
+protected:
+
+    /*!
+     * Constructor method.
+     */
+    MerkleTree();
+
+    /*!
+     * Returns the bucket of an entry.
+     *
+     * @param[in] id The entry ID.
+     */
+    static std::string getBucket(const Buffer &id);
+
+    /*!
+     * Returns the hash of a node.
+     *
+     * @param[in] prefix The node prefix.
+     */
+    const Buffer &getNode(const std::string &prefix) const;
+
+    /*!
+     * Invalidates the cached hashes along the path to a bucket.
+     *
+     * @param[in] bucket The bucket.
+     */
+    void invalidate(const std::string &bucket);
+
+    /*!
+     * Collects the entries that differ from another tree under a node.
+     *
+     * @param[in]  other  The other tree.
+     * @param[in]  prefix The node prefix.
+     * @param[out] output The entry IDs.
+     */
+    void diff(const MerkleTree &other, const std::string &prefix, std::vector<Buffer> &output) const;
+
+
+    /*!
+     * The entry hashes.
+     */
+    std::map<Buffer, Buffer> mLeaves;
+
+    /*!
+     * The entries grouped by bucket.
+     */
+    std::map<std::string, std::set<Buffer>> mBuckets;
+
+    /*!
+     * The cached node hashes.
+     */
+    mutable std::map<std::string, Buffer> mNodes;
+
+    /*!
+     * The seal of the root hash.
+     */
+    Buffer mSeal;
+
+    /*!
+     * The version of the access key of the seal.
+     */
+    unsigned int mSealVersion;
+};
+
+} // End of main namespace
+
+#endif /* __KM_MERKLE_TREE_HPP__ */
+
+// Include inline methods
+#include <km/MerkleTree-inl.hpp>
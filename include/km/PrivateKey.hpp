@@ -71,10 +71,14 @@ public:
 	virtual ~PrivateKey();
 
     /*!
-     * Returns the PKCS#1 private key.
+     * Returns the PKCS#1 private key (PKCS#8 for the X25519 keys).
      */
     Buffer getPkcsKey() const;
 
+    using RsaKey::Algorithm;
+    using RsaKey::getAlgorithm;
+    using RsaKey::canWrap;
+
 protected:
 
 	/*!
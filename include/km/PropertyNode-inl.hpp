@@ -52,6 +52,45 @@ PropertyNode::getNonce() const
     return mNonce;
 }
 
+inline PropertyNode &
+PropertyNode::setKeyVersion(unsigned int version)
+{
+    mKeyVersion = version;
+    return *this;
+}
+
+inline unsigned int
+PropertyNode::getKeyVersion() const
+{
+    return mKeyVersion;
+}
+
+inline PropertyNode &
+PropertyNode::setCompressed(bool compressed)
+{
+    mCompressed = compressed;
+    return *this;
+}
+
+inline bool
+PropertyNode::isCompressed() const
+{
+    return mCompressed;
+}
+
+inline PropertyNode &
+PropertyNode::setAttachment(bool attachment)
+{
+    mAttachment = attachment;
+    return *this;
+}
+
+inline bool
+PropertyNode::isAttachment() const
+{
+    return mAttachment;
+}
+
 } // End of main namespace
 
 #endif /* __KM_PROPERTY_NODE_INL_HPP__ */
\ No newline at end of file
@@ -112,6 +112,36 @@ public:
      */
 	const Buffer &getNonce() const;
 
+    /*!
+     * Sets the version of the access key which encrypted the node.
+     */
+    PropertyNode &setKeyVersion(unsigned int version);
+
+    /*!
+     * Returns the version of the access key which encrypted the node.
+     */
+    unsigned int getKeyVersion() const;
+
+    /*!
+     * Sets whether the content has been compressed (by zlib) before the encryption.
+     */
+    PropertyNode &setCompressed(bool compressed);
+
+    /*!
+     * Indicates whether the content has been compressed before the encryption.
+     */
+    bool isCompressed() const;
+
+    /*!
+     * Sets whether the content is the manifest of an attachment (see `ChunkStore`).
+     */
+    PropertyNode &setAttachment(bool attachment);
+
+    /*!
+     * Indicates whether the content is the manifest of an attachment.
+     */
+    bool isAttachment() const;
+
 protected:
 
 	/*!
@@ -134,6 +164,21 @@ protected:
      * The nonce.
      */
 	Buffer mNonce;
+
+    /*!
+     * The version of the access key.
+     */
+    unsigned int mKeyVersion;
+
+    /*!
+     * Indicates whether the content is compressed.
+     */
+    bool mCompressed;
+
+    /*!
+     * Indicates whether the content is an attachment manifest.
+     */
+    bool mAttachment;
 };
 
 } // End of main namespace
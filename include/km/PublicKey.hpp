@@ -77,10 +77,14 @@ public:
 	virtual ~PublicKey();
 
     /*!
-     * Returns the PKCS#1 public key.
+     * Returns the PKCS#1 public key (SubjectPublicKeyInfo for the X25519 keys).
      */
     Buffer getPkcsKey() const;
 
+    using RsaKey::Algorithm;
+    using RsaKey::getAlgorithm;
+    using RsaKey::canWrap;
+
 protected:
 
     /*!
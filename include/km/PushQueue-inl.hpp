@@ -0,0 +1,32 @@
+/*!
+ * Title ---- km/PushQueue-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_PUSH_QUEUE_INL_HPP__
+#define __KM_PUSH_QUEUE_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline std::size_t
+PushQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPending.size();
+}
+
+inline std::map<Buffer, std::string>
+PushQueue::getFailures() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFailures;
+}
+
+} // End of main namespace
+
+#endif /* __KM_PUSH_QUEUE_INL_HPP__ */
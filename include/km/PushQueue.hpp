@@ -0,0 +1,262 @@
+/*!
+ * Title ---- km/PushQueue.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_PUSH_QUEUE_HPP__
+#define __KM_PUSH_QUEUE_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Console.hpp>
+#include <km/Buffer.hpp>
+#include <km/PrivateKey.hpp>
+#include <km/Repository.hpp>
+#include <km/SshClient.hpp>
+
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The background queue of the repositories to push.
+ */
+class PushQueue
+{
+
+public:
+
+    /*!
+     * Retry parameters (in seconds).
+     */
+    enum {
+
+        RETRY_MIN_DELAY = 2,
+        RETRY_MAX_DELAY = 600
+    };
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] statePath       The path to the queue state.
+     * @param[in] repositoryPaths The paths to the repositories (e.g. the keyrings and the groups).
+     */
+    PushQueue(const filesystem::path &statePath, const std::vector<filesystem::path> &repositoryPaths);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~PushQueue();
+
+    /*!
+     * Starts the background worker.
+     *
+     * @param[in] privateKey The private key.
+     */
+    PushQueue &start(const PrivateKey &privateKey);
+
+    /*!
+     * Stops the background worker (the pending pushes are kept on disk).
+     */
+    PushQueue &stop();
+
+    /*!
+     * Schedules a push of a repository.
+     *
+     * @param[in] repositoryId The repository ID.
+     */
+    PushQueue &enqueue(const Buffer &repositoryId);
+
+    /*!
+     * Cancels the pending push of a repository (e.g. a destroyed one).
+     *
+     * @param[in] repositoryId The repository ID.
+     */
+    PushQueue &dequeue(const Buffer &repositoryId);
+
+    /*!
+     * Waits until the pushes scheduled since the last flush are completed
+     * (the ones left by the previous runs are retried in background).
+     */
+    PushQueue &flush();
+
+    /*!
+     * Returns the number of pending pushes.
+     */
+    std::size_t size() const;
+
+    /*!
+     * Returns the pushes rejected by the remote, with their errors (kept
+     * until the repository is scheduled again).
+     */
+    std::map<Buffer, std::string> getFailures() const;
+
+protected:
+
+    /*!
+     * The clock type.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /*!
+     * The retry state of a push.
+     */
+    struct Retry
+    {
+        /*!
+         * The number of failed attempts.
+         */
+        unsigned int attempts = 0;
+
+        /*!
+         * The time of the next attempt.
+         */
+        Clock::time_point next;
+    };
+
+    /*!
+     * Indicates whether a push error won't go away by retrying
+     * (e.g. a rejected non-fast-forward update or a deleted repository).
+     *
+     * NOTE: the transport errors (resolve, connect, timeouts) are always retried.
+     *
+     * @param[in] error The Git error code.
+     */
+    static bool isPermanentFailure(int error);
+
+    /*!
+     * Returns the path to a local repository (empty if it doesn't exist).
+     *
+     * @param[in] repositoryId The repository ID.
+     */
+    filesystem::path getRepositoryPath(const Buffer &repositoryId) const;
+
+    /*!
+     * Runs the background worker.
+     */
+    void run();
+
+    /*!
+     * Pushes a repository.
+     *
+     * @param[in] repositoryId The repository ID.
+     */
+    virtual void push(const Buffer &repositoryId);
+
+    /*!
+     * Loads the queue state.
+     */
+    void load();
+
+    /*!
+     * Stores the queue state.
+     */
+    void store() const;
+
+
+    /*!
+     * The path to the queue state.
+     */
+    filesystem::path mStatePath;
+
+    /*!
+     * The paths to the repositories.
+     */
+    std::vector<filesystem::path> mRepositoryPaths;
+
+    /*!
+     * The private key.
+     */
+    PrivateKey mPrivateKey;
+
+    /*!
+     * The pending repositories (one push covers all their local commits).
+     */
+    std::set<Buffer> mPending;
+
+    /*!
+     * The retry states.
+     */
+    std::map<Buffer, Retry> mRetries;
+
+    /*!
+     * The pushes rejected by the remote.
+     */
+    std::map<Buffer, std::string> mFailures;
+
+    /*!
+     * The repository being pushed.
+     */
+    Buffer mActive;
+
+    /*!
+     * Indicates whether the active repository has been committed again during the push.
+     */
+    bool mActiveChanged;
+
+    /*!
+     * The repositories scheduled since the last flush.
+     */
+    std::set<Buffer> mFlushIds;
+
+    /*!
+     * The last push errors of the repositories scheduled since the last flush.
+     */
+    std::map<Buffer, std::string> mErrors;
+
+    /*!
+     * Indicates whether a caller is waiting for the queue to drain.
+     */
+    bool mFlushing;
+
+    /*!
+     * Indicates whether the background worker is running.
+     */
+    bool mRunning;
+
+    /*!
+     * The queue mutex.
+     */
+    mutable std::mutex mMutex;
+
+    /*!
+     * The queue condition.
+     */
+    std::condition_variable mCondition;
+
+    /*!
+     * The background worker.
+     */
+    std::thread mWorker;
+
+    /*!
+     * The SSH session of the background worker (shared by its pushes).
+     */
+    std::unique_ptr<SshClient> mShell;
+};
+
+} // End of main namespace
+
+#endif /* __KM_PUSH_QUEUE_HPP__ */
+
+// Include inline methods
+#include <km/PushQueue-inl.hpp>
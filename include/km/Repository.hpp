@@ -17,6 +17,7 @@
 #include <km/Buffer.hpp>
 #include <km/PrivateKey.hpp>
 #include <km/Commit.hpp>
+#include <km/SshClient.hpp>
 
 #include <memory>
 #include <functional>
@@ -24,6 +25,7 @@
 #include <vector>
 #include <map>
 #include <fstream>
+#include <ctime>
 
 #include <git2.h>
 
@@ -32,11 +34,54 @@
 
 #define GIT_ADDRESS  "keymaker.io"
 #define GIT_USERNAME "km"
+#define GIT_PORT     "22"
 
 using namespace boost;
 
 namespace km { // Begin main namespace
 
+/*!
+ * The exception of a Git operation.
+ */
+class GitException : public Exception
+{
+
+public:
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] code    The error code (e.g. `GIT_ENONFASTFORWARD`).
+     * @param[in] klass   The error class (e.g. `GITERR_NET`).
+     * @param[in] message The error message.
+     */
+    GitException(int code, int klass, const std::string &message) : Exception(
+        "Repository error: %1%, %2%", klass, message
+    ), mCode(code), mClass(klass) { }
+
+    /*!
+     * Returns the error code.
+     */
+    int getCode() const { return mCode; }
+
+    /*!
+     * Returns the error class.
+     */
+    int getClass() const { return mClass; }
+
+protected:
+
+    /*!
+     * The error code.
+     */
+    int mCode;
+
+    /*!
+     * The error class.
+     */
+    int mClass;
+};
+
 /*!
  * The repository.
  */
@@ -45,6 +90,16 @@ class Repository
 
 public:
 
+    /*!
+     * The types of file change.
+     */
+    enum ChangeType {
+
+        CHANGE_ADDED,
+        CHANGE_MODIFIED,
+        CHANGE_DELETED
+    };
+
     /*!
      * Creates a new repository.
      *
@@ -73,10 +128,11 @@ public:
      * @param[in] id         The repository ID.
      * @param[in] path       The repository path.
      * @param[in] privateKey The private key.
+     * @param[in] shell      The authenticated SSH session to reuse (optional).
      *
      * @return The repository.
      */
-    static Repository fromRemote(const Buffer &id, const filesystem::path &path, const PrivateKey &privateKey);
+    static Repository fromRemote(const Buffer &id, const filesystem::path &path, const PrivateKey &privateKey, SshClient *shell = nullptr);
 
     /*!
      * Checks if a repository exists.
@@ -92,6 +148,15 @@ public:
      */
 	virtual ~Repository();
 
+    /*!
+     * Attaches an authenticated SSH session to carry the Git traffic.
+     *
+     * @param[in] shell The SSH client (not owned, `nullptr` to detach).
+     *
+     * @return The repository instance.
+     */
+    Repository &attach(SshClient *shell);
+
     /*!
      * Returns the repository ID.
      */
@@ -102,6 +167,18 @@ public:
      */
     filesystem::path getPath() const;
 
+    /*!
+     * Returns the hash of the current head.
+     */
+    Buffer getHead() const;
+
+    /*!
+     * Moves the current head to a commit.
+     *
+     * @param[in] hash The commit hash.
+     */
+    Repository &setHead(const Buffer &hash);
+
     /*!
      * Adds a file to the index.
      *
@@ -130,8 +207,18 @@ public:
      */
     Repository &commit(const Buffer &message);
 
+    /*!
+     * Points the repository to another remote.
+     *
+     * @param[in] url The remote URL.
+     */
+    Repository &setRemoteUrl(const std::string &url);
+
     /*!
      * Fetches the changes.
+     *
+     * A remote history rewritten by a compaction replaces the local one,
+     * unless the local side has commits not pushed yet.
      */
     Repository &fetch();
 
@@ -140,6 +227,42 @@ public:
      */
     Repository &push();
 
+    /*!
+     * Pushes the changes by replacing the remote history (force-with-lease).
+     *
+     * @param[in] lease The hash that the remote head is expected to have.
+     */
+    Repository &forcePush(const Buffer &lease);
+
+    /*!
+     * Squashes the commits older than a point in time into a single snapshot commit.
+     *
+     * @param[in] time    The retention limit.
+     * @param[in] message The message of the snapshot commit.
+     *
+     * @return True if the history has been rewritten.
+     */
+    bool compact(std::time_t time, const Buffer &message);
+
+    /*!
+     * Reads a file from a revision.
+     *
+     * @param[in] revision The revision.
+     * @param[in] path     The file path (relative to the repository).
+     *
+     * @return The file content.
+     */
+    Buffer readFile(const Buffer &revision, const filesystem::path &path) const;
+
+    /*!
+     * Iterates over the files changed between two commits.
+     *
+     * @param[in] from     The hash of the old commit.
+     * @param[in] to       The hash of the new commit.
+     * @param[in] callback The callback function.
+     */
+    Repository &eachChange(const Buffer &from, const Buffer &to, std::function<void (const filesystem::path &, ChangeType)> callback);
+
     /*!
      * FIXME.
      */
@@ -152,15 +275,29 @@ public:
 
 protected:
 
+    /*!
+     * The remote-tracking reference of the remote head.
+     */
+    static const std::string TrackingRef;
+
     /*!
      * The acquire credentials callback.
      */
     static int acquireCredentials(git_cred **out, const char *, const char *, unsigned int, void *privateKey);
 
+    /*!
+     * Sets up the remote callbacks.
+     *
+     * @param[out] callbacks The remote callbacks.
+     */
+    void setCallbacks(git_remote_callbacks &callbacks);
+
     /*!
      * Throws a Git exception.
+     *
+     * @param[in] error The error code.
      */
-    static void throwGitException(); // TODO: see BOOST_PROPERTY_TREE_THROW
+    static void throwGitException(int error = GIT_ERROR); // TODO: see BOOST_PROPERTY_TREE_THROW
 
     /*!
      * Constructor method.
@@ -194,6 +331,46 @@ protected:
      */
     Repository &open();
 
+    /*!
+     * Looks up the tree of a commit.
+     *
+     * @param[in] hash The commit hash.
+     *
+     * @return The tree (to free with `git_tree_free`).
+     */
+    git_tree *lookupTree(const Buffer &hash) const;
+
+    /*!
+     * Looks up the commit of a reference.
+     *
+     * @param[in]  name The reference name.
+     * @param[out] oid  The commit ID.
+     *
+     * @return False if the reference doesn't exist.
+     */
+    bool lookupReference(const std::string &name, git_oid &oid) const;
+
+    /*!
+     * Indicates whether the content of a commit is in the history of another one
+     * (a commit with the same tree, as the replayed ones of a compaction).
+     *
+     * @param[in] head   The head of the history.
+     * @param[in] commit The commit.
+     */
+    bool hasSnapshot(const git_oid &head, const git_oid &commit) const;
+
+    /*!
+     * Records the current head as the remote one (after a push).
+     */
+    Repository &updateTrackingRef();
+
+    /*!
+     * Updates the working directory from a previous commit to the current head.
+     *
+     * @param[in] from The hash of the previous commit.
+     */
+    Repository &checkout(const Buffer &from);
+
 
     /*!
      * The repository ID.
@@ -219,6 +396,11 @@ protected:
      * The private key.
      */
     PrivateKey mPrivateKey;
+
+    /*!
+     * The attached SSH session.
+     */
+    SshClient *mShell;
 };
 
 
@@ -13,6 +13,29 @@
 
 namespace km { // Begin main namespace
 
+inline RsaKey::Algorithm
+RsaKey::getAlgorithm() const
+{
+    if (!mPkey) {
+        return ALGORITHM_RSA;
+    }
+
+    switch (EVP_PKEY_base_id(mPkey.get())) {
+
+        case EVP_PKEY_X25519:  return ALGORITHM_X25519;
+        case EVP_PKEY_ED25519: return ALGORITHM_ED25519;
+        default:               return ALGORITHM_ECDSA;
+    }
+}
+
+inline bool
+RsaKey::canWrap() const
+{
+    auto algorithm = getAlgorithm();
+
+    return algorithm == ALGORITHM_RSA || algorithm == ALGORITHM_X25519;
+}
+
 } // End of main namespace
 
 #endif /* __KM_RSA_KEY_INL_HPP__ */
\ No newline at end of file
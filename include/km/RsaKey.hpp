@@ -13,6 +13,7 @@
 
 #include <km.hpp>
 #include <km/Exception.hpp>
+#include <km/Buffer.hpp>
 
 #include <memory>
 
@@ -22,6 +23,7 @@
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 
 namespace km { // Begin main namespace
 
@@ -29,6 +31,11 @@ class Encrypter;
 
 /*!
  * The RSA key.
+ *
+ * An X25519 key can be loaded instead, to wrap the access keys without
+ * the RSA private operations (it can't be used for the SSH connections).
+ * The Ed25519 and ECDSA keys authenticate the SSH connections, but can't
+ * wrap the access keys.
  */
 class RsaKey
 {
@@ -36,6 +43,18 @@ class RsaKey
 
 public:
 
+    /*!
+     * The key algorithms.
+     */
+    enum Algorithm {
+
+        ALGORITHM_RSA     = 0,
+        ALGORITHM_X25519  = 1,
+        ALGORITHM_ED25519 = 2,
+        ALGORITHM_ECDSA   = 3,
+        ALGORITHM_GROUP   = 4  // Access keys wrapped by a group key (no key pair)
+    };
+
     /*!
      * Constructor method.
      */
@@ -46,12 +65,32 @@ public:
      */
 	virtual ~RsaKey();
 
+    /*!
+     * Returns the key algorithm.
+     */
+    Algorithm getAlgorithm() const;
+
+    /*!
+     * Indicates whether the access keys can be wrapped for the key.
+     */
+    bool canWrap() const;
+
 protected:
 
     /*!
      * The RSA data.
      */
     std::shared_ptr<RSA> mRsa;
+
+    /*!
+     * The X25519, Ed25519 or ECDSA key (empty for the RSA keys).
+     */
+    std::shared_ptr<EVP_PKEY> mPkey;
+
+    /*!
+     * The fingerprint (computed once, when the key is loaded).
+     */
+    Buffer mFingerprint;
 };
 
 } // End of main namespace
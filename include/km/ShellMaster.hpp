@@ -0,0 +1,218 @@
+/*!
+ * Title ---- km/ShellMaster.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_SHELL_MASTER_HPP__
+#define __KM_SHELL_MASTER_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Console.hpp>
+#include <km/Buffer.hpp>
+#include <km/PrivateKey.hpp>
+#include <km/SshClient.hpp>
+#include <km/IpcChannel.hpp>
+#include <km/IpcServer.hpp>
+
+#include <memory>
+#include <chrono>
+#include <future>
+#include <deque>
+#include <list>
+#include <map>
+
+#include <boost/filesystem.hpp>
+
+using namespace boost;
+
+namespace km { // Begin main namespace
+
+/*!
+ * The SSH control master.
+ *
+ * Keeps an authenticated session per server and runs on it the commands
+ * received from the local clients (see `SshClient::attachMaster()`).
+ *
+ * Every request is a message `[id, hostname, port, username, command, timeout]`
+ * and is answered by `[id, returnCode, output, errors, error]`.
+ */
+class ShellMaster : public IpcServer
+{
+
+public:
+
+    /*!
+     * Timing parameters.
+     */
+    enum {
+
+        POLL_INTERVAL   = 50,  // milliseconds
+        IDLE_TIMEOUT    = 600, // seconds
+        CONNECT_RETRIES = 1
+    };
+
+    /*!
+     * The socket file.
+     */
+    static const filesystem::path SocketFile;
+
+    /*!
+     * Constructor method.
+     *
+     * @param[in] socketPath The path to the socket.
+     * @param[in] privateKey The private key.
+     */
+    ShellMaster(const filesystem::path &socketPath, const PrivateKey &privateKey);
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~ShellMaster();
+
+    /*!
+     * Serves the clients until no request arrives for a while.
+     *
+     * @param[in] idleTimeout The idle timeout.
+     */
+    ShellMaster &run(std::chrono::seconds idleTimeout = std::chrono::seconds(IDLE_TIMEOUT));
+
+protected:
+
+    /*!
+     * The clock type.
+     */
+    typedef SshClient::Clock Clock;
+
+    /*!
+     * A received request.
+     */
+    struct Job
+    {
+        /*!
+         * The client connection.
+         */
+        Connection connection;
+
+        /*!
+         * The request message.
+         */
+        IpcChannel::Message request;
+    };
+
+    /*!
+     * A request running on a session.
+     */
+    struct Pending
+    {
+        /*!
+         * The client connection.
+         */
+        Connection connection;
+
+        /*!
+         * The request ID.
+         */
+        Buffer id;
+
+        /*!
+         * The session key.
+         */
+        Buffer session;
+
+        /*!
+         * The response content.
+         */
+        Buffer output;
+
+        /*!
+         * The future result.
+         */
+        std::future<SshClient::Result> result;
+    };
+
+    /*!
+     * Queues a request.
+     *
+     * @param[in] connection The client connection.
+     * @param[in] message    The request.
+     */
+    virtual void receive(Connection connection, IpcChannel::Message &message) override;
+
+    /*!
+     * Stops serving the clients and closes the sessions.
+     */
+    void shutdown();
+
+    /*!
+     * Starts a request on its session.
+     *
+     * @param[in] job The request.
+     */
+    void dispatch(Job &job);
+
+    /*!
+     * Drives the sessions and answers the completed requests.
+     */
+    void poll();
+
+    /*!
+     * Keeps the idle sessions alive (dropping the dead ones).
+     */
+    void keepAlive();
+
+    /*!
+     * Returns the session for a server, connecting it if needed.
+     *
+     * @param[in] key      The session key.
+     * @param[in] hostname The server hostname.
+     * @param[in] port     The server port.
+     * @param[in] username The username.
+     */
+    SshClient &getSession(const Buffer &key, const Buffer &hostname, const Buffer &port, const Buffer &username);
+
+    /*!
+     * Stops using a session (its running requests are left to complete).
+     *
+     * @param[in] key The session key.
+     */
+    void retire(const Buffer &key);
+
+
+    /*!
+     * The private key.
+     */
+    PrivateKey mPrivateKey;
+
+    /*!
+     * The received requests.
+     */
+    std::deque<Job> mJobs;
+
+    /*!
+     * The sessions (by username, hostname and port).
+     */
+    std::map<Buffer, std::unique_ptr<SshClient>> mSessions;
+
+    /*!
+     * The failed sessions that still have requests running.
+     */
+    std::list<std::unique_ptr<SshClient>> mRetired;
+
+    /*!
+     * The running requests.
+     */
+    std::list<std::shared_ptr<Pending>> mPending;
+};
+
+} // End of main namespace
+
+#endif /* __KM_SHELL_MASTER_HPP__ */
+
+// Include inline methods
+#include <km/ShellMaster-inl.hpp>
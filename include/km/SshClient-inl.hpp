@@ -19,29 +19,46 @@ SshClient::exec(const Buffer &command, T_ARGS && ... args)
 {
     BEGIN_TASK("shell", "Execute command");
 
-    LIBSSH2_CHANNEL *channel = libssh2_channel_open_session(mSession.get());
+    auto future = execAsync(
+        format_buffer(command, std::forward<T_ARGS>(args) ...)
+    );
 
-    if (!channel) {
-        throw Exception("SshClient: failed to open the channel");
-    }
+    run();
 
-    Buffer planCommand = format_buffer(command, std::forward<T_ARGS>(args) ...);
-    planCommand.push_back('\0');
+    auto result = future.get();
 
-    if (libssh2_channel_exec(channel, (const char *) planCommand.data())) {
-        throw Exception("SshClient: failed to exec the command");
-    }
-
-    mResponse   = readFromChannel(channel);
-    mReturnCode = libssh2_channel_get_exit_status(channel);
-
-    libssh2_channel_free(channel);
+    mResponse   = result.output;
+    mReturnCode = result.returnCode;
 
     END_TASK();
 
     return mResponse;
 }
 
+inline void
+SshClient::setDnsCache(const filesystem::path &path)
+{
+    mDnsCachePath = path;
+}
+
+inline bool
+SshClient::hasSession() const
+{
+    return (bool) mSession;
+}
+
+inline bool
+SshClient::isConnected() const
+{
+    return mMaster || mSession;
+}
+
+inline std::size_t
+SshClient::getNumberOfRequests() const
+{
+    return mRequests.size();
+}
+
 inline int
 SshClient::getReturnCode() const
 {
@@ -16,13 +16,26 @@
 #include <km/Console.hpp>
 #include <km/Buffer.hpp>
 #include <km/PrivateKey.hpp>
+#include <km/IpcChannel.hpp>
 
 #include <memory>
+#include <functional>
 #include <string>
+#include <list>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <exception>
+#include <ctime>
 
 #include <libssh2.h>
 
 #include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 
 using namespace boost;
 using namespace boost::asio;
@@ -39,6 +52,63 @@ class SshClient
 
 public:
 
+    /*!
+     * Timeout parameters (in seconds).
+     */
+    enum {
+
+        EXEC_TIMEOUT       = 60,
+        CLOSE_TIMEOUT      = 5,
+        KEEPALIVE_INTERVAL = 30
+    };
+
+    /*!
+     * Connection parameters.
+     */
+    enum {
+
+        CONNECT_TIMEOUT = 10,  // seconds
+        CONNECT_DELAY   = 250, // milliseconds between the attempts
+        DNS_CACHE_TTL   = 300, // seconds
+        MAX_CHANNELS    = 8    // commands in flight at once
+    };
+
+    /*!
+     * The DNS cache file.
+     */
+    static const filesystem::path DnsCacheFile;
+
+    /*!
+     * The clock type.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /*!
+     * The result of a command.
+     */
+    struct Result
+    {
+        /*!
+         * The response content (NUL-terminated, empty when streamed).
+         */
+        Buffer output;
+
+        /*!
+         * The error output.
+         */
+        Buffer errors;
+
+        /*!
+         * The return code.
+         */
+        int returnCode;
+    };
+
+    /*!
+     * The output callback (receives the response content in chunks).
+     */
+    typedef std::function<void (const char *data, std::size_t size)> OutputCallback;
+
     /*!
      * Constructor method.
      *
@@ -52,6 +122,13 @@ public:
      */
 	virtual ~SshClient();
 
+    /*!
+     * Caches the resolved addresses of the server in a file.
+     *
+     * @param[in] path The path to the cache file.
+     */
+    void setDnsCache(const filesystem::path &path);
+
     /*!
      * Connects the client to the server.
      *
@@ -68,6 +145,28 @@ public:
      */
     void connect(const Buffer &username, const PrivateKey &privateKey);
 
+    /*!
+     * Sends the commands through a control master instead of a session of its own.
+     *
+     * @param[in] path     The path to the control master socket.
+     * @param[in] username The username.
+     *
+     * @return `true` if the control master is running.
+     */
+    bool attachMaster(const filesystem::path &path, const Buffer &username);
+
+    /*!
+     * Checks if the client owns an SSH session (as opposed to a control master).
+     */
+    bool hasSession() const;
+
+    /*!
+     * Checks if the client can run commands (through a session or a control master).
+     *
+     * A client whose control master has gone is disconnected until `connect()`.
+     */
+    bool isConnected() const;
+
     /*!
      * Executes a command.
      *
@@ -79,6 +178,68 @@ public:
     template <typename ... T_ARGS>
     Buffer exec(const Buffer &command, T_ARGS && ... args);
 
+    /*!
+     * Schedules a command on a new channel of the session.
+     *
+     * The commands run concurrently while `run()` drives the session, up to
+     * `MAX_CHANNELS` at once; the timeout starts when the command does.
+     *
+     * @param[in] command The command to execute.
+     * @param[in] timeout The timeout of the command.
+     *
+     * @return The future result.
+     */
+    std::future<Result> execAsync(const Buffer &command, Clock::duration timeout = std::chrono::seconds(EXEC_TIMEOUT));
+
+    /*!
+     * Schedules a command whose response is streamed to a callback.
+     *
+     * @param[in] command  The command to execute.
+     * @param[in] callback The output callback.
+     * @param[in] timeout  The timeout of the command.
+     *
+     * @return The future result.
+     */
+    std::future<Result> execAsync(const Buffer &command, OutputCallback callback, Clock::duration timeout = std::chrono::seconds(EXEC_TIMEOUT));
+
+    /*!
+     * Runs the scheduled commands until they are all completed.
+     */
+    SshClient &run();
+
+    /*!
+     * Advances the scheduled commands and waits for progress.
+     *
+     * @param[in] deadline The deadline of the wait.
+     */
+    SshClient &runOnce(Clock::time_point deadline);
+
+    /*!
+     * Returns the number of scheduled commands.
+     */
+    std::size_t getNumberOfRequests() const;
+
+    /*!
+     * Waits until the session is ready to make progress.
+     *
+     * @param[in] deadline The deadline.
+     */
+    void wait(Clock::time_point deadline = Clock::time_point::max());
+
+    /*!
+     * Sends a keepalive message to the server, if one is due.
+     */
+    void keepAlive();
+
+    /*!
+     * Opens a channel running a command.
+     *
+     * @param[in] command The command to execute.
+     *
+     * @return The channel (to free with `libssh2_channel_free`).
+     */
+    LIBSSH2_CHANNEL *openChannel(const Buffer &command);
+
     /*!
      * Returns the command return code.
      */
@@ -102,9 +263,116 @@ protected:
     void checkAuthMethod(const Buffer &username, const std::string &method);
 
     /*!
-     * Reads data from a channel.
+     * The states of a scheduled command.
+     */
+    enum RequestState {
+
+        REQUEST_OPEN,
+        REQUEST_EXEC,
+        REQUEST_READ,
+        REQUEST_CLOSE,
+        REQUEST_WAIT,
+        REQUEST_FREE,
+        REQUEST_DONE
+    };
+
+    /*!
+     * A scheduled command.
+     */
+    struct Request
+    {
+        /*!
+         * The request ID (used by the control master).
+         */
+        Buffer id;
+
+        /*!
+         * The command to execute.
+         */
+        Buffer command;
+
+        /*!
+         * The channel.
+         */
+        LIBSSH2_CHANNEL *channel = nullptr;
+
+        /*!
+         * The current state.
+         */
+        RequestState state = REQUEST_OPEN;
+
+        /*!
+         * The timeout.
+         */
+        Clock::duration timeout;
+
+        /*!
+         * Indicates whether the command has been started.
+         */
+        bool started = false;
+
+        /*!
+         * The deadline (set when started).
+         */
+        Clock::time_point deadline = Clock::time_point::max();
+
+        /*!
+         * The output callback (if streamed).
+         */
+        OutputCallback callback;
+
+        /*!
+         * The partial result.
+         */
+        Result result;
+
+        /*!
+         * Indicates whether the promise has already been fulfilled.
+         */
+        bool abandoned = false;
+
+        /*!
+         * The promised result.
+         */
+        std::promise<Result> promise;
+    };
+
+    /*!
+     * Sends the scheduled commands to the control master, up to `MAX_CHANNELS` in flight.
+     */
+    void sendToMaster();
+
+    /*!
+     * Fails the pending commands and drops the control master.
+     *
+     * @param[in] reason The reason.
+     */
+    void detachMaster(const std::string &reason);
+
+    /*!
+     * Receives a response from the control master.
+     *
+     * The master enforces the command timeouts, the client waits up to
+     * `CLOSE_TIMEOUT` more before giving it up.
      */
-    Buffer readFromChannel(LIBSSH2_CHANNEL *channel);
+    void receiveFromMaster();
+
+    /*!
+     * Advances a scheduled command without blocking.
+     *
+     * @param[in] request The request.
+     *
+     * @return `true` if the request is completed.
+     */
+    bool step(Request &request);
+
+    /*!
+     * Fails a scheduled command and lets its channel close in background.
+     *
+     * @param[in] request The request.
+     * @param[in] error   The error.
+     */
+    void abandon(Request &request, std::exception_ptr error);
 
     /*!
      * Closes the SSH session.
@@ -116,6 +384,48 @@ protected:
      */
     void openSocket();
 
+    /*!
+     * Resolves the server addresses.
+     *
+     * @return The endpoints, in the order of the attempts.
+     */
+    std::vector<tcp::endpoint> resolve();
+
+    /*!
+     * Connects the socket to the first endpoint that answers.
+     *
+     * The attempts are staggered by `CONNECT_DELAY` and run concurrently
+     * (RFC 8305), so an unreachable address doesn't stall the others.
+     *
+     * @param[in] endpoints The endpoints.
+     *
+     * @return `true` if the socket is connected.
+     */
+    bool connectSocket(const std::vector<tcp::endpoint> &endpoints);
+
+    /*!
+     * Interleaves the address families of the endpoints.
+     *
+     * @param[in] endpoints The endpoints in order of preference.
+     */
+    static std::vector<tcp::endpoint> sortEndpoints(const std::vector<tcp::endpoint> &endpoints);
+
+    /*!
+     * Looks up the server in the DNS cache.
+     *
+     * @param[out] endpoints The cached endpoints.
+     *
+     * @return `true` if a fresh entry has been found.
+     */
+    bool readDnsCache(std::vector<tcp::endpoint> &endpoints) const;
+
+    /*!
+     * Stores the server endpoints in the DNS cache.
+     *
+     * @param[in] endpoints The endpoints.
+     */
+    void writeDnsCache(const std::vector<tcp::endpoint> &endpoints) const;
+
     /*!
      * Closes the socket.
      */
@@ -132,6 +442,11 @@ protected:
      */
     Buffer mPort;
 
+    /*!
+     * The path to the DNS cache.
+     */
+    filesystem::path mDnsCachePath;
+
     /*!
      * The I/O service.
      */
@@ -147,6 +462,26 @@ protected:
      */
     std::shared_ptr<LIBSSH2_SESSION> mSession;
 
+    /*!
+     * The scheduled commands.
+     */
+    std::list<std::shared_ptr<Request>> mRequests;
+
+    /*!
+     * The username.
+     */
+    Buffer mUsername;
+
+    /*!
+     * The control master channel.
+     */
+    std::shared_ptr<IpcChannel> mMaster;
+
+    /*!
+     * The last request ID sent to the control master.
+     */
+    std::uint64_t mLastRequestId;
+
     /*!
      * The remote response.
      */
@@ -0,0 +1,129 @@
+/*!
+ * Title ---- km/SshTransport.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_SSH_TRANSPORT_HPP__
+#define __KM_SSH_TRANSPORT_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/SshClient.hpp>
+
+#include <string>
+
+#include <git2.h>
+#include <git2/sys/transport.h>
+
+namespace km { // Begin main namespace
+
+/*!
+ * The Git transport over the channels of an authenticated SSH session.
+ */
+class SshTransport
+{
+
+public:
+
+    /*!
+     * Creates a transport (see `git_transport_cb`).
+     *
+     * @param[out] out    The transport.
+     * @param[in]  owner  The remote.
+     * @param[in]  client The SSH client.
+     */
+    static int create(git_transport **out, git_remote *owner, void *client);
+
+protected:
+
+    /*!
+     * The stream of a Git service.
+     */
+    struct Stream
+    {
+        /*!
+         * The libgit2 stream.
+         */
+        git_smart_subtransport_stream parent;
+
+        /*!
+         * The SSH channel.
+         */
+        LIBSSH2_CHANNEL *channel;
+    };
+
+    /*!
+     * The subtransport.
+     */
+    struct Subtransport
+    {
+        /*!
+         * The libgit2 subtransport.
+         */
+        git_smart_subtransport parent;
+
+        /*!
+         * The SSH client.
+         */
+        SshClient *client;
+
+        /*!
+         * The current stream.
+         */
+        Stream *current;
+    };
+
+    /*!
+     * Creates a subtransport (see `git_smart_subtransport_cb`).
+     */
+    static int createSubtransport(git_smart_subtransport **out, git_transport *owner, void *client);
+
+    /*!
+     * Opens the stream of a Git service.
+     */
+    static int action(git_smart_subtransport_stream **out, git_smart_subtransport *subtransport, const char *url, git_smart_service_t service);
+
+    /*!
+     * Closes the subtransport.
+     */
+    static int close(git_smart_subtransport *subtransport);
+
+    /*!
+     * Frees the subtransport.
+     */
+    static void free(git_smart_subtransport *subtransport);
+
+    /*!
+     * Reads data from a stream.
+     */
+    static int read(git_smart_subtransport_stream *stream, char *buffer, size_t size, size_t *bytesRead);
+
+    /*!
+     * Writes data into a stream.
+     */
+    static int write(git_smart_subtransport_stream *stream, const char *buffer, size_t size);
+
+    /*!
+     * Frees a stream.
+     */
+    static void freeStream(git_smart_subtransport_stream *stream);
+
+    /*!
+     * Extracts the repository path from a remote URL.
+     *
+     * @param[in] url The remote URL.
+     *
+     * @return The repository path.
+     */
+    static std::string getRepositoryPath(const std::string &url);
+};
+
+} // End of main namespace
+
+#endif /* __KM_SSH_TRANSPORT_HPP__ */
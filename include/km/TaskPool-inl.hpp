@@ -0,0 +1,26 @@
+/*!
+ * Title ---- km/TaskPool-inl.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_TASK_POOL_INL_HPP__
+#define __KM_TASK_POOL_INL_HPP__
+
+namespace km { // Begin main namespace
+
+inline TaskPool &
+TaskPool::stop()
+{
+    mStopped = true;
+
+    return *this;
+}
+
+} // End of main namespace
+
+#endif /* __KM_TASK_POOL_INL_HPP__ */
@@ -0,0 +1,132 @@
+/*!
+ * Title ---- km/TaskPool.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_TASK_POOL_HPP__
+#define __KM_TASK_POOL_HPP__
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <system_error>
+
+namespace km { // Begin main namespace
+
+/*!
+ * A pool of threads running a task over a range of indexes.
+ *
+ * The workers take the indexes in order until the range ends or the pool is
+ * stopped. If no thread can be started, the indexes are run by the caller
+ * before the constructor returns.
+ */
+class TaskPool
+{
+
+public:
+
+    /*!
+     * Runs a task over a range of indexes and waits for it.
+     *
+     * @param[in] count        The number of indexes.
+     * @param[in] task         The task.
+     * @param[in] numOfThreads The number of threads (one per core if zero).
+     *
+     * @throw The first error of the task, in index order.
+     */
+    static void run(std::size_t count, std::function<void (std::size_t)> task, unsigned int numOfThreads = 0);
+
+    /*!
+     * Constructor method (starts the workers).
+     *
+     * @param[in] count        The number of indexes.
+     * @param[in] task         The task.
+     * @param[in] numOfThreads The number of threads (one per core if zero).
+     */
+    TaskPool(std::size_t count, std::function<void (std::size_t)> task, unsigned int numOfThreads = 0);
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    /*!
+     * Destructor method (stops and joins the workers).
+     */
+    virtual ~TaskPool();
+
+    /*!
+     * Stops taking new indexes (the running tasks are completed).
+     *
+     * @return The pool instance.
+     */
+    TaskPool &stop();
+
+    /*!
+     * Waits for the workers.
+     *
+     * @return The pool instance.
+     */
+    TaskPool &join();
+
+    /*!
+     * Rethrows the first error of the task, in index order.
+     *
+     * @return The pool instance.
+     */
+    TaskPool &rethrow();
+
+protected:
+
+    /*!
+     * Runs the task over the next indexes.
+     */
+    void work();
+
+
+    /*!
+     * The number of indexes.
+     */
+    std::size_t mCount;
+
+    /*!
+     * The task.
+     */
+    std::function<void (std::size_t)> mTask;
+
+    /*!
+     * The next index.
+     */
+    std::atomic<std::size_t> mNext;
+
+    /*!
+     * Indicates whether the pool has been stopped.
+     */
+    std::atomic<bool> mStopped;
+
+    /*!
+     * The errors of the task, by index.
+     */
+    std::vector<std::exception_ptr> mErrors;
+
+    /*!
+     * The worker threads.
+     */
+    std::vector<std::thread> mWorkers;
+};
+
+} // End of main namespace
+
+#endif /* __KM_TASK_POOL_HPP__ */
+
+// Include inline methods
+#include <km/TaskPool-inl.hpp>
@@ -39,6 +39,19 @@ TextNode::getNonce() const
     return mNonce;
 }
 
+inline TextNode &
+TextNode::setKeyVersion(unsigned int version)
+{
+    mKeyVersion = version;
+    return *this;
+}
+
+inline unsigned int
+TextNode::getKeyVersion() const
+{
+    return mKeyVersion;
+}
+
 inline Buffer
 TextNode::toBuffer() const
 {
@@ -94,6 +94,16 @@ public:
      */
     const Buffer &getNonce() const;
 
+    /*!
+     * Sets the version of the access key which encrypted the node.
+     */
+    TextNode &setKeyVersion(unsigned int version);
+
+    /*!
+     * Returns the version of the access key which encrypted the node.
+     */
+    unsigned int getKeyVersion() const;
+
     /*!
      * Converts the text node into a buffer.
      */
@@ -116,6 +126,11 @@ protected:
      * The nonce.
      */
     Buffer mNonce;
+
+    /*!
+     * The version of the access key.
+     */
+    unsigned int mKeyVersion;
 };
 
 } // End of main namespace
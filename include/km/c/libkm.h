@@ -0,0 +1,140 @@
+/*!
+ * Title ---- km/c/libkm.h
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_C_LIBKM_H__
+#define __KM_C_LIBKM_H__
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#   define KM_API __declspec(dllexport)
+#else
+#   define KM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * The version of the C interface (bumped only on incompatible changes).
+ */
+#define KM_ABI_VERSION 1
+
+/*!
+ * The return codes.
+ */
+#define KM_OK         0
+#define KM_END        1
+#define KM_ERROR     -1
+#define KM_NOT_FOUND -2
+
+/*!
+ * A session on the local keyrings.
+ *
+ * The library state is process-wide, so there is one session at most; the
+ * calls are serialized, the session can be shared by several threads.
+ */
+typedef struct km_session km_session;
+
+/*!
+ * An iterator over the entries of a repository.
+ */
+typedef struct km_iterator km_iterator;
+
+/*!
+ * The callback of `km_each_property()`.
+ *
+ * The strings are valid only during the call; a non-zero return value
+ * stops the iteration.
+ */
+typedef int (*km_property_cb)(const char *entry_id, const char *name, const char *value, size_t length, void *payload);
+
+/*!
+ * Returns the version of the C interface.
+ */
+KM_API int km_abi_version(void);
+
+/*!
+ * Opens a session (loads the user configuration).
+ *
+ * @return The session, or `NULL` on failure or if a session is already open.
+ */
+KM_API km_session *km_session_open(void);
+
+/*!
+ * Closes a session.
+ */
+KM_API void km_session_close(km_session *session);
+
+/*!
+ * Returns the last error of a session (valid until the next call).
+ */
+KM_API const char *km_last_error(const km_session *session);
+
+/*!
+ * Unlocks the private key of the user.
+ *
+ * Starts the background thread pushing the modified repositories, which
+ * runs until the process exits.
+ */
+KM_API int km_authenticate(km_session *session, const char *passphrase, size_t length);
+
+/*!
+ * Opens a repository.
+ *
+ * The calls on the entries fail with `KM_ERROR` until a repository is open.
+ */
+KM_API int km_repository_open(km_session *session, const char *repository_id);
+
+/*!
+ * Copies a property of an entry of the open repository.
+ *
+ * The entry is referenced by ID or by name; the value is NUL-terminated
+ * and must be released with `km_secret_free()`.
+ *
+ * @return `KM_NOT_FOUND` if the entry or the property doesn't exist.
+ */
+KM_API int km_entry_get(km_session *session, const char *entry, const char *property, char **value, size_t *length);
+
+/*!
+ * Lists the entries of the open repository.
+ */
+KM_API int km_entry_list(km_session *session, km_iterator **iterator);
+
+/*!
+ * Advances an iterator (the strings are valid until the next call).
+ *
+ * @return `KM_END` after the last entry.
+ */
+KM_API int km_iterator_next(km_iterator *iterator, const char **entry_id, const char **name);
+
+/*!
+ * Releases an iterator (wiping its content).
+ */
+KM_API void km_iterator_free(km_iterator *iterator);
+
+/*!
+ * Streams the properties of the entries of the open repository.
+ *
+ * The entries are decrypted one at a time and wiped after the callback.
+ */
+KM_API int km_each_property(km_session *session, km_property_cb callback, void *payload);
+
+/*!
+ * Wipes and releases a value returned by `km_entry_get()`.
+ */
+KM_API void km_secret_free(char *value, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KM_C_LIBKM_H__ */
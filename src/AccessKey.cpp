@@ -37,6 +37,22 @@ AccessKey::fromConfig(property_tree::ptree &config)
     accessKey.mRecipient = Buffer::fromBase64(recipient);
     accessKey.mData      = Buffer::fromBase64(data);
 
+    // NOTE: the keys without an algorithm are wrapped by RSA
+    auto algorithm = config.get<std::string>("algorithm", "rsa");
+
+    if (algorithm == "x25519") {
+        accessKey.mAlgorithm = RsaKey::ALGORITHM_X25519;
+
+    } else if (algorithm == "group") {
+        accessKey.mAlgorithm = RsaKey::ALGORITHM_GROUP;
+
+    } else if (algorithm != "rsa") {
+        throw Exception("Unsupported access key algorithm '%1%'", algorithm);
+    }
+
+    // NOTE: the keys without a version have never been rotated
+    accessKey.mVersion = config.get<unsigned int>("version", 0);
+
     return accessKey;
 }
 
@@ -51,10 +67,21 @@ AccessKey::toConfig(const AccessKey &accessKey)
     config.put<std::string>("data", accessKey.mData.toBase64<std::string>());
     config.put<std::string>("data.<xmlattr>.encoding", "base64");
 
+    switch (accessKey.mAlgorithm) {
+
+        case RsaKey::ALGORITHM_X25519: config.put<std::string>("algorithm", "x25519"); break;
+        case RsaKey::ALGORITHM_GROUP:  config.put<std::string>("algorithm", "group");  break;
+        default:                       config.put<std::string>("algorithm", "rsa");    break;
+    }
+
+    if (accessKey.mVersion) {
+        config.put<unsigned int>("version", accessKey.mVersion);
+    }
+
     return config;
 }
 
-AccessKey::AccessKey()
+AccessKey::AccessKey() : mAlgorithm(RsaKey::ALGORITHM_RSA), mVersion(0)
 {
 
 }
@@ -63,6 +90,8 @@ AccessKey::AccessKey(const AccessKey &other)
 {
     mData      = other.mData;
     mRecipient = other.mRecipient;
+    mAlgorithm = other.mAlgorithm;
+    mVersion   = other.mVersion;
 }
 
 AccessKey::~AccessKey()
@@ -0,0 +1,117 @@
+/*!
+ * Title ---- km/BloomFilter.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/BloomFilter.hpp>
+
+#include <algorithm>
+
+namespace km { // Begin main namespace
+
+BloomFilter
+BloomFilter::create(std::size_t capacity)
+{
+    BloomFilter filter;
+
+    capacity = std::max<std::size_t>(capacity, MIN_CAPACITY);
+
+    filter.mBits.assign((capacity * BITS_PER_ITEM + 7) / 8, 0);
+
+    return filter;
+}
+
+BloomFilter
+BloomFilter::fromBuffer(const Buffer &data)
+{
+    if (data.empty()) {
+        throw Exception("Malformed Bloom filter");
+    }
+
+    BloomFilter filter;
+
+    filter.mBits = data;
+
+    return filter;
+}
+
+Buffer
+BloomFilter::toBuffer(const BloomFilter &filter)
+{
+    return filter.mBits;
+}
+
+BloomFilter::BloomFilter()
+{
+
+}
+
+BloomFilter::~BloomFilter()
+{
+
+}
+
+BloomFilter &
+BloomFilter::add(const Buffer &item)
+{
+    std::uint64_t first, second;
+    hash(item, first, second);
+
+    std::uint64_t size = mBits.size() * 8;
+
+    for (std::uint64_t i = 0; i < NUM_HASHES; ++i) {
+
+        auto bit = (first + i * second) % size;
+
+        mBits[bit / 8] |= (std::uint8_t) (1 << (bit % 8));
+    }
+
+    return *this;
+}
+
+bool
+BloomFilter::mayContain(const Buffer &item) const
+{
+    std::uint64_t first, second;
+    hash(item, first, second);
+
+    std::uint64_t size = mBits.size() * 8;
+
+    for (std::uint64_t i = 0; i < NUM_HASHES; ++i) {
+
+        auto bit = (first + i * second) % size;
+
+        if (!(mBits[bit / 8] & (1 << (bit % 8)))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+BloomFilter::hash(const Buffer &item, std::uint64_t &first, std::uint64_t &second)
+{
+    std::uint8_t digest[EVP_MAX_MD_SIZE];
+
+    if (!EVP_Digest(item.data(), item.size(), digest, NULL, EVP_sha256(), NULL)) {
+        throw Exception("Failed hashing data");
+    }
+
+    first = second = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        first  = (first  << 8) | digest[i];
+        second = (second << 8) | digest[i + 8];
+    }
+
+    // NOTE: the step must never be zero
+    second |= 1;
+}
+
+} // End of main namespace
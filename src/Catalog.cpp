@@ -0,0 +1,371 @@
+/*!
+ * Title ---- km/Catalog.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/Catalog.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+namespace km { // Begin main namespace
+
+const filesystem::path
+Catalog::CatalogFile = "catalog";
+
+/*!
+ * The header of the catalog file.
+ */
+static const std::string CatalogHeader = "km-catalog 1";
+
+/*!
+ * Splits a line of the catalog into its fields (keeping the empty ones).
+ */
+static std::vector<Buffer>
+splitFields(Buffer::const_iterator first, Buffer::const_iterator last)
+{
+    std::vector<Buffer> fields;
+
+    while (true) {
+
+        auto separator = std::find(first, last, ' ');
+
+        fields.push_back(Buffer::fromHex(first, separator));
+
+        if (separator == last) {
+            break;
+        }
+
+        first = separator + 1;
+    }
+
+    return fields;
+}
+
+/*!
+ * Appends a field to a line of the catalog.
+ */
+static void
+appendField(Buffer &output, const Buffer &field)
+{
+    output.push_back(' ');
+    algorithm::hex(field.begin(), field.end(), std::back_inserter(output));
+}
+
+
+Catalog
+Catalog::create(const PublicKey &publicKey, const PrivateKey &privateKey)
+{
+    Catalog catalog;
+
+    catalog.mAccessKey = Encrypter::encrypt<AccessKey>
+    (
+        AccessKey::create(Encrypter::getFingerprint(publicKey), Buffer::fromRandom(Encrypter::ENCRYPT_KEY_LENGTH)),
+        publicKey
+    );
+
+    catalog.mEncrypter = std::make_shared<Encrypter>(
+        Encrypter::create(catalog.mAccessKey, privateKey)
+    );
+
+    return catalog;
+}
+
+Catalog
+Catalog::fromFile(const filesystem::path &path, const PrivateKey &privateKey)
+{
+    filesystem::ifstream file(path, std::ios::binary);
+
+    if (!file) {
+        throw Exception("Failed reading catalog %1%", path);
+    }
+
+    std::string header, recipient, key, iv, content;
+
+    if (!std::getline(file, header) || header != CatalogHeader ||
+        !std::getline(file, recipient) || !std::getline(file, key) ||
+        !std::getline(file, iv) || !std::getline(file, content) || content.empty()) {
+        throw Exception("Malformed catalog %1%", path);
+    }
+
+    Catalog catalog;
+
+    catalog.mAccessKey
+        .setRecipient(Buffer::fromBase64(recipient))
+        .setData(Buffer::fromBase64(key))
+    ;
+
+    if (catalog.mAccessKey.getRecipient() != Encrypter::getFingerprint(privateKey)) {
+        throw Exception("The catalog %1% belongs to another key", path);
+    }
+
+    // NOTE: the key is wrapped for the algorithm of its recipient
+    catalog.mAccessKey.setAlgorithm(privateKey.getAlgorithm());
+
+    catalog.mEncrypter = std::make_shared<Encrypter>(
+        Encrypter::create(catalog.mAccessKey, privateKey)
+    );
+
+    catalog.parse(
+        catalog.mEncrypter->decrypt(Buffer::fromBase64(content), Buffer::fromBase64(iv))
+    );
+
+    return catalog;
+}
+
+void
+Catalog::toFile(const filesystem::path &path, const Catalog &catalog)
+{
+    auto iv = Buffer::fromRandom(Encrypter::ENCRYPT_IV_LENGTH);
+
+    auto content = catalog.mEncrypter->encrypt(catalog.toBuffer(), iv);
+
+    auto temporaryPath = path;
+    temporaryPath += ".tmp";
+
+    {
+        filesystem::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        file
+            << CatalogHeader << "\n"
+            << catalog.mAccessKey.getRecipient().toBase64<std::string>() << "\n"
+            << catalog.mAccessKey.getData().toBase64<std::string>() << "\n"
+            << iv.toBase64<std::string>() << "\n"
+            << content.toBase64<std::string>() << "\n"
+        ;
+
+        if (!file) {
+            throw Exception("Failed writing catalog %1%", path);
+        }
+    }
+
+    filesystem::rename(temporaryPath, path);
+}
+
+Catalog::Catalog()
+{
+
+}
+
+Catalog::~Catalog()
+{
+
+}
+
+Catalog &
+Catalog::setRepository(const Buffer &id, const Buffer &name, std::size_t numOfEntries)
+{
+    removeRepository(id);
+
+    mRepositories.emplace(id, Record { name, BloomFilter::create(numOfEntries * 2), 0 });
+
+    return *this;
+}
+
+Catalog &
+Catalog::setEntry(const Buffer &repositoryId, const Buffer &entryId, const Buffer &entryName)
+{
+    auto it = mRepositories.find(repositoryId);
+
+    if (it == mRepositories.end()) {
+        throw Exception("Repository '%1%' not in the catalog", repositoryId);
+    }
+
+    auto &record = it->second;
+
+    auto &location = mEntries[entryId];
+
+    if (location != repositoryId) {
+
+        auto previous = mRepositories.find(location);
+
+        if (previous != mRepositories.end()) {
+            --previous->second.numOfEntries;
+        }
+
+        location = repositoryId;
+        ++record.numOfEntries;
+    }
+
+    // NOTE: a renamed entry keeps matching its old name until the next reindex
+    record.filter.add(entryId);
+
+    if (!entryName.empty()) {
+        record.filter.add(entryName);
+    }
+
+    return *this;
+}
+
+Catalog &
+Catalog::setEntry(const Buffer &repositoryId, const EntryNode &entry)
+{
+    Buffer name;
+
+    try {
+        name = entry.getProperty("name").getContent();
+
+    } catch (PropertyNotFoundException &e) {
+        // Unnamed entry
+    }
+
+    return setEntry(repositoryId, entry.getId(), name);
+}
+
+Catalog &
+Catalog::setKeyring(const Buffer &repositoryId, const KeyringNode &keyring, const Encrypter &encrypter)
+{
+    Buffer name;
+
+    try {
+        name = encrypter.decryptProperty(keyring, Buffer::fromString("name")).getContent();
+
+    } catch (PropertyNotFoundException &e) {
+        // Unnamed keyring
+    }
+
+    setRepository(repositoryId, name, keyring.getNumberOfEntries());
+
+    keyring.eachEntry([this, &encrypter, &repositoryId](const Buffer &id, const EntryNode &entry) {
+
+        Buffer entryName;
+
+        try {
+            entryName = encrypter.decryptProperty(entry, Buffer::fromString("name")).getContent();
+
+        } catch (PropertyNotFoundException &e) {
+            // Unnamed entry
+        }
+
+        setEntry(repositoryId, id, entryName);
+    });
+
+    return *this;
+}
+
+Catalog &
+Catalog::removeRepository(const Buffer &id)
+{
+    mRepositories.erase(id);
+
+    for (auto it = mEntries.begin(); it != mEntries.end(); ) {
+
+        if (it->second == id) {
+            it = mEntries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return *this;
+}
+
+const Catalog &
+Catalog::eachRepository(std::function<void (const Buffer &id, const Buffer &name, std::size_t numOfEntries)> callback) const
+{
+    for (auto &repository : mRepositories) {
+        callback(repository.first, repository.second.name, repository.second.numOfEntries);
+    }
+
+    return *this;
+}
+
+std::vector<Buffer>
+Catalog::locate(const Buffer &reference, bool &exact) const
+{
+    auto it = mEntries.find(reference);
+
+    if (it != mEntries.end()) {
+        exact = true;
+        return { it->second };
+    }
+
+    exact = false;
+
+    std::vector<Buffer> output;
+
+    for (auto &repository : mRepositories) {
+
+        if (repository.second.filter.mayContain(reference)) {
+            output.push_back(repository.first);
+        }
+    }
+
+    return output;
+}
+
+Buffer
+Catalog::toBuffer() const
+{
+    // NOTE: the content is built in a buffer, so that it's wiped on release
+    Buffer output;
+
+    for (auto &repository : mRepositories) {
+
+        output.push_back('R');
+
+        appendField(output, repository.first);
+        appendField(output, repository.second.name);
+        appendField(output, BloomFilter::toBuffer(repository.second.filter));
+
+        output.push_back('\n');
+    }
+
+    for (auto &entry : mEntries) {
+
+        output.push_back('E');
+
+        appendField(output, entry.first);
+        appendField(output, entry.second);
+
+        output.push_back('\n');
+    }
+
+    return output;
+}
+
+void
+Catalog::parse(const Buffer &data)
+{
+    for (auto first = data.begin(); first != data.end(); ) {
+
+        auto last = std::find(first, data.end(), '\n');
+
+        if (last - first < 2 || *(first + 1) != ' ') {
+            throw Exception("Malformed catalog");
+        }
+
+        auto type   = *first;
+        auto fields = splitFields(first + 2, last);
+
+        if (type == 'R' && fields.size() == 3) {
+
+            mRepositories.emplace(fields[0], Record { fields[1], BloomFilter::fromBuffer(fields[2]), 0 });
+
+        } else if (type == 'E' && fields.size() == 2) {
+
+            auto it = mRepositories.find(fields[1]);
+
+            if (it == mRepositories.end()) {
+                throw Exception("Malformed catalog");
+            }
+
+            ++it->second.numOfEntries;
+
+            mEntries[fields[0]] = fields[1];
+
+        } else {
+            throw Exception("Malformed catalog");
+        }
+
+        first = (last == data.end() ? last : last + 1);
+    }
+}
+
+} // End of main namespace
@@ -0,0 +1,273 @@
+/*!
+ * Title ---- km/ChunkStore.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/ChunkStore.hpp>
+
+namespace km { // Begin main namespace
+
+const filesystem::path
+ChunkStore::ChunkDir = "chunks";
+
+const std::string
+ChunkStore::ManifestHeader = "km-attachment:1\n";
+
+ChunkStore::ChunkStore(const filesystem::path &path, const Encrypter &encrypter)
+:
+    mPath(path / ChunkDir),
+    mEncrypter(encrypter),
+    // NOTE: the boundaries depend on the 64 bytes before them (the top bits of the hash)
+    mMask((std::uint64_t) (CHUNK_AVG_SIZE - 1) << 48)
+{
+    // NOTE: a gear table keyed by the access key, the chunk sizes don't reveal known files
+    auto seedDigest = mEncrypter.getDigest(
+        Buffer::fromString("keymaker chunk boundaries"), mEncrypter.getAccessKey().getVersion()
+    );
+
+    std::uint64_t seed = 0;
+
+    for (std::size_t i = 0; i < sizeof(seed); ++i) {
+        seed = (seed << 8) | seedDigest[i];
+    }
+
+    // SplitMix64
+    for (auto &value : mGear) {
+
+        seed += 0x9e3779b97f4a7c15ULL;
+
+        auto z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+        value = z ^ (z >> 31);
+    }
+}
+
+ChunkStore::~ChunkStore()
+{
+
+}
+
+Buffer
+ChunkStore::write(std::istream &input)
+{
+    filesystem::create_directories(mPath);
+
+    std::vector<std::string> ids;
+    std::uint64_t size = 0;
+    std::uint64_t hash = 0;
+
+    Buffer block(READ_BLOCK_SIZE);
+
+    Buffer chunk;
+    chunk.reserve(CHUNK_MAX_SIZE);
+
+    while (input) {
+
+        input.read((char *) block.data(), (std::streamsize) block.size());
+
+        auto count = (std::size_t) input.gcount();
+
+        for (std::size_t i = 0; i < count; ++i) {
+
+            chunk.push_back(block[i]);
+
+            hash = (hash << 1) + mGear[block[i]];
+
+            if ((chunk.size() >= CHUNK_MIN_SIZE && (hash & mMask) == 0) || chunk.size() >= CHUNK_MAX_SIZE) {
+
+                ids.push_back(writeChunk(chunk));
+
+                chunk.clear();
+                hash = 0;
+            }
+        }
+
+        size += count;
+    }
+
+    if (input.bad()) {
+        throw Exception("Failed to read the attachment");
+    }
+
+    if (!chunk.empty()) {
+        ids.push_back(writeChunk(chunk));
+    }
+
+    return toManifest(size, ids);
+}
+
+const ChunkStore &
+ChunkStore::read(const Buffer &manifest, std::ostream &output) const
+{
+    std::uint64_t size = 0, written = 0;
+
+    for (auto &id : fromManifest(manifest, size)) {
+
+        // NOTE: the chunks are loaded one at a time
+        auto chunk = readChunk(id);
+
+        output.write((const char *) chunk.data(), (std::streamsize) chunk.size());
+
+        if (!output) {
+            throw Exception("Failed to write the attachment");
+        }
+
+        written += chunk.size();
+    }
+
+    if (written != size) {
+        throw Exception("The attachment is truncated (%1% of %2% bytes)", written, size);
+    }
+
+    return *this;
+}
+
+Buffer
+ChunkStore::copy(const Buffer &manifest, ChunkStore &target) const
+{
+    std::uint64_t size = 0;
+
+    std::vector<std::string> ids;
+
+    filesystem::create_directories(target.mPath);
+
+    // NOTE: the chunk boundaries are kept, the chunks are encrypted by the target key
+    for (auto &id : fromManifest(manifest, size)) {
+        ids.push_back(target.writeChunk(readChunk(id)));
+    }
+
+    return toManifest(size, ids);
+}
+
+Buffer
+ChunkStore::toManifest(std::uint64_t size, const std::vector<std::string> &ids)
+{
+    std::ostringstream manifest;
+    manifest << ManifestHeader << size << "\n";
+
+    for (auto &id : ids) {
+        manifest << id << "\n";
+    }
+
+    return Buffer::fromString(manifest.str());
+}
+
+std::vector<std::string>
+ChunkStore::fromManifest(const Buffer &manifest, std::uint64_t &size)
+{
+    if (!isManifest(manifest)) {
+        throw Exception("The property is not an attachment");
+    }
+
+    std::istringstream lines(manifest.toString().substr(ManifestHeader.size()));
+
+    std::string line;
+
+    if (!std::getline(lines, line) || !(std::istringstream(line) >> size)) {
+        throw Exception("Malformed attachment manifest");
+    }
+
+    std::vector<std::string> ids;
+
+    while (std::getline(lines, line)) {
+
+        if (!line.empty()) {
+            ids.push_back(line);
+        }
+    }
+
+    return ids;
+}
+
+std::string
+ChunkStore::writeChunk(const Buffer &chunk)
+{
+    auto version = mEncrypter.getAccessKey().getVersion();
+
+    auto id   = mEncrypter.getDigest(chunk, version).toHex<std::string>();
+    auto path = mPath / id;
+
+    // NOTE: the identical chunks are stored once
+    if (filesystem::exists(path)) {
+        return id;
+    }
+
+    auto iv         = Buffer::fromRandom(Encrypter::ENCRYPT_IV_LENGTH);
+    auto ciphertext = mEncrypter.encrypt(chunk, iv);
+
+    std::uint8_t header[4] = {
+        (std::uint8_t) (version >> 24),
+        (std::uint8_t) (version >> 16),
+        (std::uint8_t) (version >> 8),
+        (std::uint8_t) version
+    };
+
+    // NOTE: the entries are copied by several threads, which may share chunks
+    auto tempPath = path;
+    tempPath += "." + Buffer::fromRandom(8).toHex<std::string>() + ".tmp";
+
+    {
+        filesystem::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+        file.write((const char *) header, sizeof(header));
+        file.write((const char *) iv.data(), (std::streamsize) iv.size());
+        file.write((const char *) ciphertext.data(), (std::streamsize) ciphertext.size());
+
+        if (!file) {
+            throw Exception("Failed to write the chunk '%1%'", id);
+        }
+    }
+
+    filesystem::rename(tempPath, path);
+
+    return id;
+}
+
+Buffer
+ChunkStore::readChunk(const std::string &id) const
+{
+    // NOTE: the IDs come from the manifest, they never leave the chunk directory
+    if (id.size() != 2 * ID_LENGTH || id.find_first_not_of("0123456789ABCDEF") != std::string::npos) {
+        throw Exception("Malformed chunk ID '%1%'", id);
+    }
+
+    auto path = mPath / id;
+
+    if (!filesystem::exists(path)) {
+        throw Exception("Missing chunk '%1%' (see `km fetch`)", id);
+    }
+
+    filesystem::ifstream file(path, std::ios::binary);
+
+    Buffer data((std::size_t) filesystem::file_size(path));
+    file.read((char *) data.data(), (std::streamsize) data.size());
+
+    if (!file || data.size() < 4 + Encrypter::ENCRYPT_IV_LENGTH) {
+        throw Exception("Corrupted chunk '%1%'", id);
+    }
+
+    unsigned int version = ((unsigned int) data[0] << 24)
+                         | ((unsigned int) data[1] << 16)
+                         | ((unsigned int) data[2] << 8)
+                         |  (unsigned int) data[3];
+
+    Buffer iv(data.begin() + 4, data.begin() + 4 + Encrypter::ENCRYPT_IV_LENGTH);
+    Buffer ciphertext(data.begin() + 4 + Encrypter::ENCRYPT_IV_LENGTH, data.end());
+
+    auto chunk = mEncrypter.decrypt(ciphertext, iv, version);
+
+    if (mEncrypter.getDigest(chunk, version).toHex<std::string>() != id) {
+        throw Exception("Corrupted chunk '%1%'", id);
+    }
+
+    return chunk;
+}
+
+} // End of main namespace
@@ -16,12 +16,23 @@ std::map<const std::string, CommandLine::CommandParserMethod> CommandLine::mComm
 {
     { "config",  &CommandLine::runConfig  },
     { "list",    &CommandLine::runList    },
+    { "find",    &CommandLine::runFind    },
     { "create",  &CommandLine::runCreate  },
     { "open",    &CommandLine::runOpen    },
     { "share",   &CommandLine::runShare   },
+    { "group",   &CommandLine::runGroup   },
+    { "rotate",  &CommandLine::runRotate  },
+    { "copy",    &CommandLine::runCopy    },
+    { "attachment", &CommandLine::runAttachment },
     { "commit",  &CommandLine::runCommit  },
     { "push",    &CommandLine::runPush    },
     { "fetch",   &CommandLine::runFetch   },
+    { "compact", &CommandLine::runCompact },
+    { "verify",  &CommandLine::runVerify  },
+    { "master",  &CommandLine::runMaster  },
+    { "agent",   &CommandLine::runAgent   },
+    { "get",     &CommandLine::runGet     },
+    { "set",     &CommandLine::runSet     },
     { "log",     &CommandLine::runLog     },
     { "destroy", &CommandLine::runDestroy }
 };
@@ -121,6 +132,12 @@ CommandLine::authenticate()
             auto passphrase = promptSecret(message);
             mCore.authenticate(passphrase);
 
+            // NOTE: the rejected pushes aren't retried, their commits are only local
+            for (auto &failure : mCore.getPushFailures()) {
+                std::cerr << "km: the push of " << failure.first << " was rejected (" << failure.second << "), "
+                          << "fetch and push it again\n";
+            }
+
             return;
 
         } catch (Exception &e) {
@@ -181,7 +198,8 @@ CommandLine::runList(const CommandArgs &args)
     // Usage description
     po::options_description usage("Usage: km list [OPTIONS]");
     usage.add_options()
-        ("help,h", "Show this help message")
+        ("cached,c", "Read the local catalog instead of the keyrings")
+        ("help,h",   "Show this help message"                        )
     ;
 
     // All arguments
@@ -202,6 +220,20 @@ CommandLine::runList(const CommandArgs &args)
 
         std::size_t index = 0;
 
+        if (vm.count("cached")) {
+
+            mCore.eachCatalogRepository([&index](const Buffer &id, const Buffer &name, std::size_t numOfEntries) {
+
+                std::cout
+                    << "> " << index++ << ") "
+                    << name
+                    << " [" << numOfEntries << " entries]"
+                    << std::endl;
+            });
+
+            return;
+        }
+
         mCore.eachKeyring([this, &index](const Buffer &id, KeyringNode &keyringNode) {
 
             auto nameProperty = keyringNode.getProperty("name");
@@ -215,6 +247,68 @@ CommandLine::runList(const CommandArgs &args)
     }
 }
 
+void
+CommandLine::runFind(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km find [OPTIONS] <ENTRY>");
+    usage.add_options()
+        ("reindex,r", "Rebuild the local catalog first")
+        ("help,h",    "Show this help message"         )
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("entry", po::value<std::string>(), "The entry ID or name")
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("entry", 1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help") || !vm.count("entry")) {
+        std::cerr << usage;
+
+    } else {
+
+        authenticate();
+
+        if (vm.count("reindex")) {
+            mCore.indexRepositories();
+        }
+
+        auto repositories = mCore.locateEntry(
+            Buffer::fromString(vm["entry"].as<std::string>())
+        );
+
+        if (repositories.empty()) {
+            throwError("km: entry not found");
+        }
+
+        // NOTE: the catalog is already loaded by the lookup
+        mCore.eachCatalogRepository([&repositories](const Buffer &id, const Buffer &name, std::size_t numOfEntries) {
+
+            if (std::find(repositories.begin(), repositories.end(), id) != repositories.end()) {
+                std::cout << "> " << name << " [" << id << "]" << std::endl;
+            }
+        });
+    }
+}
+
 void
 CommandLine::runCreate(const CommandArgs &args)
 {
@@ -256,7 +350,10 @@ CommandLine::runCreate(const CommandArgs &args)
 
         authenticate();
 
-        mCore.createRepository(name);
+        mCore
+            .createRepository(name)
+            .flush()
+        ;
     }
 }
 
@@ -315,22 +412,23 @@ CommandLine::runShare(const CommandArgs &args)
     namespace po = boost::program_options;
 
     // Usage description
-    po::options_description usage("Usage: km share [OPTIONS] <REPOSITORY> <USER>");
+    po::options_description usage("Usage: km share [OPTIONS] <REPOSITORY> <USER>...");
     usage.add_options()
-        ("help,h", "Show this help message")
+        ("group,g", "Share with a group (<USER> is the group ID)")
+        ("help,h",  "Show this help message"                      )
     ;
 
     // Positional arguments
     po::options_description hidden("Hidden options");
     hidden.add_options()
-        ("repository_id", po::value<std::string>(), "The repository ID")
-        ("user_id",       po::value<std::string>(), "The user ID"      )
+        ("repository_id", po::value<std::string>(),              "The repository ID")
+        ("user_id",       po::value<std::vector<std::string>>(), "The user IDs"     )
     ;
 
     po::positional_options_description positional;
     positional
-        .add("repository_id", 1)
-        .add("user_id",       1)
+        .add("repository_id",  1)
+        .add("user_id",       -1)
     ;
 
     // All arguments
@@ -349,39 +447,54 @@ CommandLine::runShare(const CommandArgs &args)
     } else if (vm.count("repository_id") && vm.count("user_id")) {
 
         auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
-        auto userId = Buffer::fromString(vm["user_id"].as<std::string>());
+
+        std::vector<Buffer> userIds;
+
+        for (auto &userId : vm["user_id"].as<std::vector<std::string>>()) {
+            userIds.push_back(Buffer::fromString(userId));
+        }
 
         authenticate();
 
-        mCore
-            .openRepository(repositoryId)
-            .shareRepository(userId)
-        ;
+        mCore.openRepository(repositoryId);
+
+        if (vm.count("group")) {
+
+            for (auto &groupId : userIds) {
+                mCore.shareRepositoryWithGroup(groupId);
+            }
+
+        } else {
+
+            // NOTE: the users are added with a single commit and push
+            mCore.shareRepository(userIds);
+        }
+
+        mCore.flush();
     }
 }
 
 void
-CommandLine::runCommit(const CommandArgs &args)
+CommandLine::runRotate(const CommandArgs &args)
 {
     namespace po = boost::program_options;
 
     // Usage description
-    po::options_description usage("Usage: km commit [OPTIONS] <REPOSITORY> <COMMIT_MESSAGE>");
+    po::options_description usage("Usage: km rotate [OPTIONS] <REPOSITORY>");
     usage.add_options()
-        ("help,h", "Show this help message")
+        ("revoke,r", po::value<std::vector<std::string>>(), "Revoke the access of a user")
+        ("help,h",                                          "Show this help message"     )
     ;
 
     // Positional arguments
     po::options_description hidden("Hidden options");
     hidden.add_options()
-        ("repository_id", po::value<std::string>(), "The repository ID" )
-        ("message",       po::value<std::string>(), "The commit message")
+        ("repository_id", po::value<std::string>(), "The repository ID")
     ;
 
     po::positional_options_description positional;
     positional
         .add("repository_id", 1)
-        .add("message",       1)
     ;
 
     // All arguments
@@ -397,27 +510,198 @@ CommandLine::runCommit(const CommandArgs &args)
     if (vm.count("help")) {
         std::cerr << usage;
 
-    } else if (vm.count("repository_id") && vm.count("message")) {
+    } else if (vm.count("repository_id")) {
 
         auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
-        auto message      = Buffer::fromString(vm["message"].as<std::string>());
+
+        std::vector<Buffer> revokedUserIds;
+
+        if (vm.count("revoke")) {
+
+            for (auto &userId : vm["revoke"].as<std::vector<std::string>>()) {
+                revokedUserIds.push_back(Buffer::fromString(userId));
+            }
+        }
+
+        authenticate();
+
+        mCore.openRepository(repositoryId);
+
+        // NOTE: an interrupted rotation resumes from its last batch
+        mCore.rotateRepository(revokedUserIds);
+
+        mCore.flush();
+    }
+}
+
+void
+CommandLine::runCopy(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km copy [OPTIONS] <SOURCE> <TARGET> [<ENTRY>...]");
+    usage.add_options()
+        ("move,m", "Remove the entries from the source repository")
+        ("help,h", "Show this help message"                        )
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("source_id", po::value<std::string>(),              "The source repository ID")
+        ("target_id", po::value<std::string>(),              "The target repository ID")
+        ("entry",     po::value<std::vector<std::string>>(), "The entries"             )
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("source_id",  1)
+        .add("target_id",  1)
+        .add("entry",     -1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("source_id") && vm.count("target_id")) {
+
+        auto sourceId = mInterpreter.parseRepository(vm["source_id"].as<std::string>());
+        auto targetId = mInterpreter.parseRepository(vm["target_id"].as<std::string>());
 
         authenticate();
 
+        mCore.openRepository(sourceId);
+
+        // NOTE: without entries, the whole repository is copied
+        std::vector<Buffer> entryIds;
+
+        if (vm.count("entry")) {
+
+            for (auto &entry : vm["entry"].as<std::vector<std::string>>()) {
+                entryIds.push_back(mInterpreter.parseEntry(entry));
+            }
+        }
+
+        mCore.copyRepositoryEntries(targetId, entryIds, vm.count("move") > 0);
+
+        mCore.flush();
+    }
+}
+
+void
+CommandLine::runAttachment(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km attachment [OPTIONS] (put | get) <REPOSITORY> <ENTRY> <PROPERTY> [<FILE>]");
+    usage.add_options()
+        ("help,h", "Show this help message")
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("action",        po::value<std::string>(), "The action to run"   )
+        ("repository_id", po::value<std::string>(), "The repository ID"   )
+        ("entry",         po::value<std::string>(), "The entry ID or name")
+        ("property",      po::value<std::string>(), "The property name"   )
+        ("file",          po::value<std::string>(), "The file path"       )
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("action",        1)
+        .add("repository_id", 1)
+        .add("entry",         1)
+        .add("property",      1)
+        .add("file",          1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    auto action = vm.count("action") ? vm["action"].as<std::string>() : std::string();
+
+    // NOTE: without a file, the content is read from stdin (or written to stdout)
+    auto path = vm.count("file") ? vm["file"].as<std::string>() : std::string("-");
+
+    if (vm.count("help") || !vm.count("property") || (action != "put" && action != "get")) {
+        std::cerr << usage;
+        return;
+    }
+
+    auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+    auto property     = Buffer::fromString(vm["property"].as<std::string>());
+
+    authenticate();
+
+    mCore.openRepository(repositoryId);
+
+    auto entryId = mInterpreter.parseEntry(vm["entry"].as<std::string>());
+
+    if (action == "put") {
+
+        filesystem::ifstream file;
+
+        if (path != "-") {
+
+            file.open(path, std::ios::binary);
+
+            if (!file) {
+                throwError("km: unable to read '" + path + "'");
+            }
+        }
+
         mCore
-            .openRepository(repositoryId)
-            .commitRepository(message)
+            .setRepositoryAttachment(entryId, property, path != "-" ? file : std::cin)
+            .commitRepository(Buffer::fromString("Attach " + vm["property"].as<std::string>()))
+            .pushRepository()
+            .flush()
         ;
+
+    } else {
+
+        filesystem::ofstream file;
+
+        if (path != "-") {
+
+            file.open(path, std::ios::binary | std::ios::trunc);
+
+            if (!file) {
+                throwError("km: unable to write '" + path + "'");
+            }
+        }
+
+        mCore.getRepositoryAttachment(entryId, property, path != "-" ? file : std::cout);
     }
 }
 
 void
-CommandLine::runPush(const CommandArgs &args)
+CommandLine::runGroup(const CommandArgs &args)
 {
     namespace po = boost::program_options;
 
     // Usage description
-    po::options_description usage("Usage: km push [OPTIONS] <REPOSITORY>");
+    po::options_description usage("Usage: km group [OPTIONS] (create <NAME> | add <GROUP> <USER>)");
     usage.add_options()
         ("help,h", "Show this help message")
     ;
@@ -425,12 +709,14 @@ CommandLine::runPush(const CommandArgs &args)
     // Positional arguments
     po::options_description hidden("Hidden options");
     hidden.add_options()
-        ("repository_id", po::value<std::string>(), "The repository ID")
+        ("action",    po::value<std::string>(),              "The action to run"    )
+        ("arguments", po::value<std::vector<std::string>>(), "The action arguments" )
     ;
 
     po::positional_options_description positional;
     positional
-        .add("repository_id", 1)
+        .add("action",     1)
+        .add("arguments", -1)
     ;
 
     // All arguments
@@ -443,40 +729,504 @@ CommandLine::runPush(const CommandArgs &args)
     // Execute the command
     po::variables_map vm = parseCommandArguments(args, options, positional);
 
+    std::vector<std::string> arguments;
+
+    if (vm.count("arguments")) {
+        arguments = vm["arguments"].as<std::vector<std::string>>();
+    }
+
+    auto action = vm.count("action") ? vm["action"].as<std::string>() : std::string();
+
     if (vm.count("help")) {
         std::cerr << usage;
 
-    } else if (vm.count("repository_id")) {
+    } else if (action == "create" && arguments.size() == 1) {
 
-        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+        authenticate();
+
+        mCore
+            .createGroup(Buffer::fromString(arguments[0]))
+            .flush()
+        ;
+
+    } else if (action == "add" && arguments.size() == 2) {
 
         authenticate();
 
         mCore
-            .openRepository(repositoryId)
-            .pushRepository()
+            .addGroupMember(Buffer::fromString(arguments[0]), Buffer::fromString(arguments[1]))
+            .flush()
         ;
+
+    } else {
+        std::cerr << usage;
     }
 }
 
 void
-CommandLine::runFetch(const CommandArgs &args)
+CommandLine::runCommit(const CommandArgs &args)
 {
-    /*
-    // TODO: improve this
-    if (args.size() != 2) {
-        throwError("Invalid number of arguments");
-    }
+    namespace po = boost::program_options;
 
-    auto repositoryId = mInterpreter.parseRepository(args[1]);
+    // Usage description
+    po::options_description usage("Usage: km commit [OPTIONS] <REPOSITORY> <COMMIT_MESSAGE>");
+    usage.add_options()
+        ("help,h", "Show this help message")
+    ;
 
-    authenticate();
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("repository_id", po::value<std::string>(), "The repository ID" )
+        ("message",       po::value<std::string>(), "The commit message")
+    ;
 
-    mCore
-        .openRepository(repositoryId)
-        .fetchRepository()
+    po::positional_options_description positional;
+    positional
+        .add("repository_id", 1)
+        .add("message",       1)
     ;
-    */
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("repository_id") && vm.count("message")) {
+
+        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+        auto message      = Buffer::fromString(vm["message"].as<std::string>());
+
+        authenticate();
+
+        mCore
+            .openRepository(repositoryId)
+            .commitRepository(message)
+        ;
+    }
+}
+
+void
+CommandLine::runPush(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km push [OPTIONS] <REPOSITORY>");
+    usage.add_options()
+        ("help,h", "Show this help message")
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("repository_id", po::value<std::string>(), "The repository ID")
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("repository_id", 1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("repository_id")) {
+
+        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+
+        authenticate();
+
+        mCore
+            .openRepository(repositoryId)
+            .pushRepository()
+            .flush()
+        ;
+    }
+}
+
+void
+CommandLine::runFetch(const CommandArgs &args)
+{
+    /*
+    // TODO: improve this
+    if (args.size() != 2) {
+        throwError("Invalid number of arguments");
+    }
+
+    auto repositoryId = mInterpreter.parseRepository(args[1]);
+
+    authenticate();
+
+    mCore
+        .openRepository(repositoryId)
+        .fetchRepository()
+    ;
+    */
+}
+
+void
+CommandLine::runCompact(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km compact [OPTIONS] <REPOSITORY>");
+    usage.add_options()
+        ("retention,r", po::value<int>(), "The days of history to keep")
+        ("help,h",                        "Show this help message"     )
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("repository_id", po::value<std::string>(), "The repository ID")
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("repository_id", 1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("repository_id")) {
+
+        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+
+        int retention = mCore.getHistoryRetention();
+
+        if (vm.count("retention")) {
+            retention = vm["retention"].as<int>();
+        }
+
+        authenticate();
+
+        mCore
+            .openRepository(repositoryId)
+            .compactRepository(retention)
+        ;
+    }
+}
+
+void
+CommandLine::runVerify(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km verify [OPTIONS] <REPOSITORY> [REVISION]");
+    usage.add_options()
+        ("help,h", "Show this help message")
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("repository_id", po::value<std::string>(), "The repository ID"         )
+        ("revision",      po::value<std::string>(), "The revision to compare to")
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("repository_id", 1)
+        .add("revision",      1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("repository_id")) {
+
+        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+
+        authenticate();
+
+        mCore.openRepository(repositoryId);
+
+        if (vm.count("revision")) {
+
+            auto revision = Buffer::fromString(vm["revision"].as<std::string>());
+
+            for (auto &id : mCore.diffRepository(revision)) {
+                std::cout << "> " << termcolor::yellow << id << termcolor::reset << std::endl;
+            }
+
+            return;
+        }
+
+        auto failures = mCore.verifyRepository();
+
+        for (auto &id : failures) {
+            std::cout << "> " << termcolor::red << id << termcolor::reset << std::endl;
+        }
+
+        if (!failures.empty()) {
+            throwError("Integrity check failed for " + std::to_string(failures.size()) + " entries");
+        }
+    }
+}
+
+void
+CommandLine::runMaster(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km master [OPTIONS]");
+    usage.add_options()
+        ("idle,i", po::value<int>(), "The seconds without requests before exiting")
+        ("help,h",                   "Show this help message"                     )
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options);
+
+    if (vm.count("help")) {
+        std::cout << usage;
+
+    } else {
+
+        int idleTimeout = ShellMaster::IDLE_TIMEOUT;
+
+        if (vm.count("idle")) {
+            idleTimeout = vm["idle"].as<int>();
+        }
+
+        authenticate();
+
+        mCore.serveShell(std::chrono::seconds(idleTimeout));
+    }
+}
+
+void
+CommandLine::runAgent(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km agent [OPTIONS]");
+    usage.add_options()
+        ("idle,i", po::value<int>(), "The seconds without requests before locking")
+        ("lock,l",                   "Lock the running agent"                     )
+        ("no-lock",                  "Run without locking the memory (swappable)" )
+        ("help,h",                   "Show this help message"                     )
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options);
+
+    if (vm.count("help")) {
+        std::cout << usage;
+
+    } else if (vm.count("lock")) {
+
+        IpcChannel::Message response;
+
+        if (!mCore.requestAgent({ Buffer::fromString("lock") }, response)) {
+            throwError("km: the agent is not running");
+        }
+
+    } else {
+
+        int idleTimeout = KeyAgent::IDLE_TIMEOUT;
+
+        if (vm.count("idle")) {
+            idleTimeout = vm["idle"].as<int>();
+        }
+
+        authenticate();
+
+        mCore.serveAgent(std::chrono::seconds(idleTimeout), !vm.count("no-lock"));
+    }
+}
+
+void
+CommandLine::runGet(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km get [OPTIONS] <REPOSITORY> [ENTRY] [PROPERTY]");
+    usage.add_options()
+        ("help,h", "Show this help message")
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("repository_id", po::value<std::string>(), "The repository ID"    )
+        ("entry",         po::value<std::string>(), "The entry ID or name" )
+        ("property",      po::value<std::string>(), "The property name"    )
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("repository_id", 1)
+        .add("entry",         1)
+        .add("property",      1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("repository_id")) {
+
+        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+
+        IpcChannel::Message request = { Buffer::fromString("get"), repositoryId };
+
+        if (!vm.count("entry")) {
+            request[0] = Buffer::fromString("list");
+        } else {
+            request.push_back(Buffer::fromString(vm["entry"].as<std::string>()));
+        }
+
+        if (vm.count("property")) {
+            request.push_back(Buffer::fromString(vm["property"].as<std::string>()));
+        }
+
+        IpcChannel::Message response;
+
+        if (!mCore.requestAgent(request, response)) {
+            throwError("km: the agent is not running (start it with 'km agent')");
+        }
+
+        if (request.size() == 2) {
+            std::cout << response.at(0);
+
+        } else if (request.size() == 4) {
+            std::cout << response.at(0) << std::endl;
+
+        } else {
+            for (std::size_t i = 0; i + 1 < response.size(); i += 2) {
+                std::cout << response[i] << ": " << response[i + 1] << std::endl;
+            }
+        }
+    }
+}
+
+void
+CommandLine::runSet(const CommandArgs &args)
+{
+    namespace po = boost::program_options;
+
+    // Usage description
+    po::options_description usage("Usage: km set [OPTIONS] <REPOSITORY> <ENTRY> <PROPERTY>");
+    usage.add_options()
+        ("help,h", "Show this help message")
+    ;
+
+    // Positional arguments
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("repository_id", po::value<std::string>(), "The repository ID"    )
+        ("entry",         po::value<std::string>(), "The entry ID or name" )
+        ("property",      po::value<std::string>(), "The property name"    )
+    ;
+
+    po::positional_options_description positional;
+    positional
+        .add("repository_id", 1)
+        .add("entry",         1)
+        .add("property",      1)
+    ;
+
+    // All arguments
+    po::options_description options("Allowed options");
+    options
+        .add(hidden)
+        .add(usage)
+    ;
+
+    // Execute the command
+    po::variables_map vm = parseCommandArguments(args, options, positional);
+
+    if (vm.count("help")) {
+        std::cerr << usage;
+
+    } else if (vm.count("property")) {
+
+        auto repositoryId = mInterpreter.parseRepository(vm["repository_id"].as<std::string>());
+
+        // NOTE: the value is never passed on the command line
+        auto value = promptSecret(Buffer::fromString(vm["property"].as<std::string>() + ": "));
+
+        IpcChannel::Message response;
+
+        bool running = mCore.requestAgent({
+            Buffer::fromString("set"),
+            repositoryId,
+            Buffer::fromString(vm["entry"].as<std::string>()),
+            Buffer::fromString(vm["property"].as<std::string>()),
+            value
+        }, response);
+
+        if (!running) {
+            throwError("km: the agent is not running (start it with 'km agent')");
+        }
+    }
 }
 
 void
@@ -60,6 +60,8 @@ promptSecret()
 
 bool Console::mDebug = true;
 
+thread_local bool Console::mQuiet = false;
+
 TaskTracker::TaskTracker(const std::string &agent, const std::string &description)
 :
     mAgent(agent),
@@ -68,7 +70,7 @@ TaskTracker::TaskTracker(const std::string &agent, const std::string &descriptio
 {
     spdlog::get("km")->info(mDescription);
 
-    if (!Console::getDebug()) {
+    if (!Console::getDebug() || Console::getQuiet()) {
         return;
     }
 
@@ -91,6 +93,10 @@ TaskTracker::~TaskTracker()
         done();
     }
 
+    if (Console::getQuiet()) {
+        return;
+    }
+
     std::cout
         << "\r"
         << " "
@@ -107,7 +113,7 @@ TaskTracker::done()
 {
     mProcessed = true;
 
-    if (!Console::getDebug()) {
+    if (!Console::getDebug() || Console::getQuiet()) {
         return;
     }
 
@@ -131,7 +137,7 @@ TaskTracker::fail()
 
     spdlog::get("km")->error(mDescription);
 
-    if (!Console::getDebug()) {
+    if (!Console::getDebug() || Console::getQuiet()) {
         return;
     }
 
@@ -25,10 +25,16 @@ Core::Core()
     setUpLogger();
 
     loadRepositories();
+
+    mPushQueue = std::make_unique<PushQueue>(
+        mHomePath / ".km/push-queue", std::vector<filesystem::path>({ mKeyringPath, mGroupPath })
+    );
 }
 
 Core::~Core()
 {
+    mPushQueue.reset();
+
     git_libgit2_shutdown();
     libssh2_exit();
 
@@ -56,6 +62,12 @@ Core::loadPath()
 
     // Get the path to the keyrings
     mKeyringPath = mHomePath / ".km/keyrings";
+
+    // Get the path to the group keyrings
+    mGroupPath   = mHomePath / ".km/groups";
+
+    // Get the path to the key rotations in progress
+    mRotationPath = mHomePath / ".km/rotations";
 }
 
 void
@@ -66,7 +78,9 @@ Core::loadConfig()
     {
         mHomePath / ".km",
         mHomePath / ".km/logs",
-        mHomePath / ".km/keyrings"
+        mHomePath / ".km/keyrings",
+        mHomePath / ".km/groups",
+        mHomePath / ".km/rotations"
     };
 
     for (auto &path : directoryPaths) {
@@ -84,6 +98,11 @@ Core::loadConfig()
     for (auto &node : mConfig.get_child("security")) {
         mEnvironment[node.first] = node.second.get_value<std::string>();
     }
+
+    // NOTE: a larger size class hides more of the short values
+    Encrypter::setPaddingSize(
+        mConfig.get<std::size_t>("security.padding_size", Encrypter::PADDING_SIZE)
+    );
 }
 
 void
@@ -107,6 +126,33 @@ Core::authenticate(const Buffer &passphrase)
 
     mPublicKey = PublicKey::fromPrivateKey(mPrivateKey);
 
+    mWrappingKey.reset();
+
+    // NOTE: the X25519 key is protected by the same passphrase
+    if (mEnvironment.count("wrapping_key")) {
+
+        filesystem::path wrappingKeyPath = any_cast<std::string>(mEnvironment["wrapping_key"]);
+
+        mWrappingKey = std::make_unique<PrivateKey>(
+            PrivateKey::fromPath(filesystem::canonical(wrappingKeyPath, mHomePath), passphrase)
+        );
+
+        if (mWrappingKey->getAlgorithm() != RsaKey::ALGORITHM_X25519) {
+            throw Exception("The wrapping key must be an X25519 key");
+        }
+    }
+
+    if (!mPrivateKey.canWrap() && !mWrappingKey) {
+        throw Exception("The Ed25519 and ECDSA keys need an X25519 wrapping key (`security.wrapping_key`)");
+    }
+
+    // NOTE: the buffers are wiped on release
+    mUnlockedKeys.clear();
+    mCatalog.reset();
+
+    // Resume the pending pushes
+    mPushQueue->start(mPrivateKey);
+
     return *this;
 }
 
@@ -127,30 +173,22 @@ Core::openRepository(const Buffer &repositoryId)
 Core &
 Core::createRepository(const Buffer &name)
 {
-    auto &shell = getShell();
-
-    Buffer response = shell.exec("repository-create --name='%1%'", name);
-
-    if (shell.getReturnCode() != 0) {
-        throw Exception("Failure creating the repository");
-    }
-
-    std::istringstream ss((char *) response.data());
+    Buffer repositoryId;
 
-    property_tree::ptree responseTree;
-    property_tree::read_json(ss, responseTree);
+    auto status = execShell(format_buffer("repository-create --name='%1%'", name), [&repositoryId](const JsonReader::Path &path, const std::string &value) {
 
-    auto status  = responseTree.get("status", 500);
-    auto content = responseTree.get_child("content");
+        if (path.size() == 2 && path[1] == "id") {
+            repositoryId = Buffer::fromString(value);
+        }
+    });
 
     if (status != 201) {
-        throw Exception("Failed: status code " + responseTree.get<std::string>("status"));
+        throw Exception("Failed: status code %1%", status);
     }
 
-    auto repositoryId = Buffer::fromString(
-        content.get<std::string>("id")
-    );
-
+    if (repositoryId.empty()) {
+        throw Exception("Failure creating the repository");
+    }
 
     buildGitRepository(repositoryId, name);
     parseRepository();
@@ -161,10 +199,13 @@ Core::createRepository(const Buffer &name)
 
     auto &repository = getRepository();
 
-    repository
-        .commit(textNode.toBuffer())
-        .push()
-    ;
+    repository.commit(textNode.toBuffer());
+
+    mPushQueue->enqueue(repository.getId());
+
+    updateCatalog([this, &repository](Catalog &catalog) {
+        indexKeyring(catalog, repository.getId(), *mKeyringNode);
+    });
 
     return *this;
 }
@@ -186,376 +227,1300 @@ Core::updateRepository(const Buffer &name)
 
 Core &
 Core::shareRepository(const Buffer &userId)
+{
+    return shareRepository(std::vector<Buffer>({ userId }));
+}
+
+Core &
+Core::shareRepository(const std::vector<Buffer> &userIds)
 {
     auto &repository = getRepository();
     auto &shell      = getShell();
 
-    Buffer response;
+    std::vector<PublicKey> publicKeys;
 
-    response = shell.exec("user-show '%1%'", userId);
-
-    if (shell.getReturnCode() != 0) {
-        throw Exception("Failure getting the user");
+    for (auto &userKeys : getUserKeys(userIds)) {
+        publicKeys.insert(publicKeys.end(), userKeys.begin(), userKeys.end());
     }
 
-    std::istringstream ss((char *) response.data());
+    // NOTE: the permissions are granted concurrently, on the channels of the same session
+    std::vector<std::future<SshClient::Result>> results;
 
-    property_tree::ptree responseTree;
-    property_tree::read_json(ss, responseTree);
+    for (auto &userId : userIds) {
 
-    auto status  = responseTree.get("status", 500);
-    auto content = responseTree.get_child("content");
-
-    if (status != 200) {
-        throw Exception("Failed: status code " + responseTree.get<std::string>("status"));
+        // TODO: allow other permission types
+        results.push_back(
+            shell.execAsync(format_buffer("repository-share '%1%' '%2%' --read", repository.getId(), userId))
+        );
     }
 
-    auto pkcsKey = Buffer::fromString(
-        content.get<std::string>("pkcsKey")
-    );
-
-    PublicKey publicKey = PublicKey::fromMemory(pkcsKey);
+    shell.run();
 
-    // TODO: allow other permission types
-    response = shell.exec("repository-share '%1%' '%2%' --read", repository.getId(), userId);
+    for (auto &result : results) {
 
-    if (shell.getReturnCode() != 0) {
-        throw Exception("Failure sharing the repository");
+        if (result.get().returnCode != 0) {
+            throw Exception("Failure sharing the repository");
+        }
     }
 
-    shareGitRepository(repository, publicKey);
+    shareGitRepository(repository, createAccessKeys(mEncrypter->getAccessKey(), publicKeys));
 
     auto textNode = mEncrypter->encrypt<TextNode>(
         TextNode::create(Buffer::fromString("Shared repository"))
     );
 
-    repository
-        .commit(textNode.toBuffer())
-        .push()
-    ;
+    repository.commit(textNode.toBuffer());
+
+    mPushQueue->enqueue(repository.getId());
 
     return *this;
 }
 
 Core &
-Core::setRepositoryEntry(const EntryNode &input)
+Core::shareRepositoryWithGroup(const Buffer &groupId)
 {
     auto &repository = getRepository();
-    auto &keyring    = getKeyring();
+    auto &shell      = getShell();
 
-    auto output = mEncrypter->encrypt<EntryNode>(input);
+    auto group = getGroupRepository(groupId);
 
-    keyring
-        .setEntry(output)
-        .save(repository.getPath())
-    ;
+    shell.exec("repository-share '%1%' '%2%' --read --group", repository.getId(), groupId);
 
-    loadEntries();
+    if (shell.getReturnCode() != 0) {
+        throw Exception("Failure sharing the repository");
+    }
 
-    return *this;
-}
+    auto &groupEncrypter = unlockKeyring(groupId, KeyringNode::fromPath(group.getPath()));
 
-EntryNode
-Core::getRepositoryEntry(const Buffer &id)
-{
-    return mEncrypter->decrypt<EntryNode>(
-        mKeyringNode->getEntry(id)
+    // NOTE: a symmetric wrap, the members unwrap the group key instead
+    auto accessKey = groupEncrypter.encrypt<AccessKey>(
+        AccessKey::create(Encrypter::getGroupFingerprint(groupId), mEncrypter->getAccessKey().getData())
+            .setVersion(mEncrypter->getAccessKey().getVersion())
     );
-}
 
-Core &
-Core::eachRepositoryEntry(std::function<void (const Buffer &id, EntryNode &)> callback)
-{
-    auto &keyring = getKeyring();
+    shareGitRepository(repository, std::vector<AccessKey>({ accessKey }));
 
-    keyring.eachEntry([this, &callback](const Buffer &id, const EntryNode &input) {
+    auto textNode = mEncrypter->encrypt<TextNode>(
+        TextNode::create(Buffer::fromString("Shared repository with group"))
+    );
 
-        auto output = input.mapProperty([this](const Buffer &name, const PropertyNode &property) {
-            return mEncrypter->decrypt<PropertyNode>(property);
-        });
+    repository.commit(textNode.toBuffer());
 
-        callback(id, output);
-    });
+    mPushQueue->enqueue(repository.getId());
 
     return *this;
 }
 
 Core &
-Core::commitRepository(const Buffer &message)
+Core::createGroup(const Buffer &name)
 {
-    auto &repository = getRepository();
+    Buffer groupId;
 
-    auto textNode = mEncrypter->encrypt<TextNode>(
-        TextNode::create(message)
+    auto status = execShell(format_buffer("group-create --name='%1%'", name), [&groupId](const JsonReader::Path &path, const std::string &value) {
+
+        if (path.size() == 2 && path[1] == "id") {
+            groupId = Buffer::fromString(value);
+        }
+    });
+
+    if (status != 201) {
+        throw Exception("Failed: status code %1%", status);
+    }
+
+    if (groupId.empty()) {
+        throw Exception("Failure creating the group");
+    }
+
+    auto repository = Repository::create(groupId, mGroupPath / groupId.toString(), mPrivateKey);
+
+    auto keyring = createKeyring(name, mPublicKey);
+    keyring.setProperty("name", name);
+
+    auto &encrypter = unlockKeyring(groupId, keyring);
+
+    encrypter
+        .encrypt<KeyringNode>(keyring)
+        .save(repository.getPath(), encrypter)
+    ;
+
+    auto textNode = encrypter.encrypt<TextNode>(
+        TextNode::create(Buffer::fromString("Initial commit"))
     );
 
     repository
+        .add("keymaker.xml")
+        .add("access/*")
         .add("entries/*")
-        .update("entries/*")
+        .add(MerkleTree::TreeFile)
         .commit(textNode.toBuffer())
     ;
 
+    mPushQueue->enqueue(groupId);
+
     return *this;
 }
 
 Core &
-Core::pushRepository()
+Core::addGroupMember(const Buffer &groupId, const Buffer &userId)
 {
-    auto &repository = getRepository();
-    repository.push();
+    auto &shell = getShell();
 
-    return *this;
-}
+    auto repository = getGroupRepository(groupId);
 
-Core &
-Core::fetchRepository()
-{
-    auto &repository = getRepository();
-    repository.fetch();
+    auto publicKeys = getUserKeys(std::vector<Buffer>({ userId })).front();
 
-    return *this;
-}
+    // NOTE: the member gains access to the repositories shared with the group
+    shell.exec("group-add '%1%' '%2%'", groupId, userId);
 
-Core &
-Core::eachRepositoryLogs(const std::string &range, std::function<void (const Buffer &id, const Commit &)> callback)
-{
-    mRepository->eachCommits(range, [this, &callback](const Buffer &id, const Commit &input) {
+    if (shell.getReturnCode() != 0) {
+        throw Exception("Failure adding the group member");
+    }
 
-        auto textNode = mEncrypter->decrypt<TextNode>(
-                TextNode::fromBuffer(input.getSummary())
-        );
+    auto &encrypter = unlockKeyring(groupId, KeyringNode::fromPath(repository.getPath()));
 
-        Commit ouput = input;
-        ouput.setSummary(textNode.getContent());
+    shareGitRepository(repository, createAccessKeys(encrypter.getAccessKey(), publicKeys));
 
-        callback(id, ouput);
-    });
+    auto textNode = encrypter.encrypt<TextNode>(
+        TextNode::create(Buffer::fromString("Added group member"))
+    );
+
+    repository.commit(textNode.toBuffer());
+
+    mPushQueue->enqueue(groupId);
 
     return *this;
 }
 
 Core &
-Core::destroyRepository()
+Core::rotateRepository(const std::vector<Buffer> &revokedUserIds)
 {
     auto &repository = getRepository();
-    auto &shell      = getShell();
 
-    Buffer response = shell.exec("repository-delete '%1%'", repository.getId());
+    if (filesystem::exists(getRotationPath(repository.getId()))) {
 
-    if (shell.getReturnCode() != 0) {
-        throw Exception("Failure deleting the repository");
+        if (!revokedUserIds.empty()) {
+            throw Exception("A key rotation of the repository is in progress, resume it first");
+        }
+
+        // NOTE: the last batch of an interrupted rotation may be left uncommitted
+        commitKeyring(Buffer::fromString("Resumed key rotation"));
+
+    } else {
+        rotateAccessKey(revokedUserIds);
     }
 
-    repository.destroy();
+    reencryptEntries();
 
     return *this;
 }
 
+Core &
+Core::setRepositoryEntry(const EntryNode &input)
+{
+    auto &repository = getRepository();
+    auto &keyring    = getKeyring();
 
+    // NOTE: the unchanged properties keep their ciphertext (smaller deltas in the history)
+    auto output = keyring.hasEntry(input.getId())
+        ? mEncrypter->reencrypt(input, keyring.getEntry(input.getId()))
+        : mEncrypter->encrypt<EntryNode>(input);
 
+    keyring
+        .setEntry(output)
+        .save(repository.getPath(), *mEncrypter)
+    ;
 
+    loadEntries();
 
+    updateCatalog([this, &repository, &keyring, &input](Catalog &catalog) {
 
-void
-Core::loadRepositories()
-{
-    mRepositoryList.clear();
+        if (!catalog.hasRepository(repository.getId())) {
+            indexKeyring(catalog, repository.getId(), keyring);
+            return;
+        }
 
-    eachRepository([this](const Buffer &id, Repository &repository) {
-        mRepositoryList.push_back(id);
+        catalog.setEntry(repository.getId(), input);
     });
-}
-
-void
-Core::loadEntries()
-{
-    mEntryList.clear();
 
-    eachRepositoryEntry([this](const Buffer &id, EntryNode &entry) {
-        mEntryList.push_back(id);
-    });
+    return *this;
 }
 
-
-
-
-
 Core &
-Core::listRepositories()
+Core::copyRepositoryEntries(const Buffer &targetId, const std::vector<Buffer> &entryIds, bool move)
 {
-    // TODO
+    auto &repository = getRepository();
+    auto &keyring    = getKeyring();
 
-    return *this;
-}
+    if (targetId == repository.getId()) {
+        throw Exception("The source and the target repositories are the same");
+    }
 
-Core &
-Core::eachRepository(std::function<void (const Buffer &id, Repository &)> callback)
-{
-    if (!filesystem::is_directory(mKeyringPath)) {
-        throw Exception("Unable to find the directory 'keyrings'");
+    auto targetPath = mKeyringPath / targetId.toString();
+
+    if (!Repository::isValid(targetPath)) {
+        throw Exception("Unknown repository '%1%' (see `km fetch`)", targetId);
     }
 
-    filesystem::directory_iterator it(mKeyringPath), end;
+    auto target        = Repository::fromPath(targetId, targetPath, mPrivateKey);
+    auto targetKeyring = KeyringNode::fromPath(targetPath);
 
-    for ( ; it != end; ++it) {
+    auto &targetEncrypter = unlockKeyring(targetId, targetKeyring);
 
-        auto name = it->path().filename().string();
+    ChunkStore chunkStore(repository.getPath(), *mEncrypter);
+    ChunkStore targetChunkStore(targetPath, targetEncrypter);
 
-        if (name[0] == '.') {
-            continue;
-        }
+    auto ids = entryIds.empty() ? mEntryList : entryIds;
 
-        auto repositoryId   = Buffer::fromString(name);
-        auto repositoryPath = mKeyringPath / repositoryId.toString();
+    for (auto &id : ids) {
 
-        // FIXME: improve this shit!!!
-        auto repository = Repository::fromPath(repositoryId, repositoryPath, mPrivateKey);
+        if (!keyring.hasEntry(id)) {
+            throw Exception("Unknown entry '%1%'", id);
+        }
 
-        callback(repositoryId, repository);
+        if (move && targetKeyring.hasEntry(id)) {
+            throw Exception("The entry '%1%' is already in the target repository", id);
+        }
     }
 
-    return *this;
-}
+    for (std::size_t offset = 0; offset < ids.size(); offset += TRANSFER_BATCH_SIZE) {
 
-Core &
-Core::eachKeyring(std::function<void (const Buffer &id, KeyringNode &)> callback)
-{
-    if (!filesystem::is_directory(mKeyringPath)) {
-        throw Exception("Unable to find the directory 'keyrings'");
-    }
+        std::size_t count = std::min<std::size_t>(TRANSFER_BATCH_SIZE, ids.size() - offset);
 
-    filesystem::directory_iterator it(mKeyringPath), end;
+        std::vector<EntryNode> entries(count, EntryNode::create());
 
-    for ( ; it != end; ++it) {
+        TaskPool::run(count, [this, &keyring, &targetEncrypter, &chunkStore, &targetChunkStore, &ids, &entries, offset, move](std::size_t i) {
 
-        auto name = it->path().filename().string();
+            auto entry = mEncrypter->decrypt<EntryNode>(keyring.getEntry(ids[offset + i]));
 
-        if (name[0] == '.') {
-            continue;
-        }
+            // NOTE: the moved entries keep their IDs, the copies get new ones
+            auto output = move ? entry : EntryNode::create();
 
-        auto repositoryId   = Buffer::fromString(name);
-        auto repositoryPath = mKeyringPath / repositoryId.toString();
+            entry.eachProperty([&chunkStore, &targetChunkStore, &output](const Buffer &name, PropertyNode &property) {
 
-        // FIXME: improve this shit!!!
-        auto repository = Repository::fromPath(repositoryId, repositoryPath, mPrivateKey);
+                if (property.isAttachment()) {
 
-        auto keyringNode = std::make_unique<KeyringNode>(
-            KeyringNode::fromPath(repository.getPath())
-        );
+                    auto manifest = PropertyNode::create(name, chunkStore.copy(property.getContent(), targetChunkStore));
+                    output.setProperty(name, manifest.setAttachment(true));
 
-        auto accessKey = keyringNode->getAccessKey(
-            Encrypter::getFingerprint(mPrivateKey)
-        );
+                } else {
+                    output.setProperty(name, property);
+                }
+            });
 
-        auto encrypter = std::make_unique<Encrypter>(
-            Encrypter::create(accessKey, mPrivateKey)
-        );
+            entries[i] = targetEncrypter.encrypt<EntryNode>(output);
+        });
 
-        auto aaa = encrypter->decrypt<KeyringNode>(
-            *keyringNode
-        );
+        for (auto &entry : entries) {
+            targetKeyring.setEntry(entry);
+        }
 
-        callback(aaa.getId(), aaa);
+        // NOTE: only the entries of the batch are written
+        targetKeyring.save(targetPath, targetEncrypter);
     }
 
-    return *this;
-}
+    auto targetTextNode = targetEncrypter.encrypt<TextNode>(
+        TextNode::create(format_buffer("%1% %2% entries from %3%", move ? "Moved" : "Copied", ids.size(), repository.getId()))
+    );
 
+    target
+        .add("entries/*")
+        .add("chunks/*")
+        .add(MerkleTree::TreeFile)
+        .commit(targetTextNode.toBuffer())
+    ;
 
+    mPushQueue->enqueue(targetId);
 
+    if (move) {
 
+        for (auto &id : ids) {
+            keyring.removeEntry(id);
+            filesystem::remove(repository.getPath() / KeyringNode::EntryDir / id.toString());
+        }
 
-Core &
-Core::fetchRepositories()
-{
-    auto repositories = getRepositories();
+        keyring.save(repository.getPath(), *mEncrypter);
 
-    for (auto &repositoryId : repositories) {
+        commitRepository(format_buffer("Moved %1% entries to %2%", ids.size(), targetId));
 
-        auto repositoryPath = mKeyringPath / repositoryId.toString();
+        mPushQueue->enqueue(repository.getId());
 
-        if (Repository::isValid(repositoryPath)) {
+        loadEntries();
+    }
 
-            auto repository = Repository::fromPath(repositoryId, repositoryPath, mPrivateKey);
-            repository.fetch();
+    updateCatalog([this, &repository, &keyring, &targetId, &targetKeyring, move](Catalog &catalog) {
 
-        } else {
+        indexKeyring(catalog, targetId, targetKeyring);
 
-            Repository repository = Repository::fromRemote(repositoryId, repositoryPath, mPrivateKey);
+        if (move) {
+            indexKeyring(catalog, repository.getId(), keyring);
         }
-    }
+    });
 
     return *this;
 }
 
+EntryNode
+Core::getRepositoryEntry(const Buffer &id)
+{
+    return mEncrypter->decrypt<EntryNode>(
+        mKeyringNode->getEntry(id)
+    );
+}
 
+bool
+Core::findRepositoryEntry(const Buffer &reference, Buffer &id)
+{
+    auto &keyring = getKeyring();
 
+    if (keyring.hasEntry(reference)) {
+        id = reference;
+        return true;
+    }
 
-std::vector<Buffer>
-Core::getRepositories()
-{
-    auto &shell = getShell();
+    bool found = false;
 
-    Buffer response = shell.exec("repository-list");
+    keyring.eachEntry([this, &reference, &id, &found](const Buffer &entryId, const EntryNode &entry) {
+
+        if (found) {
+            return;
+        }
+
+        try {
+
+            if (mEncrypter->decryptProperty(entry, Buffer::fromString("name")).getContent() == reference) {
+                id    = entryId;
+                found = true;
+            }
+
+        } catch (PropertyNotFoundException &e) {
+            // Unnamed entry
+        }
+    });
+
+    return found;
+}
+
+Core &
+Core::setRepositoryAttachment(const Buffer &entryId, const Buffer &name, std::istream &input)
+{
+    auto &repository = getRepository();
+
+    auto entry = getRepositoryEntry(entryId);
+
+    ChunkStore chunkStore(repository.getPath(), *mEncrypter);
+
+    auto manifest = PropertyNode::create(name, chunkStore.write(input));
+    entry.setProperty(name, manifest.setAttachment(true));
+
+    return setRepositoryEntry(entry);
+}
+
+Core &
+Core::getRepositoryAttachment(const Buffer &entryId, const Buffer &name, std::ostream &output)
+{
+    auto &repository = getRepository();
+
+    auto entry = getRepositoryEntry(entryId);
+
+    auto &property = entry.getProperty(name);
+
+    if (!property.isAttachment()) {
+        throw Exception("The property '%1%' is not an attachment", name);
+    }
+
+    ChunkStore chunkStore(repository.getPath(), *mEncrypter);
+    chunkStore.read(property.getContent(), output);
+
+    return *this;
+}
+
+Core &
+Core::eachRepositoryEntry(std::function<void (const Buffer &id, EntryNode &)> callback)
+{
+    auto &keyring = getKeyring();
+
+    keyring.eachEntry([this, &callback](const Buffer &id, const EntryNode &input) {
+
+        auto output = input.mapProperty([this](const Buffer &name, const PropertyNode &property) {
+            return mEncrypter->decrypt<PropertyNode>(property);
+        });
+
+        callback(id, output);
+    });
+
+    return *this;
+}
+
+Core &
+Core::commitRepository(const Buffer &message)
+{
+    auto &repository = getRepository();
+
+    auto textNode = mEncrypter->encrypt<TextNode>(
+        TextNode::create(message)
+    );
+
+    repository
+        .add("entries/*")
+        .update("entries/*")
+        .add("chunks/*")
+        .add(MerkleTree::TreeFile)
+        .commit(textNode.toBuffer())
+    ;
+
+    return *this;
+}
+
+Core &
+Core::pushRepository()
+{
+    auto &repository = getRepository();
+
+    mPushQueue->enqueue(repository.getId());
+
+    return *this;
+}
+
+Core &
+Core::flush()
+{
+    mPushQueue->flush();
+
+    return *this;
+}
+
+std::map<Buffer, std::string>
+Core::getPushFailures() const
+{
+    return mPushQueue->getFailures();
+}
+
+Core &
+Core::fetchRepository()
+{
+    auto &repository = getRepository();
+
+    auto head = repository.getHead();
+
+    repository
+        .attach(&getShell())
+        .fetch()
+    ;
+
+    refreshRepository(head);
+
+    updateCatalog([this, &repository](Catalog &catalog) {
+        indexKeyring(catalog, repository.getId(), *mKeyringNode);
+    });
+
+    return *this;
+}
+
+Core &
+Core::compactRepository(int retention)
+{
+    if (retention < 0) {
+        throw Exception("Invalid retention window");
+    }
+
+    auto &repository = getRepository();
+
+    // The lease requires the remote to be in sync
+    mPushQueue->flush();
+
+    auto limit = std::time(nullptr) - (std::time_t) retention * 24 * 60 * 60;
+
+    auto textNode = mEncrypter->encrypt<TextNode>(
+        TextNode::create(Buffer::fromString("Compacted history"))
+    );
+
+    auto head = repository.getHead();
+
+    if (!repository.compact(limit, textNode.toBuffer())) {
+        return *this;
+    }
+
+    try {
+        repository
+            .attach(&getShell())
+            .forcePush(head)
+        ;
+
+    } catch (Exception &e) {
+
+        // Restore the original history
+        repository.setHead(head);
+        throw;
+    }
+
+    return *this;
+}
+
+std::vector<Buffer>
+Core::verifyRepository()
+{
+    auto &repository = getRepository();
+    auto &keyring    = getKeyring();
+
+    // NOTE: the hashes are unkeyed, only the seal proves who wrote the tree
+    if (!mEncrypter->isSealed(keyring.getMerkleTree())) {
+        throw Exception("The integrity tree is not sealed by the access key (altered, or written by an older version: edit an entry to seal it)");
+    }
+
+    return keyring.getMerkleTree().verify(
+        repository.getPath() / KeyringNode::EntryDir,
+        std::thread::hardware_concurrency()
+    );
+}
+
+std::vector<Buffer>
+Core::diffRepository(const Buffer &revision)
+{
+    auto &repository = getRepository();
+    auto &keyring    = getKeyring();
+
+    auto other = MerkleTree::fromBuffer(
+        repository.readFile(revision, MerkleTree::TreeFile)
+    );
+
+    return keyring.getMerkleTree().diff(other);
+}
+
+Core &
+Core::eachRepositoryLogs(const std::string &range, std::function<void (const Buffer &id, const Commit &)> callback)
+{
+    mRepository->eachCommits(range, [this, &callback](const Buffer &id, const Commit &input) {
+
+        auto textNode = mEncrypter->decrypt<TextNode>(
+                TextNode::fromBuffer(input.getSummary())
+        );
+
+        Commit ouput = input;
+        ouput.setSummary(textNode.getContent());
+
+        callback(id, ouput);
+    });
+
+    return *this;
+}
+
+Core &
+Core::destroyRepository()
+{
+    auto &repository = getRepository();
+    auto &shell      = getShell();
+
+    Buffer response = shell.exec("repository-delete '%1%'", repository.getId());
 
     if (shell.getReturnCode() != 0) {
-        throw Exception("Failure listing the repository");
+        throw Exception("Failure deleting the repository");
+    }
+
+    repository.destroy();
+
+    mPushQueue->dequeue(repository.getId());
+
+    updateCatalog([&repository](Catalog &catalog) {
+        catalog.removeRepository(repository.getId());
+    });
+
+    return *this;
+}
+
+Core &
+Core::serveShell(std::chrono::seconds idleTimeout)
+{
+    ShellMaster master(mHomePath / ".km" / ShellMaster::SocketFile, mPrivateKey);
+
+    master.run(idleTimeout);
+
+    return *this;
+}
+
+Core &
+Core::serveAgent(std::chrono::seconds idleTimeout, bool memoryLock)
+{
+    KeyAgent agent(mHomePath / ".km" / KeyAgent::SocketFile, mKeyringPath, getRecipientKey(), *mPushQueue);
+
+    agent
+        .setMemoryLock(memoryLock)
+        .run(idleTimeout)
+    ;
+
+    return *this;
+}
+
+bool
+Core::requestAgent(const IpcChannel::Message &request, IpcChannel::Message &response) const
+{
+    return KeyAgent::request(mHomePath / ".km" / KeyAgent::SocketFile, request, response);
+}
+
+
+
+
+
+
+void
+Core::loadRepositories()
+{
+    mRepositoryList.clear();
+
+    eachRepository([this](const Buffer &id, Repository &repository) {
+        mRepositoryList.push_back(id);
+    });
+}
+
+void
+Core::loadEntries()
+{
+    mEntryList.clear();
+
+    eachRepositoryEntry([this](const Buffer &id, EntryNode &entry) {
+        mEntryList.push_back(id);
+    });
+}
+
+
+
+
+
+Core &
+Core::listRepositories()
+{
+    // TODO
+
+    return *this;
+}
+
+Core &
+Core::eachRepository(std::function<void (const Buffer &id, Repository &)> callback)
+{
+    if (!filesystem::is_directory(mKeyringPath)) {
+        throw Exception("Unable to find the directory 'keyrings'");
+    }
+
+    filesystem::directory_iterator it(mKeyringPath), end;
+
+    for ( ; it != end; ++it) {
+
+        auto name = it->path().filename().string();
+
+        if (name[0] == '.') {
+            continue;
+        }
+
+        auto repositoryId   = Buffer::fromString(name);
+        auto repositoryPath = mKeyringPath / repositoryId.toString();
+
+        // FIXME: improve this shit!!!
+        auto repository = Repository::fromPath(repositoryId, repositoryPath, mPrivateKey);
+
+        callback(repositoryId, repository);
+    }
+
+    return *this;
+}
+
+Core &
+Core::eachKeyring(std::function<void (const Buffer &id, KeyringNode &)> callback)
+{
+    if (!filesystem::is_directory(mKeyringPath)) {
+        throw Exception("Unable to find the directory 'keyrings'");
+    }
+
+    std::vector<Buffer> ids;
+
+    filesystem::directory_iterator it(mKeyringPath), end;
+
+    for ( ; it != end; ++it) {
+
+        auto name = it->path().filename().string();
+
+        if (name[0] == '.') {
+            continue;
+        }
+
+        ids.push_back(Buffer::fromString(name));
+    }
+
+    // NOTE: the keyrings are reported in a stable order
+    std::sort(ids.begin(), ids.end());
+
+    struct Slot
+    {
+        std::unique_ptr<KeyringNode> keyring;
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    std::vector<Slot> slots(ids.size());
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    // Parse and unlock the keyrings in parallel (only the metadata, the Git repositories are left closed)
+    TaskPool pool(ids.size(), [this, &ids, &slots, &mutex, &condition](std::size_t i) {
+
+        std::unique_ptr<KeyringNode> keyring;
+        std::exception_ptr error;
+
+        try {
+
+            auto keyringNode = KeyringNode::fromPath(mKeyringPath / ids[i].toString());
+
+            keyring = std::make_unique<KeyringNode>(
+                unlockKeyring(ids[i], keyringNode).decrypt<KeyringNode>(keyringNode)
+            );
+
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            slots[i].keyring = std::move(keyring);
+            slots[i].error   = error;
+            slots[i].done    = true;
+        }
+
+        condition.notify_all();
+    });
+
+    // Report the keyrings in order, as soon as they are ready (on errors, the pool stops as it goes out of scope)
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+
+        std::unique_ptr<KeyringNode> keyring;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            condition.wait(lock, [&slots, i]() {
+                return slots[i].done;
+            });
+
+            if (slots[i].error) {
+                std::rethrow_exception(slots[i].error);
+            }
+
+            keyring = std::move(slots[i].keyring);
+        }
+
+        callback(keyring->getId(), *keyring);
+    }
+
+    return *this;
+}
+
+
+
+
+
+Core &
+Core::fetchRepositories()
+{
+    // NOTE: the keyrings shared with a group are unlocked by the group key
+    fetchGroups();
+
+    auto repositories = getRepositories();
+
+    for (auto &repositoryId : repositories) {
+
+        auto repositoryPath = mKeyringPath / repositoryId.toString();
+
+        if (Repository::isValid(repositoryPath)) {
+
+            auto repository = Repository::fromPath(repositoryId, repositoryPath, mPrivateKey);
+
+            repository
+                .attach(&getShell())
+                .fetch()
+            ;
+
+        } else {
+
+            Repository repository = Repository::fromRemote(repositoryId, repositoryPath, mPrivateKey, &getShell());
+        }
+
+        updateCatalog([this, &repositoryId, &repositoryPath](Catalog &catalog) {
+            indexKeyring(catalog, repositoryId, KeyringNode::fromPath(repositoryPath));
+        });
+    }
+
+    return *this;
+}
+
+Core &
+Core::fetchGroups()
+{
+    std::vector<Buffer> groups;
+
+    auto status = execShell(Buffer::fromString("group-list"), [&groups](const JsonReader::Path &path, const std::string &value) {
+
+        if (path.size() == 3 && path[2] == "id") {
+            groups.push_back(Buffer::fromString(value));
+        }
+    });
+
+    if (status != 200) {
+        throw Exception("Failed: status code %1%", status);
+    }
+
+    for (auto &groupId : groups) {
+
+        auto groupPath = mGroupPath / groupId.toString();
+
+        if (Repository::isValid(groupPath)) {
+
+            auto repository = Repository::fromPath(groupId, groupPath, mPrivateKey);
+
+            repository
+                .attach(&getShell())
+                .fetch()
+            ;
+
+        } else {
+
+            Repository repository = Repository::fromRemote(groupId, groupPath, mPrivateKey, &getShell());
+        }
+    }
+
+    return *this;
+}
+
+Core &
+Core::eachCatalogRepository(std::function<void (const Buffer &id, const Buffer &name, std::size_t numOfEntries)> callback)
+{
+    getCatalog().eachRepository(callback);
+
+    return *this;
+}
+
+std::vector<Buffer>
+Core::locateEntry(const Buffer &reference)
+{
+    bool exact;
+
+    auto candidates = getCatalog().locate(reference, exact);
+
+    if (exact) {
+        return candidates;
+    }
+
+    std::vector<Buffer> output;
+
+    // Rule out the false positives of the filters
+    for (auto &repositoryId : candidates) {
+
+        bool found = false;
+
+        try {
+
+            auto keyringNode = KeyringNode::fromPath(mKeyringPath / repositoryId.toString());
+
+            auto &encrypter = unlockKeyring(repositoryId, keyringNode);
+
+            keyringNode.eachEntry([&encrypter, &reference, &found](const Buffer &id, const EntryNode &entry) {
+
+                if (found) {
+                    return;
+                }
+
+                try {
+
+                    auto name = encrypter.decryptProperty(entry, Buffer::fromString("name"));
+
+                    found = (name.getContent() == reference);
+
+                } catch (PropertyNotFoundException &e) {
+                    // Unnamed entry
+                }
+            });
+
+        } catch (std::exception &e) {
+            // Repository removed since the last update of the catalog
+        }
+
+        if (found) {
+            output.push_back(repositoryId);
+        }
+    }
+
+    return output;
+}
+
+Core &
+Core::indexRepositories()
+{
+    if (!filesystem::is_directory(mKeyringPath)) {
+        throw Exception("Unable to find the directory 'keyrings'");
+    }
+
+    auto catalog = std::make_unique<Catalog>(
+        Catalog::create(PublicKey::fromPrivateKey(getRecipientKey()), getRecipientKey())
+    );
+
+    filesystem::directory_iterator it(mKeyringPath), end;
+
+    for ( ; it != end; ++it) {
+
+        auto name = it->path().filename().string();
+
+        if (name[0] == '.') {
+            continue;
+        }
+
+        indexKeyring(*catalog, Buffer::fromString(name), KeyringNode::fromPath(it->path()));
+    }
+
+    Catalog::toFile(mHomePath / ".km" / Catalog::CatalogFile, *catalog);
+
+    mCatalog = std::move(catalog);
+
+    return *this;
+}
+
+
+
+
+std::vector<Buffer>
+Core::getRepositories()
+{
+    std::vector<Buffer> list;
+
+    // NOTE: the list is collected while the response streams in
+    auto status = execShell(Buffer::fromString("repository-list"), [&list](const JsonReader::Path &path, const std::string &value) {
+
+        if (path.size() == 3 && path[2] == "id") {
+            list.push_back(Buffer::fromString(value));
+        }
+    });
+
+    if (status != 200) {
+        throw Exception("Failed: status code %1%", status);
+    }
+
+    return list;
+}
+
+
+
+
+KeyringNode
+Core::createKeyring(const Buffer &name, const PublicKey &publicKey) const
+{
+    auto key = AccessKey::create(Buffer(), Buffer::fromRandom(32)); // 256 bit
+
+    // FIXME: check this
+    auto keyring = KeyringNode::create();
+
+    if (publicKey.canWrap()) {
+        keyring.addAccessKey(createAccessKey(key, publicKey));
+    }
+
+    // NOTE: the RSA recipient is kept, for the clients without the X25519 key
+    if (mWrappingKey) {
+        keyring.addAccessKey(createAccessKey(key, PublicKey::fromPrivateKey(*mWrappingKey)));
+    }
+
+    return keyring;
+}
+
+AccessKey
+Core::createAccessKey(const AccessKey &key, const PublicKey &publicKey) const
+{
+    auto recipient = Encrypter::getFingerprint(publicKey);
+
+    return Encrypter::encrypt<AccessKey>
+    (
+        AccessKey::create(recipient, key.getData()).setVersion(key.getVersion()),
+        publicKey
+    );
+}
+
+std::vector<AccessKey>
+Core::createAccessKeys(const AccessKey &key, const std::vector<PublicKey> &publicKeys) const
+{
+    std::vector<AccessKey> accessKeys(publicKeys.size());
+
+    TaskPool::run(publicKeys.size(), [this, &key, &publicKeys, &accessKeys](std::size_t i) {
+        accessKeys[i] = createAccessKey(key, publicKeys[i]);
+    });
+
+    return accessKeys;
+}
+
+void
+Core::rotateAccessKey(const std::vector<Buffer> &revokedUserIds)
+{
+    auto &repository = getRepository();
+    auto &shell      = getShell();
+    auto &keyring    = getKeyring();
+
+    std::set<Buffer> revoked(revokedUserIds.begin(), revokedUserIds.end());
+
+    // NOTE: a revoked member of a group sharing the repository would unwrap the new key through the group
+    if (!revoked.empty() && filesystem::is_directory(mGroupPath)) {
+
+        std::vector<Buffer> revokedIds(revoked.begin(), revoked.end());
+
+        auto revokedKeys = getUserKeys(revokedIds);
+
+        for (filesystem::directory_iterator it(mGroupPath), end; it != end; ++it) {
+
+            auto groupId = Buffer::fromString(it->path().filename().string());
+
+            if (!keyring.hasAccessKey(Encrypter::getGroupFingerprint(groupId))) {
+                continue;
+            }
+
+            auto groupKeyring = KeyringNode::fromPath(it->path());
+
+            for (std::size_t i = 0; i < revokedIds.size(); ++i) {
+
+                for (auto &publicKey : revokedKeys[i]) {
+
+                    if (groupKeyring.hasAccessKey(Encrypter::getFingerprint(publicKey))) {
+                        throw Exception("The user '%1%' is a member of the group '%2%', which shares the repository (remove them from the group first)", revokedIds[i], groupId);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<Buffer> userIds;
+
+    auto status = execShell(format_buffer("repository-members '%1%'", repository.getId()), [&userIds, &revoked](const JsonReader::Path &path, const std::string &value) {
+
+        if (path.size() == 3 && path[2] == "id" && !revoked.count(Buffer::fromString(value))) {
+            userIds.push_back(Buffer::fromString(value));
+        }
+    });
+
+    if (status != 200) {
+        throw Exception("Failed: status code %1%", status);
+    }
+
+    std::vector<std::future<SshClient::Result>> results;
+
+    for (auto &userId : revoked) {
+        results.push_back(
+            shell.execAsync(format_buffer("repository-unshare '%1%' '%2%'", repository.getId(), userId))
+        );
+    }
+
+    shell.run();
+
+    for (auto &result : results) {
+
+        if (result.get().returnCode != 0) {
+            throw Exception("Failure revoking the access to the repository");
+        }
+    }
+
+    std::vector<PublicKey> publicKeys = { PublicKey::fromPrivateKey(getRecipientKey()) };
+
+    if (mWrappingKey) {
+        publicKeys.push_back(PublicKey::fromPrivateKey(*mWrappingKey));
+    }
+
+    for (auto &userKeys : getUserKeys(userIds)) {
+        publicKeys.insert(publicKeys.end(), userKeys.begin(), userKeys.end());
+    }
+
+    // NOTE: the new key only replaces the current access keys, it never grants new ones
+    std::map<Buffer, PublicKey> recipients;
+
+    for (auto &publicKey : publicKeys) {
+
+        auto fingerprint = Encrypter::getFingerprint(publicKey);
+
+        if (keyring.hasAccessKey(fingerprint)) {
+            recipients.emplace(fingerprint, publicKey);
+        }
+    }
+
+    publicKeys.clear();
+
+    for (auto &it : recipients) {
+        publicKeys.push_back(it.second);
+    }
+
+    auto encrypter = mEncrypter->rotate();
+
+    auto &newKey = encrypter.getAccessKey();
+
+    AccessKeyMap accessKeys;
+
+    for (auto &accessKey : createAccessKeys(newKey, publicKeys)) {
+        accessKeys[accessKey.getRecipient()] = accessKey;
+    }
+
+    // The groups get the new key wrapped by their own key
+    if (filesystem::is_directory(mGroupPath)) {
+
+        for (filesystem::directory_iterator it(mGroupPath), end; it != end; ++it) {
+
+            auto groupId   = Buffer::fromString(it->path().filename().string());
+            auto recipient = Encrypter::getGroupFingerprint(groupId);
+
+            if (!keyring.hasAccessKey(recipient)) {
+                continue;
+            }
+
+            auto &groupEncrypter = unlockKeyring(groupId, KeyringNode::fromPath(it->path()));
+
+            accessKeys[recipient] = groupEncrypter.encrypt<AccessKey>(
+                AccessKey::create(recipient, newKey.getData()).setVersion(newKey.getVersion())
+            );
+        }
     }
 
-    std::istringstream ss((char *) response.data());
+    // NOTE: the keyring properties are few, they are re-encrypted at once
+    auto output = encrypter.encrypt<KeyringNode>(
+        mEncrypter->decrypt<KeyringNode>(keyring)
+    );
 
-    property_tree::ptree responseTree;
-    property_tree::read_json(ss, responseTree);
+    output
+        .upgrade()
+        .setAccessKeys(accessKeys)
+        .setKeyHistory(encrypter.getKeyHistory())
+        .save(repository.getPath(), encrypter)
+    ;
 
-    auto status  = responseTree.get("status", 500);
-    auto content = responseTree.get_child("content");
+    filesystem::ofstream progress(getRotationPath(repository.getId()), std::ios::binary | std::ios::trunc);
 
-    if (status != 200) {
-        throw Exception("Failed: status code " + responseTree.get<std::string>("status"));
+    if (!progress) {
+        throw Exception("Failed writing the progress of the key rotation");
     }
 
-    // FIXME
-    std::vector<Buffer> list;
+    parseRepository();
+
+    commitKeyring(Buffer::fromString("Rotated access key"));
+}
+
+void
+Core::reencryptEntries()
+{
+    auto &repository = getRepository();
+    auto &keyring    = getKeyring();
+
+    auto progressPath = getRotationPath(repository.getId());
+    auto version      = mEncrypter->getAccessKey().getVersion();
+
+    // The progress file holds the key version and the last entry re-encrypted
+    std::string line;
+    Buffer lastId;
+
+    filesystem::ifstream progress(progressPath, std::ios::binary);
 
-    for (auto &repositoryNode : content) {
+    if (std::getline(progress, line) && !line.empty()) {
 
-        auto repositoryId = (repositoryNode.second).get<std::string>("id");
-        list.push_back(Buffer::fromString(repositoryId));
+        std::size_t length = 0;
+        unsigned long progressVersion = 0;
+
+        try {
+            progressVersion = std::stoul(line, &length);
+
+        } catch (std::logic_error &e) {
+            // Not a number
+        }
+
+        if (length == 0 || length != line.size()) {
+
+            // NOTE: the entries re-encrypted so far are skipped anyway, as they are up to date
+            spdlog::get("km")->warn("Restarted the key rotation of {}: malformed key version '{}'", repository.getId().toString(), line);
+
+        } else if (progressVersion == version && std::getline(progress, line)) {
+            lastId = Buffer::fromString(line);
+        }
     }
 
-    return list;
-}
+    progress.close();
 
+    // NOTE: the entries are visited in ID order, as recorded by the progress file
+    std::vector<Buffer> pending;
 
+    keyring.eachEntry([version, &lastId, &pending](const Buffer &id, const EntryNode &entry) {
 
+        if (!lastId.empty() && id <= lastId) {
+            return;
+        }
 
-KeyringNode
-Core::createKeyring(const Buffer &name, const PublicKey &publicKey) const
-{
-    auto accessKey = createAccessKey
-    (
-        Buffer::fromRandom(32), // 256 bit
-        publicKey
-    );
+        bool stale = false;
 
-    // FIXME: check this
-    auto keyring = KeyringNode::create();
-    keyring.addAccessKey(accessKey);
+        entry.eachProperty([version, &stale](const Buffer &name, const PropertyNode &property) {
+            stale = stale || property.getKeyVersion() != version;
+        });
 
-    return keyring;
+        if (stale) {
+            pending.push_back(id);
+        }
+    });
+
+    for (std::size_t offset = 0; offset < pending.size(); offset += ROTATION_BATCH_SIZE) {
+
+        std::size_t count = std::min<std::size_t>(ROTATION_BATCH_SIZE, pending.size() - offset);
+
+        std::vector<EntryNode> entries(count, EntryNode::create());
+
+        TaskPool::run(count, [this, &keyring, &pending, &entries, offset](std::size_t i) {
+
+            entries[i] = mEncrypter->encrypt<EntryNode>(
+                mEncrypter->decrypt<EntryNode>(keyring.getEntry(pending[offset + i]))
+            );
+        });
+
+        for (auto &entry : entries) {
+            keyring.setEntry(entry);
+        }
+
+        keyring.save(repository.getPath(), *mEncrypter);
+
+        commitKeyring(format_buffer("Re-encrypted entries (%1%/%2%)", offset + count, pending.size()));
+
+        filesystem::ofstream output(progressPath, std::ios::binary | std::ios::trunc);
+
+        output << version << "\n" << pending[offset + count - 1].toString() << "\n";
+
+        if (!output) {
+            throw Exception("Failed writing the progress of the key rotation");
+        }
+
+        // NOTE: every batch is published, the other clients read it through the key history
+        mPushQueue->enqueue(repository.getId());
+    }
+
+    filesystem::remove(progressPath);
+
+    mPushQueue->enqueue(repository.getId());
 }
 
-AccessKey
-Core::createAccessKey(const Buffer &key, const PublicKey &publicKey) const
+void
+Core::commitKeyring(const Buffer &message)
 {
-    auto recipient = Encrypter::getFingerprint(publicKey);
+    auto &repository = getRepository();
 
-    return Encrypter::encrypt<AccessKey>
-    (
-        AccessKey::create(recipient, key),
-        publicKey
+    auto textNode = mEncrypter->encrypt<TextNode>(
+        TextNode::create(message)
     );
+
+    repository
+        .add("keymaker.xml")
+        .add("access/*")
+        .update("access/*")
+        .add("entries/*")
+        .update("entries/*")
+        .add(MerkleTree::TreeFile)
+        .commit(textNode.toBuffer())
+    ;
+}
+
+filesystem::path
+Core::getRotationPath(const Buffer &repositoryId) const
+{
+    return mRotationPath / repositoryId.toString();
 }
 
 void
@@ -574,22 +1539,24 @@ Core::buildGitRepository(const Buffer &repositoryId, const Buffer &name)
     aaa.setProperty("name", name);
 
     auto accessKey = aaa.getAccessKey(
-        Encrypter::getFingerprint(mPrivateKey)
+        Encrypter::getFingerprint(getRecipientKey())
     );
 
     mEncrypter = std::make_unique<Encrypter>(
-        Encrypter::create(accessKey, mPrivateKey)
+        Encrypter::create(accessKey, getRecipientKey())
     );
 
     auto keyringNode = mEncrypter->encrypt<KeyringNode>(
         aaa
     );
 
-    keyringNode.save(repository.getPath());
+    keyringNode.save(repository.getPath(), *mEncrypter);
 
     repository
         .add("keymaker.xml")
+        .add("access/*")
         .add("entries/*")
+        .add(MerkleTree::TreeFile)
     ;
 }
 
@@ -600,32 +1567,21 @@ Core::openGitRepository(const Repository &repository)
 }
 
 void
-Core::shareGitRepository(Repository &repository, const PublicKey &publicKey) const
+Core::shareGitRepository(Repository &repository, const std::vector<AccessKey> &accessKeys) const
 {
     KeyringNode keyring = KeyringNode::fromPath(repository.getPath());
 
-    auto fingerprint = Encrypter::getFingerprint(mPublicKey);
-
-    // Get the current access key
-    auto accessKey = Encrypter::decrypt<AccessKey>
-    (
-        keyring.getAccessKey(fingerprint),
-        mPrivateKey
-    );
+    // NOTE: the legacy keyrings are converted as soon as their recipients change
+    keyring.upgrade();
 
-    // Generate a new access key
-    auto newAccessKey = createAccessKey
-    (
-        accessKey.getData(),
-        publicKey
-    );
+    for (auto &accessKey : accessKeys) {
+        keyring.addAccessKey(accessKey);
+    }
 
-    keyring
-        .addAccessKey(newAccessKey)
-        .save(repository.getPath())
-    ;
+    keyring.save(repository.getPath());
 
     repository
+        .add("access/*")
         .update("keymaker.xml")
     ;
 }
@@ -637,22 +1593,361 @@ Core::parseRepository()
         KeyringNode::fromPath(mRepository->getPath())
     );
 
-    auto accessKey = mKeyringNode->getAccessKey(
-        Encrypter::getFingerprint(mPrivateKey)
-    );
-
     mEncrypter = std::make_unique<Encrypter>(
-        Encrypter::create(accessKey, mPrivateKey)
+        unlockKeyring(mRepository->getId(), *mKeyringNode)
     );
 
     loadEntries();
 }
 
+const Encrypter &
+Core::unlockKeyring(const Buffer &repositoryId, const KeyringNode &keyringNode)
+{
+    // Prefer the X25519 recipient, its unwrap is much cheaper than the RSA one
+    bool useWrappingKey = mWrappingKey && keyringNode.hasAccessKey(
+        Encrypter::getFingerprint(*mWrappingKey)
+    );
+
+    auto &privateKey = useWrappingKey ? *mWrappingKey : getRecipientKey();
+
+    auto fingerprint = Encrypter::getFingerprint(privateKey);
+
+    const Encrypter *groupEncrypter = nullptr;
+
+    // Not a recipient, the keyring may be shared with one of the groups
+    if (!keyringNode.hasAccessKey(fingerprint)) {
+
+        auto groupId = findGroup(keyringNode);
+
+        if (!groupId.empty()) {
+            groupEncrypter = &unlockKeyring(groupId, KeyringNode::fromPath(mGroupPath / groupId.toString()));
+            fingerprint    = Encrypter::getGroupFingerprint(groupId);
+        }
+    }
+
+    auto &accessKey = keyringNode.getAccessKey(fingerprint);
+
+    {
+        std::lock_guard<std::mutex> lock(mUnlockedKeysMutex);
+
+        auto it = mUnlockedKeys.find(repositoryId);
+
+        if (it != mUnlockedKeys.end() && it->second.wrapped == accessKey.getData()) {
+            return *it->second.encrypter;
+        }
+    }
+
+    // NOTE: the keyrings are unlocked concurrently, the RSA decryption runs outside the lock
+    auto encrypter = std::make_unique<Encrypter>(
+        groupEncrypter ? Encrypter::create(accessKey, *groupEncrypter) : Encrypter::create(accessKey, privateKey)
+    );
+
+    encrypter->setKeyHistory(keyringNode.getKeyHistory());
+
+    std::lock_guard<std::mutex> lock(mUnlockedKeysMutex);
+
+    auto &unlocked = mUnlockedKeys[repositoryId];
+
+    // NOTE: a group may be unlocked by several threads, the first encrypter is kept
+    if (!unlocked.encrypter || unlocked.wrapped != accessKey.getData()) {
+        unlocked.encrypter = std::move(encrypter);
+        unlocked.wrapped   = accessKey.getData();
+    }
+
+    return *unlocked.encrypter;
+}
+
+std::vector<std::vector<PublicKey>>
+Core::getUserKeys(const std::vector<Buffer> &userIds)
+{
+    struct Lookup
+    {
+        Buffer pkcsKey;
+        Buffer wrappingKey;
+        std::future<int> status;
+    };
+
+    std::vector<Lookup> lookups(userIds.size());
+
+    // NOTE: the users are resolved concurrently, on the channels of the same session
+    for (std::size_t i = 0; i < userIds.size(); ++i) {
+
+        auto &lookup = lookups[i];
+
+        lookup.status = execShellAsync(format_buffer("user-show '%1%'", userIds[i]), [&lookup](const JsonReader::Path &path, const std::string &value) {
+
+            if (path.size() == 2 && path[1] == "pkcsKey") {
+                lookup.pkcsKey = Buffer::fromString(value);
+
+            } else if (path.size() == 2 && path[1] == "wrappingKey") {
+                lookup.wrappingKey = Buffer::fromString(value);
+            }
+        });
+    }
+
+    getShell().run();
+
+    std::vector<std::vector<PublicKey>> output;
+
+    for (std::size_t i = 0; i < lookups.size(); ++i) {
+
+        auto &lookup = lookups[i];
+        auto status  = lookup.status.get();
+
+        if (status != 200) {
+            throw Exception("Failed: status code %1% (user '%2%')", status, userIds[i]);
+        }
+
+        std::vector<PublicKey> publicKeys;
+
+        auto publicKey = PublicKey::fromMemory(lookup.pkcsKey);
+
+        if (publicKey.canWrap()) {
+            publicKeys.push_back(publicKey);
+        }
+
+        // The users with an X25519 key get a second, cheaper, recipient
+        if (!lookup.wrappingKey.empty()) {
+            publicKeys.push_back(PublicKey::fromMemory(lookup.wrappingKey));
+        }
+
+        if (publicKeys.empty()) {
+            throw Exception("The user '%1%' has neither an RSA nor an X25519 key", userIds[i]);
+        }
+
+        output.push_back(publicKeys);
+    }
+
+    return output;
+}
+
+Repository
+Core::getGroupRepository(const Buffer &groupId) const
+{
+    auto groupPath = mGroupPath / groupId.toString();
+
+    if (!Repository::isValid(groupPath)) {
+        throw Exception("Unknown group '%1%' (see `km fetch`)", groupId);
+    }
+
+    return Repository::fromPath(groupId, groupPath, mPrivateKey);
+}
+
+Buffer
+Core::findGroup(const KeyringNode &keyringNode) const
+{
+    if (!filesystem::is_directory(mGroupPath)) {
+        return Buffer();
+    }
+
+    filesystem::directory_iterator it(mGroupPath), end;
+
+    for ( ; it != end; ++it) {
+
+        auto groupId = Buffer::fromString(it->path().filename().string());
+
+        if (keyringNode.hasAccessKey(Encrypter::getGroupFingerprint(groupId))) {
+            return groupId;
+        }
+    }
+
+    return Buffer();
+}
+
+Catalog &
+Core::getCatalog()
+{
+    if (mCatalog) {
+        return *mCatalog;
+    }
+
+    try {
+
+        mCatalog = std::make_unique<Catalog>(
+            Catalog::fromFile(mHomePath / ".km" / Catalog::CatalogFile, getRecipientKey())
+        );
+
+    } catch (std::exception &e) {
+
+        // Missing, damaged or wrapped for another key
+        indexRepositories();
+    }
+
+    return *mCatalog;
+}
+
+void
+Core::updateCatalog(std::function<void (Catalog &)> update)
+{
+    auto path = mHomePath / ".km" / Catalog::CatalogFile;
+
+    // NOTE: a missing catalog is built on the first lookup
+    if (!mCatalog && !filesystem::exists(path)) {
+        return;
+    }
+
+    try {
+
+        auto &catalog = getCatalog();
+
+        update(catalog);
+
+        Catalog::toFile(path, catalog);
+
+    } catch (std::exception &e) {
+
+        mCatalog.reset();
+
+        system::error_code error;
+        filesystem::remove(path, error);
+    }
+}
+
+void
+Core::indexKeyring(Catalog &catalog, const Buffer &repositoryId, const KeyringNode &keyringNode)
+{
+    catalog.setKeyring(repositoryId, keyringNode, unlockKeyring(repositoryId, keyringNode));
+}
+
+void
+Core::refreshRepository(const Buffer &from)
+{
+    auto &repository = getRepository();
+    auto &keyring    = getKeyring();
+
+    auto head = repository.getHead();
+
+    if (head == from) {
+        return;
+    }
+
+    bool configChanged = false;
+
+    repository.eachChange(from, head, [this, &keyring, &configChanged](const filesystem::path &path, Repository::ChangeType type) {
+
+        if (path == KeyringNode::ConfigFile || path.parent_path() == KeyringNode::AccessDir) {
+            configChanged = true;
+            return;
+        }
+
+        if (path.parent_path() != KeyringNode::EntryDir || path.filename().string()[0] == '.') {
+            return;
+        }
+
+        auto id = Buffer::fromString(path.filename().string());
+
+        // NOTE: the entry list follows the (sorted) order of the keyring
+        auto it = std::lower_bound(mEntryList.begin(), mEntryList.end(), id);
+
+        bool listed = (it != mEntryList.end() && *it == id);
+
+        if (type == Repository::CHANGE_DELETED) {
+
+            keyring.removeEntry(id);
+
+            if (listed) {
+                mEntryList.erase(it);
+            }
+
+        } else {
+
+            keyring.reloadEntry(id);
+
+            if (!listed) {
+                mEntryList.insert(it, id);
+            }
+        }
+    });
+
+    if (configChanged) {
+
+        keyring.reloadConfig();
+
+        // NOTE: the access key is unwrapped again only when it has been replaced
+        mEncrypter = std::make_unique<Encrypter>(
+            unlockKeyring(repository.getId(), keyring)
+        );
+    }
+}
+
+int
+Core::execShell(const Buffer &command, JsonReader::Callback callback)
+{
+    auto status = execShellAsync(command, callback);
+
+    getShell().run();
+
+    return status.get();
+}
+
+std::future<int>
+Core::execShellAsync(const Buffer &command, JsonReader::Callback callback)
+{
+    auto &shell = getShell();
+
+    struct Response
+    {
+        int status = 500;
+        std::unique_ptr<JsonReader> reader;
+    };
+
+    auto response = std::make_shared<Response>();
+
+    // NOTE: the reader lives as long as the callbacks of the response
+    response->reader = std::make_unique<JsonReader>([&status = response->status, callback](const JsonReader::Path &path, const std::string &value) {
+
+        if (path.size() == 1 && path[0] == "status") {
+
+            std::size_t length = 0;
+
+            try {
+                status = std::stoi(value, &length);
+
+            } catch (std::logic_error &e) {
+                // Not a number
+            }
+
+            if (length == 0 || length != value.size()) {
+                throw Exception("Malformed status code '%1%'", value);
+            }
+
+        } else if (!path.empty() && path[0] == "content") {
+            callback(path, value);
+        }
+    });
+
+    auto result = shell.execAsync(command, [response](const char *data, std::size_t size) {
+        response->reader->feed(data, size);
+    });
+
+    // The response is checked when the status is read
+    return std::async(std::launch::deferred, [response, result = std::move(result)]() mutable {
+
+        auto output = result.get();
+
+        if (output.returnCode != 0) {
+            throw Exception("Shell command failed with code %1%: %2%", output.returnCode, output.errors.toString());
+        }
+
+        response->reader->finish();
+
+        return response->status;
+    });
+}
+
 SshClient &
 Core::getShell()
 {
     if (!mShell) {
         mShell = std::make_unique<SshClient>(ShellHostname, ShellPort);
+
+        // Share the session of the control master, if it's running
+        mShell->attachMaster(mHomePath / ".km" / ShellMaster::SocketFile, ShellUser);
+    }
+
+    // NOTE: a client whose control master has gone connects on its own
+    if (!mShell->isConnected()) {
+        mShell->setDnsCache(mHomePath / ".km" / SshClient::DnsCacheFile);
         mShell->connect(ShellUser, mPrivateKey);
     }
 
@@ -12,11 +12,22 @@
 
 namespace km { // Begin main namespace
 
+std::size_t
+Encrypter::mPaddingSize = PADDING_SIZE;
+
 template <>
 AccessKey
 Encrypter::encrypt<AccessKey>(const AccessKey &input, const PublicKey &publicKey)
 {
-    Buffer buffer(2048);
+    if (!publicKey.canWrap()) {
+        throw Exception("The access keys can't be wrapped for Ed25519 or ECDSA keys");
+    }
+
+    if (publicKey.getAlgorithm() == RsaKey::ALGORITHM_X25519) {
+        return wrapX25519(input, publicKey);
+    }
+
+    Buffer buffer((size_t) RSA_size(publicKey.mRsa.get()));
 
     int length = RSA_public_encrypt
     (
@@ -37,7 +48,8 @@ Encrypter::encrypt<AccessKey>(const AccessKey &input, const PublicKey &publicKey
 
     output
         .setRecipient(input.getRecipient())
-        .setData(buffer);
+        .setData(buffer)
+        .setVersion(input.getVersion());
 
     return output;
 }
@@ -46,7 +58,15 @@ template <>
 AccessKey
 Encrypter::decrypt<AccessKey>(const AccessKey &input, const PrivateKey &privateKey)
 {
-    Buffer buffer(2048);
+    if (input.getAlgorithm() != privateKey.getAlgorithm()) {
+        throw Exception("The access key is wrapped for another key type");
+    }
+
+    if (input.getAlgorithm() == RsaKey::ALGORITHM_X25519) {
+        return unwrapX25519(input, privateKey);
+    }
+
+    Buffer buffer((size_t) RSA_size(privateKey.mRsa.get()));
 
     int length = RSA_private_decrypt
     (
@@ -78,17 +98,14 @@ Encrypter::create(const AccessKey &accessKey, const PrivateKey &privateKey)
     Encrypter crypter;
 
     crypter.mAccessKey = Encrypter::decrypt<AccessKey>(accessKey, privateKey);
+    crypter.mAccessKey.setVersion(accessKey.getVersion());
 
     return crypter;
 }
 
 Encrypter::Encrypter()
 {
-    EVP_CIPHER_CTX *cipherContext = EVP_CIPHER_CTX_new();
 
-    mCipherContext = std::shared_ptr<EVP_CIPHER_CTX>(cipherContext, [](EVP_CIPHER_CTX *data) {
-        EVP_CIPHER_CTX_free(data);
-    });
 }
 
 Encrypter::~Encrypter()
@@ -96,19 +113,314 @@ Encrypter::~Encrypter()
 
 }
 
+AccessKey
+Encrypter::wrapX25519(const AccessKey &input, const PublicKey &publicKey)
+{
+    EVP_PKEY *ephemeral = NULL;
+
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> keyContext(
+        EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, NULL), &EVP_PKEY_CTX_free
+    );
+
+    if (!keyContext || EVP_PKEY_keygen_init(keyContext.get()) <= 0 || EVP_PKEY_keygen(keyContext.get(), &ephemeral) <= 0) {
+        throw Exception("Failed generating the ephemeral key");
+    }
+
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> ephemeralKey(ephemeral, &EVP_PKEY_free);
+
+    auto ephemeralPublicKey = getRawPublicKey(ephemeral);
+
+    auto key = deriveWrappingKey(
+        ephemeral,
+        publicKey.mPkey.get(),
+        ephemeralPublicKey,
+        getRawPublicKey(publicKey.mPkey.get())
+    );
+
+    auto sealed = seal(key, input.getRecipient(), input.getData());
+
+    Buffer data = ephemeralPublicKey;
+    data.insert(data.end(), sealed.begin(), sealed.end());
+
+    AccessKey wrapped;
+
+    wrapped
+        .setRecipient(input.getRecipient())
+        .setData(data)
+        .setAlgorithm(RsaKey::ALGORITHM_X25519)
+        .setVersion(input.getVersion());
+
+    return wrapped;
+}
+
+AccessKey
+Encrypter::unwrapX25519(const AccessKey &input, const PrivateKey &privateKey)
+{
+    auto &data = input.getData();
+
+    if (data.size() < X25519_KEY_LENGTH + WRAP_NONCE_LENGTH + WRAP_TAG_LENGTH) {
+        throw Exception("Malformed access key");
+    }
+
+    Buffer ephemeralPublicKey(data.begin(), data.begin() + X25519_KEY_LENGTH);
+    Buffer sealed(data.begin() + X25519_KEY_LENGTH, data.end());
+
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> ephemeralKey(
+        EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, NULL, ephemeralPublicKey.data(), ephemeralPublicKey.size()),
+        &EVP_PKEY_free
+    );
+
+    if (!ephemeralKey) {
+        throw Exception("Malformed access key");
+    }
+
+    auto key = deriveWrappingKey(
+        privateKey.mPkey.get(),
+        ephemeralKey.get(),
+        ephemeralPublicKey,
+        getRawPublicKey(privateKey.mPkey.get())
+    );
+
+    AccessKey unwrapped;
+
+    unwrapped
+        .setRecipient(input.getRecipient())
+        .setData(open(key, input.getRecipient(), sealed))
+        .setAlgorithm(RsaKey::ALGORITHM_X25519);
+
+    return unwrapped;
+}
+
+Buffer
+Encrypter::seal(const Buffer &key, const Buffer &recipient, const Buffer &input)
+{
+    auto nonce = Buffer::fromRandom(WRAP_NONCE_LENGTH);
+
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> context(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+
+    Buffer output(input.size());
+    Buffer tag(WRAP_TAG_LENGTH);
+
+    int chunk, length;
+
+    // NOTE: the recipient is authenticated, a wrapped key can't be moved to another slot
+    bool success = context
+        && EVP_EncryptInit_ex(context.get(), EVP_aes_256_gcm(), NULL, NULL, NULL)
+        && EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_SET_IVLEN, WRAP_NONCE_LENGTH, NULL)
+        && EVP_EncryptInit_ex(context.get(), NULL, NULL, key.data(), nonce.data())
+        && EVP_EncryptUpdate(context.get(), NULL, &chunk, recipient.data(), (int) recipient.size())
+        && EVP_EncryptUpdate(context.get(), output.data(), &length, input.data(), (int) input.size());
+
+    if (!success) {
+        throw Exception("Failed to wrap the access key");
+    }
+
+    success = EVP_EncryptFinal_ex(context.get(), output.data() + length, &chunk)
+        && EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_GET_TAG, WRAP_TAG_LENGTH, tag.data());
+
+    if (!success) {
+        throw Exception("Failed to wrap the access key");
+    }
+
+    output.resize((size_t) (length + chunk));
+
+    Buffer data = nonce;
+    data.insert(data.end(), output.begin(), output.end());
+    data.insert(data.end(), tag.begin(), tag.end());
+
+    return data;
+}
+
+Buffer
+Encrypter::open(const Buffer &key, const Buffer &recipient, const Buffer &input)
+{
+    if (input.size() < WRAP_NONCE_LENGTH + WRAP_TAG_LENGTH) {
+        throw Exception("Malformed access key");
+    }
+
+    Buffer nonce(input.begin(), input.begin() + WRAP_NONCE_LENGTH);
+    Buffer ciphertext(input.begin() + WRAP_NONCE_LENGTH, input.end() - WRAP_TAG_LENGTH);
+    Buffer tag(input.end() - WRAP_TAG_LENGTH, input.end());
+
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> context(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+
+    Buffer output(ciphertext.size() + ENCRYPT_BLOCK_SIZE);
+
+    int chunk, length;
+
+    bool success = context
+        && EVP_DecryptInit_ex(context.get(), EVP_aes_256_gcm(), NULL, NULL, NULL)
+        && EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_SET_IVLEN, WRAP_NONCE_LENGTH, NULL)
+        && EVP_DecryptInit_ex(context.get(), NULL, NULL, key.data(), nonce.data())
+        && EVP_DecryptUpdate(context.get(), NULL, &chunk, recipient.data(), (int) recipient.size())
+        && EVP_DecryptUpdate(context.get(), output.data(), &length, ciphertext.data(), (int) ciphertext.size())
+        && EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_SET_TAG, WRAP_TAG_LENGTH, tag.data());
+
+    // NOTE: the final step checks the tag
+    if (!success || EVP_DecryptFinal_ex(context.get(), output.data() + length, &chunk) <= 0) {
+        throw Exception("Failed to unwrap the access key");
+    }
+
+    output.resize((size_t) (length + chunk));
+
+    return output;
+}
+
+Buffer
+Encrypter::deriveWrappingKey(EVP_PKEY *ownKey, EVP_PKEY *peerKey, const Buffer &ephemeralKey, const Buffer &recipientKey)
+{
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> context(
+        EVP_PKEY_CTX_new(ownKey, NULL), &EVP_PKEY_CTX_free
+    );
+
+    size_t length = X25519_KEY_LENGTH;
+    Buffer secret(length);
+
+    if (!context || EVP_PKEY_derive_init(context.get()) <= 0 || EVP_PKEY_derive_set_peer(context.get(), peerKey) <= 0 ||
+        EVP_PKEY_derive(context.get(), secret.data(), &length) <= 0) {
+        throw Exception("Failed to derive the shared secret");
+    }
+
+    secret.resize(length);
+
+    // Bind the wrapping key to both the public keys
+    Buffer salt = ephemeralKey;
+    salt.insert(salt.end(), recipientKey.begin(), recipientKey.end());
+
+    static const std::string info = "keymaker access key";
+
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> kdfContext(
+        EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL), &EVP_PKEY_CTX_free
+    );
+
+    length = ENCRYPT_KEY_LENGTH;
+    Buffer key(length);
+
+    bool success = kdfContext
+        && EVP_PKEY_derive_init(kdfContext.get()) > 0
+        && EVP_PKEY_CTX_set_hkdf_md(kdfContext.get(), EVP_sha256()) > 0
+        && EVP_PKEY_CTX_set1_hkdf_salt(kdfContext.get(), salt.data(), (int) salt.size()) > 0
+        && EVP_PKEY_CTX_set1_hkdf_key(kdfContext.get(), secret.data(), (int) secret.size()) > 0
+        && EVP_PKEY_CTX_add1_hkdf_info(kdfContext.get(), (const unsigned char *) info.data(), (int) info.size()) > 0
+        && EVP_PKEY_derive(kdfContext.get(), key.data(), &length) > 0;
+
+    if (!success) {
+        throw Exception("Failed to derive the wrapping key");
+    }
+
+    return key;
+}
+
+Buffer
+Encrypter::getRawPublicKey(EVP_PKEY *key)
+{
+    size_t length = X25519_KEY_LENGTH;
+    Buffer output(length);
+
+    if (EVP_PKEY_get_raw_public_key(key, output.data(), &length) <= 0) {
+        throw Exception("Failed reading the X25519 key");
+    }
+
+    output.resize(length);
+
+    return output;
+}
+
+Buffer
+Encrypter::getGroupFingerprint(const Buffer &groupId)
+{
+    Buffer input = Buffer::fromString("group:");
+    input.insert(input.end(), groupId.begin(), groupId.end());
+
+    Buffer fingerprint(KEY_FINGERPRINT_LENGTH);
+
+    if (!EVP_Digest(input.data(), input.size(), fingerprint.data(), NULL, EVP_sha256(), NULL)) {
+        throw Exception("Failed to generate fingerprint");
+    }
+
+    return fingerprint;
+}
+
+Buffer
+Encrypter::getPublicKeyInfo(EVP_PKEY *key)
+{
+    int length = i2d_PUBKEY(key, NULL);
+
+    if (length <= 0) {
+        throw Exception("Failed encoding the public key");
+    }
+
+    Buffer output((size_t) length);
+
+    unsigned char *data = output.data();
+
+    if (i2d_PUBKEY(key, &data) != length) {
+        throw Exception("Failed encoding the public key");
+    }
+
+    return output;
+}
+
+template <>
+AccessKey
+Encrypter::encrypt<AccessKey>(const AccessKey &input) const
+{
+    AccessKey output;
+
+    output
+        .setRecipient(input.getRecipient())
+        .setData(seal(mAccessKey.getData(), input.getRecipient(), input.getData()))
+        .setAlgorithm(RsaKey::ALGORITHM_GROUP)
+        .setVersion(input.getVersion());
+
+    return output;
+}
+
+template <>
+AccessKey
+Encrypter::decrypt<AccessKey>(const AccessKey &input) const
+{
+    if (input.getAlgorithm() != RsaKey::ALGORITHM_GROUP) {
+        throw Exception("The access key is not wrapped for a group");
+    }
+
+    AccessKey output;
+
+    output
+        .setRecipient(input.getRecipient())
+        .setData(open(mAccessKey.getData(), input.getRecipient(), input.getData()))
+        .setAlgorithm(RsaKey::ALGORITHM_GROUP)
+        .setVersion(input.getVersion());
+
+    return output;
+}
+
+Encrypter
+Encrypter::create(const AccessKey &accessKey, const Encrypter &groupEncrypter)
+{
+    Encrypter crypter;
+
+    crypter.mAccessKey = groupEncrypter.decrypt<AccessKey>(accessKey);
+    crypter.mAccessKey.setVersion(accessKey.getVersion());
+
+    return crypter;
+}
+
 template <>
 TextNode
 Encrypter::encrypt<TextNode>(const TextNode &input) const
 {
     auto nonce = Buffer::fromRandom(ENCRYPT_IV_LENGTH);
 
-    auto content = addPadding(input.getContent(), TEXT_NODE_SIZE);
+    auto content = addPadding(input.getContent());
 
-    return TextNode::create
+    auto output = TextNode::create
     (
         encrypt(content, nonce),
         nonce
     );
+
+    return output.setKeyVersion(mAccessKey.getVersion());
 }
 
 template <>
@@ -117,7 +429,7 @@ Encrypter::decrypt<TextNode>(const TextNode &input) const
 {
     auto nonce = input.getNonce();
 
-    auto content = decrypt(input.getContent(), nonce);
+    auto content = decrypt(input.getContent(), nonce, input.getKeyVersion());
 
     return TextNode::create
     (
@@ -132,15 +444,35 @@ Encrypter::encrypt<PropertyNode>(const PropertyNode &input) const
 {
     auto nonce = Buffer::fromRandom(ENCRYPT_IV_LENGTH);
 
-    auto name    = addPadding(input.getName(),    PROPERTY_NODE_SIZE);
-    auto content = addPadding(input.getContent(), PROPERTY_NODE_SIZE);
+    auto value = input.getContent();
 
-    return PropertyNode::create
+    bool compressed = false;
+
+    // NOTE: only the large values are worth it (the short ones share the smallest size class)
+    if (value.size() >= COMPRESSION_THRESHOLD && value.size() <= COMPRESSION_LIMIT) {
+
+        auto deflated = compress(value);
+
+        if (deflated.size() < value.size()) {
+            value      = deflated;
+            compressed = true;
+        }
+    }
+
+    auto name    = addPadding(input.getName());
+    auto content = addPadding(value);
+
+    auto output = PropertyNode::create
     (
         encrypt(name,    nonce),
         encrypt(content, nonce),
         nonce
     );
+
+    return output
+        .setKeyVersion(mAccessKey.getVersion())
+        .setCompressed(compressed)
+        .setAttachment(input.isAttachment());
 }
 
 template <>
@@ -149,15 +481,28 @@ Encrypter::decrypt<PropertyNode>(const PropertyNode &input) const
 {
     auto nonce = input.getNonce();
 
-    auto name    = decrypt(input.getName(),    nonce);
-    auto content = decrypt(input.getContent(), nonce);
+    // NOTE: the nodes not re-encrypted yet by a rotation use a previous key
+    auto name    = decrypt(input.getName(),    nonce, input.getKeyVersion());
+    auto content = decrypt(input.getContent(), nonce, input.getKeyVersion());
+
+    content = removePadding(content);
 
-    return PropertyNode::create
+    auto output = PropertyNode::create
     (
         removePadding(name),
-        removePadding(content),
+        input.isCompressed() ? decompress(content) : content,
         nonce
     );
+
+    return output.setAttachment(input.isAttachment());
+}
+
+Buffer
+Encrypter::decryptName(const PropertyNode &input) const
+{
+    return removePadding(
+        decrypt(input.getName(), input.getNonce(), input.getKeyVersion())
+    );
 }
 
 template <>
@@ -182,6 +527,38 @@ Encrypter::decrypt<EntryNode>(const EntryNode &input) const
     return output;
 }
 
+EntryNode
+Encrypter::reencrypt(const EntryNode &input, const EntryNode &previous) const
+{
+    std::map<Buffer, std::pair<PropertyNode, Buffer>> unchanged;
+
+    previous.eachProperty([this, &unchanged](const Buffer &key, const PropertyNode &property) {
+
+        // NOTE: the properties encrypted by a previous key are always re-encrypted
+        if (property.getKeyVersion() != mAccessKey.getVersion()) {
+            return;
+        }
+
+        auto clear = decrypt<PropertyNode>(property);
+
+        unchanged.emplace(clear.getName(), std::make_pair(property, clear.getContent()));
+    });
+
+    auto output = input.mapProperty([this, &unchanged](const Buffer &name, const PropertyNode &property) {
+
+        auto it = unchanged.find(property.getName());
+
+        if (it != unchanged.end() && it->second.second == property.getContent()
+                               && it->second.first.isAttachment() == property.isAttachment()) {
+            return it->second.first;
+        }
+
+        return encrypt<PropertyNode>(property);
+    });
+
+    return output;
+}
+
 template <>
 KeyringNode
 Encrypter::encrypt<KeyringNode>(const KeyringNode &input) const
@@ -211,11 +588,16 @@ Encrypter::encrypt(const Buffer &input, const Buffer &iv) const
 
     Buffer output(input.size() + ENCRYPT_BLOCK_SIZE);
 
-    EVP_CIPHER_CTX_init(mCipherContext.get());
+    // NOTE: a context per call, the entries are encrypted by several threads
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> context(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+
+    if (!context) {
+        throw Exception("Error with 'EVP_CIPHER_CTX_new'");
+    }
 
     error = EVP_EncryptInit_ex
     (
-        mCipherContext.get(),
+        context.get(),
         EVP_aes_256_cbc(),
         NULL,
         (unsigned char *) mAccessKey.mData.data(),
@@ -228,7 +610,7 @@ Encrypter::encrypt(const Buffer &input, const Buffer &iv) const
 
     error = EVP_EncryptUpdate
     (
-        mCipherContext.get(),
+        context.get(),
         output.data(),
         &chunk,
         (unsigned char *) input.data(),
@@ -243,7 +625,7 @@ Encrypter::encrypt(const Buffer &input, const Buffer &iv) const
 
     error = EVP_EncryptFinal_ex
     (
-        mCipherContext.get(),
+        context.get(),
         output.data() + length,
         &chunk
     );
@@ -254,8 +636,6 @@ Encrypter::encrypt(const Buffer &input, const Buffer &iv) const
 
     length += chunk;
 
-    EVP_CIPHER_CTX_cleanup(mCipherContext.get());
-
     output.resize((size_t) length);
 
     return output;
@@ -263,19 +643,29 @@ Encrypter::encrypt(const Buffer &input, const Buffer &iv) const
 
 Buffer
 Encrypter::decrypt(const Buffer &input, const Buffer &iv) const
+{
+    return decrypt(input, iv, mAccessKey.getVersion());
+}
+
+Buffer
+Encrypter::decrypt(const Buffer &input, const Buffer &iv, unsigned int version) const
 {
     int chunk, error, length = 0;
 
     Buffer output(input.size() + ENCRYPT_BLOCK_SIZE);
 
-    EVP_CIPHER_CTX_init(mCipherContext.get());
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> context(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+
+    if (!context) {
+        throw Exception("Error with 'EVP_CIPHER_CTX_new'");
+    }
 
     error = EVP_DecryptInit_ex
     (
-        mCipherContext.get(),
+        context.get(),
         EVP_aes_256_cbc(),
         NULL,
-        (unsigned char *) mAccessKey.mData.data(),
+        (unsigned char *) getKey(version).data(),
         (unsigned char *) iv.data()
     );
 
@@ -285,7 +675,7 @@ Encrypter::decrypt(const Buffer &input, const Buffer &iv) const
 
     error = EVP_DecryptUpdate
     (
-        mCipherContext.get(),
+        context.get(),
         output.data(),
         &chunk,
         (unsigned char *) input.data(),
@@ -300,7 +690,7 @@ Encrypter::decrypt(const Buffer &input, const Buffer &iv) const
 
     error = EVP_DecryptFinal_ex
     (
-        mCipherContext.get(),
+        context.get(),
         output.data() + length,
         &chunk
     );
@@ -311,20 +701,173 @@ Encrypter::decrypt(const Buffer &input, const Buffer &iv) const
 
     length += chunk;
 
-    EVP_CIPHER_CTX_cleanup(mCipherContext.get());
-
     output.resize((size_t) length);
 
     return output;
 }
 
+const Buffer &
+Encrypter::getKey(unsigned int version) const
+{
+    if (version == mAccessKey.getVersion()) {
+        return mAccessKey.getData();
+    }
+
+    auto it = mKeyHistory.find(version);
+
+    if (it == mKeyHistory.end()) {
+        throw Exception("Unknown access key version '%1%' (see `km fetch`)", version);
+    }
+
+    return it->second;
+}
+
 Buffer
-Encrypter::addPadding(const Buffer &buffer, size_t size) const
+Encrypter::getDigest(const Buffer &input, unsigned int version) const
 {
-    Buffer output = Buffer::fromRandom(size + 1);
+    static const std::string label = "keymaker digest";
+
+    auto &key = getKey(version);
+
+    Buffer digestKey(EVP_MAX_MD_SIZE);
+    Buffer output(EVP_MAX_MD_SIZE);
+
+    unsigned int length = 0;
+
+    // NOTE: the access key itself is never used for both encryption and authentication
+    if (!HMAC(EVP_sha256(), key.data(), (int) key.size(), (const unsigned char *) label.data(), label.size(), digestKey.data(), &length)) {
+        throw Exception("Error with 'HMAC'");
+    }
+
+    digestKey.resize(length);
+
+    if (!HMAC(EVP_sha256(), digestKey.data(), (int) digestKey.size(), input.data(), input.size(), output.data(), &length)) {
+        throw Exception("Error with 'HMAC'");
+    }
+
+    output.resize(length);
+
+    return output;
+}
+
+/*!
+ * Returns the input of the seal of a root hash (kept apart from the chunk digests).
+ */
+static Buffer
+getSealInput(const Buffer &root)
+{
+    auto input = Buffer::fromString("keymaker tree\n");
+    input.insert(input.end(), root.begin(), root.end());
+
+    return input;
+}
+
+const Encrypter &
+Encrypter::seal(MerkleTree &tree) const
+{
+    auto version = getAccessKey().getVersion();
+
+    tree.setSeal(getDigest(getSealInput(tree.getRoot()), version), version);
+
+    return *this;
+}
+
+bool
+Encrypter::isSealed(const MerkleTree &tree) const
+{
+    auto &seal = tree.getSeal();
+
+    if (seal.empty()) {
+        return false;
+    }
+
+    auto digest = getDigest(getSealInput(tree.getRoot()), tree.getSealVersion());
+
+    return digest.size() == seal.size() && CRYPTO_memcmp(digest.data(), seal.data(), seal.size()) == 0;
+}
+
+Buffer
+Encrypter::compress(const Buffer &buffer)
+{
+    uLongf length = compressBound((uLong) buffer.size());
+
+    Buffer output((std::size_t) length);
+
+    int error = compress2(output.data(), &length, buffer.data(), (uLong) buffer.size(), COMPRESSION_LEVEL);
+
+    if (error != Z_OK) {
+        throw Exception("Failed to compress the property (zlib error %1%)", error);
+    }
+
+    output.resize((std::size_t) length);
+
+    return output;
+}
+
+Buffer
+Encrypter::decompress(const Buffer &buffer)
+{
+    z_stream stream = {};
+
+    if (inflateInit(&stream) != Z_OK) {
+        throw Exception("Failed to decompress the property");
+    }
+
+    stream.next_in  = (Bytef *) buffer.data();
+    stream.avail_in = (uInt) buffer.size();
+
+    // NOTE: the original size is not stored, the output grows as needed up to the limit
+    Buffer output(std::min<std::size_t>(
+        std::max<std::size_t>(buffer.size() * 4, COMPRESSION_THRESHOLD), COMPRESSION_LIMIT
+    ));
+
+    int error;
+
+    do {
+
+        if (stream.total_out == output.size()) {
+
+            if (output.size() >= COMPRESSION_LIMIT) {
+                inflateEnd(&stream);
+                throw Exception("The decompressed property exceeds %1% bytes", (std::size_t) COMPRESSION_LIMIT);
+            }
+
+            output.resize(std::min<std::size_t>(output.size() * 2, COMPRESSION_LIMIT));
+        }
+
+        stream.next_out  = output.data() + stream.total_out;
+        stream.avail_out = (uInt) (output.size() - stream.total_out);
+
+        error = inflate(&stream, Z_NO_FLUSH);
+
+    } while (error == Z_OK);
+
+    inflateEnd(&stream);
+
+    if (error != Z_STREAM_END) {
+        throw Exception("Failed to decompress the property (zlib error %1%)", error);
+    }
+
+    output.resize((std::size_t) stream.total_out);
+
+    return output;
+}
+
+Buffer
+Encrypter::addPadding(const Buffer &buffer) const
+{
+    std::size_t size = mPaddingSize;
+
+    // The smallest class holding the buffer and the marker
+    while (size < buffer.size() + 2) {
+        size <<= 1;
+    }
+
+    // NOTE: the fill is not random, the ciphertext already is (CBC with a random IV)
+    Buffer output(size - 1);
 
     std::copy(buffer.cbegin(), buffer.cend(), output.begin());
-    output[buffer.size()] = PADDING_DIVISOR;
+    output[buffer.size()] = PADDING_MARKER;
 
     return output;
 }
@@ -334,10 +877,84 @@ Encrypter::removePadding(const Buffer &buffer) const
 {
     Buffer output(buffer);
 
-    auto it = std::find(output.cbegin(), output.cend(), PADDING_DIVISOR);
-    output.resize((std::size_t) std::distance(output.cbegin(), it));
+    // NOTE: the size classes are one byte short of a power of two, the legacy blocks one byte longer
+    bool legacy = (output.size() & (output.size() + 1)) != 0;
+
+    if (legacy) {
+
+        auto it = std::find(output.cbegin(), output.cend(), PADDING_DIVISOR);
+        output.resize((std::size_t) std::distance(output.cbegin(), it));
+
+        return output;
+    }
+
+    auto it = std::find_if(output.crbegin(), output.crend(), [](std::uint8_t byte) {
+        return byte != 0;
+    });
+
+    if (it == output.crend() || *it != PADDING_MARKER) {
+        throw Exception("Malformed padding");
+    }
+
+    output.resize((std::size_t) std::distance(it + 1, output.crend()));
 
     return output;
 }
 
+void
+Encrypter::setPaddingSize(std::size_t size)
+{
+    if (size < ENCRYPT_BLOCK_SIZE || (size & (size - 1)) != 0) {
+        throw Exception("The padding size must be a power of two, from %1% bytes", (int) ENCRYPT_BLOCK_SIZE);
+    }
+
+    mPaddingSize = size;
+}
+
+Encrypter
+Encrypter::rotate() const
+{
+    Encrypter crypter;
+
+    crypter.mKeyHistory = mKeyHistory;
+    crypter.mKeyHistory[mAccessKey.getVersion()] = mAccessKey.getData();
+
+    crypter.mAccessKey
+        .setRecipient(mAccessKey.getRecipient())
+        .setData(Buffer::fromRandom(ENCRYPT_KEY_LENGTH))
+        .setAlgorithm(mAccessKey.getAlgorithm())
+        .setVersion(mAccessKey.getVersion() + 1);
+
+    return crypter;
+}
+
+Encrypter &
+Encrypter::setKeyHistory(const std::vector<PropertyNode> &history)
+{
+    mKeyHistory.clear();
+
+    for (auto &node : history) {
+
+        auto key = decrypt<PropertyNode>(node);
+
+        mKeyHistory[(unsigned int) std::stoul(key.getName().toString())] = key.getContent();
+    }
+
+    return *this;
+}
+
+std::vector<PropertyNode>
+Encrypter::getKeyHistory() const
+{
+    std::vector<PropertyNode> history;
+
+    for (auto &key : mKeyHistory) {
+        history.push_back(encrypt<PropertyNode>(
+            PropertyNode::create(Buffer::fromString(std::to_string(key.first)), key.second)
+        ));
+    }
+
+    return history;
+}
+
 } // End of main namespace
\ No newline at end of file
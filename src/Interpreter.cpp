@@ -250,7 +250,8 @@ Interpreter::operator()(const ast::commit_stmt &stmt)
 void
 Interpreter::operator()(const ast::push_stmt &stmt)
 {
-    // TODO
+    // NOTE: the push runs in background
+    mCore.pushRepository();
 }
 
 void
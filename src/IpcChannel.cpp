@@ -0,0 +1,164 @@
+/*!
+ * Title ---- km/IpcChannel.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/IpcChannel.hpp>
+
+#include <poll.h>
+#include <cerrno>
+#include <climits>
+
+namespace km { // Begin main namespace
+
+std::shared_ptr<IpcChannel>
+IpcChannel::connect(const filesystem::path &path)
+{
+    if (!filesystem::exists(path)) {
+        return nullptr;
+    }
+
+    auto ioService = std::make_shared<asio::io_service>();
+
+    auto channel = std::make_shared<IpcChannel>(*ioService);
+    channel->mIoService = ioService;
+
+    system::error_code error;
+
+    channel->mSocket.connect(asio::local::stream_protocol::endpoint(path.string()), error);
+
+    if (error) {
+        return nullptr;
+    }
+
+    return channel;
+}
+
+IpcChannel::IpcChannel(asio::io_service &ioService) : mSocket(ioService)
+{
+
+}
+
+IpcChannel::~IpcChannel()
+{
+    close();
+}
+
+void
+IpcChannel::send(const Message &message)
+{
+    Buffer output;
+
+    writeLength(output, (std::uint32_t) message.size());
+
+    for (auto &field : message) {
+        writeLength(output, (std::uint32_t) field.size());
+        output.insert(output.end(), field.begin(), field.end());
+    }
+
+    asio::write(mSocket, asio::buffer(output.data(), output.size()));
+}
+
+IpcChannel::Message
+IpcChannel::receive()
+{
+    return receive(Clock::time_point::max());
+}
+
+IpcChannel::Message
+IpcChannel::receive(Clock::time_point deadline)
+{
+    auto numOfFields = readLength(deadline);
+
+    if (numOfFields > MAX_FIELDS) {
+        throw Exception("IpcChannel: too many fields");
+    }
+
+    Message message;
+
+    for (std::uint32_t i = 0; i < numOfFields; ++i) {
+
+        auto size = readLength(deadline);
+
+        if (size > MAX_FIELD_SIZE) {
+            throw Exception("IpcChannel: field too large");
+        }
+
+        Buffer field(size);
+
+        read(field.data(), field.size(), deadline);
+
+        message.push_back(std::move(field));
+    }
+
+    return message;
+}
+
+void
+IpcChannel::close()
+{
+    system::error_code error;
+
+    mSocket.shutdown(Socket::shutdown_both, error);
+    mSocket.close(error);
+}
+
+void
+IpcChannel::writeLength(Buffer &output, std::uint32_t value)
+{
+    output.push_back((std::uint8_t) (value >> 24));
+    output.push_back((std::uint8_t) (value >> 16));
+    output.push_back((std::uint8_t) (value >> 8));
+    output.push_back((std::uint8_t) value);
+}
+
+std::uint32_t
+IpcChannel::readLength(Clock::time_point deadline)
+{
+    std::uint8_t data[4];
+
+    read(data, sizeof(data), deadline);
+
+    return ((std::uint32_t) data[0] << 24) |
+           ((std::uint32_t) data[1] << 16) |
+           ((std::uint32_t) data[2] << 8)  |
+            (std::uint32_t) data[3];
+}
+
+void
+IpcChannel::read(std::uint8_t *data, std::size_t size, Clock::time_point deadline)
+{
+    if (deadline == Clock::time_point::max()) {
+        asio::read(mSocket, asio::buffer(data, size));
+        return;
+    }
+
+    // NOTE: the blocking reads of asio retry on EAGAIN, so SO_RCVTIMEO can't bound them
+    for (std::size_t offset = 0; offset < size; ) {
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+
+        if (remaining <= 0) {
+            throw Exception("IpcChannel: receive timed out");
+        }
+
+        pollfd descriptor = { mSocket.native_handle(), POLLIN, 0 };
+
+        int ready = ::poll(&descriptor, 1, (int) std::min<long long>(remaining, INT_MAX));
+
+        if (ready < 0 && errno != EINTR) {
+            throw Exception("IpcChannel: failed waiting for a message");
+        }
+
+        if (ready > 0) {
+            offset += mSocket.read_some(asio::buffer(data + offset, size - offset));
+        }
+    }
+}
+
+} // End of main namespace
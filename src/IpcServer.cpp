@@ -0,0 +1,201 @@
+/*!
+ * Title ---- km/IpcServer.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/IpcServer.hpp>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace km { // Begin main namespace
+
+IpcServer::IpcServer(const filesystem::path &socketPath)
+:
+    mSocketPath(socketPath),
+    mRunning(false)
+{
+
+}
+
+IpcServer::~IpcServer()
+{
+    stop();
+}
+
+void
+IpcServer::listen()
+{
+    // Replace the socket left by a server that did not exit cleanly
+    if (filesystem::exists(mSocketPath)) {
+
+        if (IpcChannel::connect(mSocketPath)) {
+            throw Exception("IpcServer: already running on '%1%'", mSocketPath.string());
+        }
+
+        filesystem::remove(mSocketPath);
+    }
+
+    asio::local::stream_protocol::endpoint endpoint(mSocketPath.string());
+
+    mAcceptor = std::make_unique<asio::local::stream_protocol::acceptor>(mIoService);
+    mAcceptor->open(endpoint.protocol());
+
+    // NOTE: only the owner can reach the socket
+    auto mask = ::umask(0177);
+
+    system::error_code error;
+    mAcceptor->bind(endpoint, error);
+
+    ::umask(mask);
+
+    if (error) {
+        throw Exception("IpcServer: cannot bind '%1%': %2%", mSocketPath.string(), error.message());
+    }
+
+    mAcceptor->listen();
+
+    mRunning      = true;
+    mAcceptThread = std::thread(&IpcServer::accept, this);
+}
+
+void
+IpcServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (!mRunning) {
+            return;
+        }
+
+        mRunning = false;
+
+        // Wake up the readers
+        for (auto &connection : mConnections) {
+            system::error_code error;
+            connection->getSocket().shutdown(IpcChannel::Socket::shutdown_both, error);
+        }
+    }
+
+    // Wake up the acceptor
+    IpcChannel::connect(mSocketPath);
+
+    mAcceptThread.join();
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        mCondition.wait(lock, [this]() {
+            return mConnections.empty();
+        });
+    }
+
+    system::error_code error;
+    mAcceptor->close(error);
+
+    filesystem::remove(mSocketPath, error);
+}
+
+void
+IpcServer::accept()
+{
+    while (true) {
+
+        auto connection = std::make_shared<IpcChannel>(mIoService);
+
+        system::error_code error;
+        mAcceptor->accept(connection->getSocket(), error);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (!mRunning) {
+            break;
+        }
+
+        if (error || !checkPeer(connection)) {
+            continue;
+        }
+
+        mConnections.insert(connection);
+
+        std::thread(&IpcServer::serve, this, connection).detach();
+    }
+}
+
+void
+IpcServer::serve(Connection connection)
+{
+    try {
+
+        while (true) {
+
+            auto message = connection->receive();
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+
+                if (!mRunning) {
+                    break;
+                }
+            }
+
+            receive(connection, message);
+        }
+
+    } catch (std::exception &) {
+        // The client has disconnected
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mConnections.erase(connection);
+    mCondition.notify_all();
+}
+
+bool
+IpcServer::checkPeer(Connection connection)
+{
+    auto socket = connection->getSocket().native_handle();
+
+    uid_t uid;
+
+    # if defined(SO_PEERCRED)
+        struct ucred credentials;
+        socklen_t length = sizeof(credentials);
+
+        if (getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &length)) {
+            return false;
+        }
+
+        uid = credentials.uid;
+    # else
+        gid_t gid;
+
+        if (getpeereid(socket, &uid, &gid)) {
+            return false;
+        }
+    # endif
+
+    return uid == geteuid();
+}
+
+void
+IpcServer::reply(Connection connection, const IpcChannel::Message &message)
+{
+    try {
+        connection->send(message);
+
+    } catch (std::exception &) {
+        // The client has disconnected
+    }
+}
+
+} // End of main namespace
@@ -0,0 +1,405 @@
+/*!
+ * Title ---- km/JsonReader.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/JsonReader.hpp>
+
+namespace km { // Begin main namespace
+
+JsonReader::JsonReader(Callback callback)
+:
+    mCallback(callback),
+    mExpect(EXPECT_VALUE),
+    mToken(TOKEN_NONE),
+    mKey(false),
+    mEscape(false),
+    mSurrogate(0),
+    mOffset(0)
+{
+
+}
+
+JsonReader::~JsonReader()
+{
+
+}
+
+JsonReader &
+JsonReader::feed(const char *data, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i, ++mOffset) {
+        parse(data[i]);
+    }
+
+    return *this;
+}
+
+JsonReader &
+JsonReader::finish()
+{
+    if (mToken == TOKEN_LITERAL) {
+        endLiteral();
+    }
+
+    if (mToken != TOKEN_NONE || mExpect != EXPECT_END) {
+        throwError("unexpected end of input");
+    }
+
+    return *this;
+}
+
+void
+JsonReader::parse(char c)
+{
+    if (mToken == TOKEN_STRING) {
+        parseString(c);
+        return;
+    }
+
+    if (mToken == TOKEN_LITERAL) {
+
+        if (std::isalnum((unsigned char) c) || c == '-' || c == '+' || c == '.') {
+            mValue.push_back(c);
+            return;
+        }
+
+        endLiteral();
+    }
+
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        return;
+    }
+
+    switch (mExpect) {
+
+        case EXPECT_VALUE:
+
+            if (c == ']' && !mFrames.empty() && mFrames.back().array && mFrames.back().empty) {
+                endContainer(true);
+                return;
+            }
+
+            markFrame();
+
+            if (c == '{' || c == '[') {
+                beginContainer(c == '[');
+
+            } else if (c == '"') {
+                mToken = TOKEN_STRING;
+                mKey   = false;
+                mValue.clear();
+
+            } else if (c == '-' || std::isdigit((unsigned char) c) || c == 't' || c == 'f' || c == 'n') {
+                mToken = TOKEN_LITERAL;
+                mValue.assign(1, c);
+
+            } else {
+                throwError("unexpected character");
+            }
+
+            break;
+
+        case EXPECT_KEY:
+
+            if (c == '}' && mFrames.back().empty) {
+                endContainer(false);
+
+            } else if (c == '"') {
+                markFrame();
+
+                mToken = TOKEN_STRING;
+                mKey   = true;
+                mValue.clear();
+
+            } else {
+                throwError("expected an object key");
+            }
+
+            break;
+
+        case EXPECT_COLON:
+
+            if (c != ':') {
+                throwError("expected ':'");
+            }
+
+            mExpect = EXPECT_VALUE;
+            break;
+
+        case EXPECT_NEXT:
+
+            if (c == ',') {
+
+                auto &frame = mFrames.back();
+
+                if (frame.array) {
+                    mPath.back() = std::to_string(++frame.index);
+                    mExpect = EXPECT_VALUE;
+
+                } else {
+                    mPath.pop_back();
+                    mExpect = EXPECT_KEY;
+                }
+
+            } else if (c == '}' || c == ']') {
+                endContainer(c == ']');
+
+            } else {
+                throwError("expected ',' or the end of the container");
+            }
+
+            break;
+
+        case EXPECT_END:
+            throwError("unexpected data after the end of input");
+    }
+}
+
+void
+JsonReader::parseString(char c)
+{
+    if (!mUnicode.empty()) {
+
+        if (!std::isxdigit((unsigned char) c)) {
+            throwError("invalid unicode escape");
+        }
+
+        mUnicode.push_back(c);
+
+        if (mUnicode.size() < 5) {
+            return;
+        }
+
+        auto codePoint = (std::uint32_t) std::strtoul(mUnicode.c_str() + 1, nullptr, 16);
+
+        mUnicode.clear();
+
+        // Join the surrogate pairs
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+            mSurrogate = codePoint;
+            return;
+        }
+
+        if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+
+            if (!mSurrogate) {
+                throwError("invalid unicode surrogate");
+            }
+
+            codePoint = 0x10000 + ((mSurrogate - 0xD800) << 10) + (codePoint - 0xDC00);
+        }
+
+        mSurrogate = 0;
+
+        appendCodePoint(codePoint);
+        return;
+    }
+
+    if (mSurrogate && !mEscape && c != '\\') {
+        throwError("invalid unicode surrogate");
+    }
+
+    if (mEscape) {
+
+        mEscape = false;
+
+        switch (c) {
+            case '"':  mValue.push_back('"');  break;
+            case '\\': mValue.push_back('\\'); break;
+            case '/':  mValue.push_back('/');  break;
+            case 'b':  mValue.push_back('\b'); break;
+            case 'f':  mValue.push_back('\f'); break;
+            case 'n':  mValue.push_back('\n'); break;
+            case 'r':  mValue.push_back('\r'); break;
+            case 't':  mValue.push_back('\t'); break;
+            case 'u':  mUnicode.assign(1, 'u'); break;
+
+            default:
+                throwError("invalid escape sequence");
+        }
+
+        if (mSurrogate && c != 'u') {
+            throwError("invalid unicode surrogate");
+        }
+
+        return;
+    }
+
+    if (c == '\\') {
+        mEscape = true;
+        return;
+    }
+
+    if (c == '"') {
+
+        mToken = TOKEN_NONE;
+
+        if (mKey) {
+            mPath.push_back(mValue);
+            mExpect = EXPECT_COLON;
+
+        } else {
+            mCallback(mPath, mValue);
+            endValue();
+        }
+
+        return;
+    }
+
+    if ((unsigned char) c < 0x20) {
+        throwError("control character in string");
+    }
+
+    mValue.push_back(c);
+}
+
+void
+JsonReader::beginContainer(bool array)
+{
+    if (mFrames.size() >= MAX_DEPTH) {
+        throwError("too many nested containers");
+    }
+
+    mFrames.push_back({ array, 0, true });
+
+    if (array) {
+        mPath.push_back("0");
+        mExpect = EXPECT_VALUE;
+
+    } else {
+        mExpect = EXPECT_KEY;
+    }
+}
+
+void
+JsonReader::endContainer(bool array)
+{
+    if (mFrames.empty() || mFrames.back().array != array) {
+        throwError("mismatched container end");
+    }
+
+    // Drop the array index or the last object key
+    if (array || !mFrames.back().empty) {
+        mPath.pop_back();
+    }
+
+    mFrames.pop_back();
+
+    endValue();
+}
+
+void
+JsonReader::endLiteral()
+{
+    mToken = TOKEN_NONE;
+
+    // NOTE: strtod() would also take 'nan', 'inf', hexadecimal and leading zeros
+    if (mValue != "true" && mValue != "false" && mValue != "null" && !isNumber(mValue)) {
+        throwError("invalid literal '" + mValue + "'");
+    }
+
+    mCallback(mPath, mValue);
+    endValue();
+}
+
+bool
+JsonReader::isNumber(const std::string &value)
+{
+    std::size_t i = 0, size = value.size();
+
+    auto digits = [&value, &i, size]() {
+
+        auto start = i;
+
+        while (i < size && std::isdigit((unsigned char) value[i])) {
+            ++i;
+        }
+
+        return i > start;
+    };
+
+    if (i < size && value[i] == '-') {
+        ++i;
+    }
+
+    // The integer part, without leading zeros
+    if (i < size && value[i] == '0') {
+        ++i;
+
+    } else if (!digits()) {
+        return false;
+    }
+
+    if (i < size && value[i] == '.') {
+        ++i;
+
+        if (!digits()) {
+            return false;
+        }
+    }
+
+    if (i < size && (value[i] == 'e' || value[i] == 'E')) {
+        ++i;
+
+        if (i < size && (value[i] == '+' || value[i] == '-')) {
+            ++i;
+        }
+
+        if (!digits()) {
+            return false;
+        }
+    }
+
+    return i == size;
+}
+
+void
+JsonReader::endValue()
+{
+    mExpect = mFrames.empty() ? EXPECT_END : EXPECT_NEXT;
+}
+
+void
+JsonReader::markFrame()
+{
+    if (!mFrames.empty()) {
+        mFrames.back().empty = false;
+    }
+}
+
+void
+JsonReader::appendCodePoint(std::uint32_t codePoint)
+{
+    if (codePoint < 0x80) {
+        mValue.push_back((char) codePoint);
+
+    } else if (codePoint < 0x800) {
+        mValue.push_back((char) (0xC0 | (codePoint >> 6)));
+        mValue.push_back((char) (0x80 | (codePoint & 0x3F)));
+
+    } else if (codePoint < 0x10000) {
+        mValue.push_back((char) (0xE0 | (codePoint >> 12)));
+        mValue.push_back((char) (0x80 | ((codePoint >> 6) & 0x3F)));
+        mValue.push_back((char) (0x80 | (codePoint & 0x3F)));
+
+    } else {
+        mValue.push_back((char) (0xF0 | (codePoint >> 18)));
+        mValue.push_back((char) (0x80 | ((codePoint >> 12) & 0x3F)));
+        mValue.push_back((char) (0x80 | ((codePoint >> 6) & 0x3F)));
+        mValue.push_back((char) (0x80 | (codePoint & 0x3F)));
+    }
+}
+
+void
+JsonReader::throwError(const std::string &message) const
+{
+    throw Exception("JsonReader: %1% at offset %2%", message, mOffset);
+}
+
+} // End of main namespace
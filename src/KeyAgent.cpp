@@ -0,0 +1,381 @@
+/*!
+ * Title ---- km/KeyAgent.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/KeyAgent.hpp>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+
+namespace km { // Begin main namespace
+
+const filesystem::path
+KeyAgent::SocketFile = "agent.sock";
+
+bool
+KeyAgent::request(const filesystem::path &path, const IpcChannel::Message &request, IpcChannel::Message &response)
+{
+    auto channel = IpcChannel::connect(path);
+
+    if (!channel) {
+        return false;
+    }
+
+    channel->send(request);
+
+    auto message = channel->receive();
+
+    if (message.empty()) {
+        throw Exception("KeyAgent: malformed response");
+    }
+
+    if (message[0] != Buffer::fromString("ok")) {
+        throw Exception(message.size() > 1 ? message[1].toString() : "KeyAgent: request failed");
+    }
+
+    response.assign(message.begin() + 1, message.end());
+
+    return true;
+}
+
+KeyAgent::KeyAgent(const filesystem::path &socketPath, const filesystem::path &keyringPath, const PrivateKey &privateKey, PushQueue &pushQueue)
+:
+    IpcServer(socketPath),
+    mKeyringPath(keyringPath),
+    mPrivateKey(privateKey),
+    mPushQueue(pushQueue),
+    mLocked(false),
+    mMemoryLock(true)
+{
+
+}
+
+KeyAgent::~KeyAgent()
+{
+    stop();
+}
+
+KeyAgent &
+KeyAgent::run(std::chrono::seconds idleTimeout)
+{
+    lockMemory(mMemoryLock);
+
+    BEGIN_TASK("agent", "Open agent socket");
+    listen();
+    END_TASK();
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        mLastActivity = Clock::now();
+
+        while (!mLocked && Clock::now() < mLastActivity + idleTimeout) {
+            mCondition.wait_until(lock, mLastActivity + idleTimeout);
+        }
+    }
+
+    stop();
+
+    // NOTE: the buffers are wiped on release
+    mKeyrings.clear();
+
+    return *this;
+}
+
+void
+KeyAgent::receive(Connection connection, IpcChannel::Message &message)
+{
+    IpcChannel::Message response;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mLastActivity = Clock::now();
+
+        try {
+            response = handle(message);
+
+        } catch (std::exception &e) {
+            response = { Buffer::fromString("error"), Buffer::fromString(e.what()) };
+        }
+    }
+
+    mCondition.notify_all();
+
+    reply(connection, response);
+}
+
+IpcChannel::Message
+KeyAgent::handle(const IpcChannel::Message &request)
+{
+    IpcChannel::Message response = { Buffer::fromString("ok") };
+
+    if (request.empty()) {
+        throw Exception("KeyAgent: empty request");
+    }
+
+    auto &command = request[0];
+
+    if (command == Buffer::fromString("lock")) {
+        mLocked = true;
+
+    } else if (command == Buffer::fromString("list") && request.size() == 2) {
+
+        auto &keyring = getKeyring(request[1]);
+
+        Buffer list;
+
+        // NOTE: one line per entry, the keyrings may exceed the field limit
+        keyring.node->eachEntry([&keyring, &list](const Buffer &id, const EntryNode &entry) {
+
+            list.insert(list.end(), id.begin(), id.end());
+            list.push_back('\t');
+
+            try {
+
+                auto name = keyring.encrypter->decryptProperty(entry, Buffer::fromString("name"));
+
+                list.insert(list.end(), name.getContent().begin(), name.getContent().end());
+
+            } catch (PropertyNotFoundException &e) {
+                // Unnamed entry
+            }
+
+            list.push_back('\n');
+        });
+
+        response.push_back(list);
+
+    } else if (command == Buffer::fromString("get") && (request.size() == 3 || request.size() == 4)) {
+
+        auto entry = findEntry(getKeyring(request[1]), request[2]);
+
+        if (request.size() == 4) {
+            response.push_back(entry.getProperty(request[3]).getContent());
+
+        } else {
+            entry.eachProperty([&response](const Buffer &name, PropertyNode &property) {
+                response.push_back(name);
+                response.push_back(property.getContent());
+            });
+        }
+
+    } else if (command == Buffer::fromString("set") && request.size() == 5) {
+
+        auto &keyring = getKeyring(request[1]);
+
+        auto entry = findEntry(keyring, request[2]);
+        entry.setProperty(request[3], request[4]);
+
+        auto path = keyring.repository->getPath();
+
+        auto output = keyring.encrypter->reencrypt(entry, keyring.node->getEntry(entry.getId()));
+
+        keyring.node
+            ->setEntry(output)
+            .save(path, *keyring.encrypter)
+        ;
+
+        auto textNode = keyring.encrypter->encrypt<TextNode>(
+            TextNode::create(Buffer::fromString("Update entry"))
+        );
+
+        keyring.repository
+            ->add("entries/*")
+            .update("entries/*")
+            .add(MerkleTree::TreeFile)
+            .commit(textNode.toBuffer())
+        ;
+
+        keyring.stamp = getStamp(*keyring.repository);
+
+        updateCatalog(request[1], keyring, entry);
+
+        mPushQueue.enqueue(request[1]);
+
+    } else {
+        throw Exception("KeyAgent: invalid request");
+    }
+
+    // The response is sent as a single message
+    if (response.size() > IpcChannel::MAX_FIELDS) {
+        throw Exception("KeyAgent: response too large");
+    }
+
+    return response;
+}
+
+KeyAgent::Keyring &
+KeyAgent::getKeyring(const Buffer &repositoryId)
+{
+    auto path = mKeyringPath / repositoryId.toString();
+
+    if (!Repository::isValid(path)) {
+        throw Exception("KeyAgent: unknown repository '%1%'", repositoryId);
+    }
+
+    auto &keyring = mKeyrings[repositoryId];
+
+    if (!keyring.repository) {
+        keyring.repository = std::make_unique<Repository>(
+            Repository::fromPath(repositoryId, path, mPrivateKey)
+        );
+    }
+
+    auto stamp = getStamp(*keyring.repository);
+
+    if (keyring.node && keyring.stamp == stamp) {
+        return keyring;
+    }
+
+    keyring.node = std::make_unique<KeyringNode>(
+        KeyringNode::fromPath(path)
+    );
+
+    auto accessKey = keyring.node->getAccessKey(
+        Encrypter::getFingerprint(mPrivateKey)
+    );
+
+    keyring.encrypter = std::make_unique<Encrypter>(
+        Encrypter::create(accessKey, mPrivateKey)
+    );
+
+    // NOTE: the entries may still be encrypted by a previous key (during a rotation)
+    keyring.encrypter->setKeyHistory(keyring.node->getKeyHistory());
+
+    keyring.stamp = stamp;
+
+    return keyring;
+}
+
+EntryNode
+KeyAgent::findEntry(Keyring &keyring, const Buffer &reference) const
+{
+    Buffer entryId;
+
+    keyring.node->eachEntry([&keyring, &reference, &entryId](const Buffer &id, const EntryNode &entry) {
+
+        if (!entryId.empty()) {
+            return;
+        }
+
+        if (id == reference) {
+            entryId = id;
+            return;
+        }
+
+        try {
+
+            auto name = keyring.encrypter->decryptProperty(entry, Buffer::fromString("name"));
+
+            if (name.getContent() == reference) {
+                entryId = id;
+            }
+
+        } catch (PropertyNotFoundException &e) {
+            // Unnamed entry
+        }
+    });
+
+    if (entryId.empty()) {
+        throw Exception("KeyAgent: entry '%1%' not found", reference);
+    }
+
+    return keyring.encrypter->decrypt<EntryNode>(
+        keyring.node->getEntry(entryId)
+    );
+}
+
+void
+KeyAgent::updateCatalog(const Buffer &repositoryId, const Keyring &keyring, const EntryNode &entry) const
+{
+    auto path = mSocketPath.parent_path() / Catalog::CatalogFile;
+
+    // NOTE: a missing catalog is built on the first lookup
+    if (!filesystem::exists(path)) {
+        return;
+    }
+
+    try {
+
+        auto catalog = Catalog::fromFile(path, mPrivateKey);
+
+        if (catalog.hasRepository(repositoryId)) {
+            catalog.setEntry(repositoryId, entry);
+        } else {
+            catalog.setKeyring(repositoryId, *keyring.node, *keyring.encrypter);
+        }
+
+        Catalog::toFile(path, catalog);
+
+    } catch (std::exception &e) {
+
+        // Rebuilt on the next lookup
+        system::error_code error;
+        filesystem::remove(path, error);
+    }
+}
+
+std::string
+KeyAgent::getStamp(const Repository &repository)
+{
+    std::ostringstream stamp;
+
+    try {
+        stamp << repository.getHead();
+
+    } catch (std::exception &e) {
+        // Empty repository
+    }
+
+    for (auto &file : { KeyringNode::ConfigFile, KeyringNode::AccessDir / KeyringNode::ManifestFile, MerkleTree::TreeFile }) {
+
+        auto path = repository.getPath() / file;
+
+        system::error_code error;
+
+        auto time = filesystem::last_write_time(path, error);
+        auto size = filesystem::file_size(path, error);
+
+        stamp << ";" << (error ? -1 : time) << ":" << (error ? 0 : size);
+    }
+
+    return stamp.str();
+}
+
+void
+KeyAgent::lockMemory(bool memoryLock)
+{
+    BEGIN_TASK("agent", "Lock memory");
+
+    struct rlimit limit = { 0, 0 };
+
+    if (setrlimit(RLIMIT_CORE, &limit)) {
+        throw Exception("KeyAgent: unable to disable the core dumps");
+    }
+
+    # if defined(__linux__)
+        if (prctl(PR_SET_DUMPABLE, 0)) {
+            throw Exception("KeyAgent: unable to disable the core dumps");
+        }
+    # endif
+
+    // NOTE: the agent doesn't start with the keys in swappable memory
+    if (memoryLock && mlockall(MCL_CURRENT | MCL_FUTURE)) {
+        throw Exception("KeyAgent: unable to lock the memory (see `ulimit -l`, or `km agent --no-lock`)");
+    }
+
+    END_TASK();
+}
+
+} // End of main namespace
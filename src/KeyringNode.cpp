@@ -9,6 +9,7 @@
  */
 
 #include <km/KeyringNode.hpp>
+#include <km/Encrypter.hpp>
 
 namespace km { // Begin main namespace
 
@@ -18,6 +19,12 @@ KeyringNode::ConfigFile = "keymaker.xml";
 const filesystem::path
 KeyringNode::EntryDir = "entries";
 
+const filesystem::path
+KeyringNode::AccessDir = "access";
+
+const filesystem::path
+KeyringNode::ManifestFile = "manifest";
+
 
 KeyringNode
 KeyringNode::create()
@@ -37,50 +44,37 @@ KeyringNode
 KeyringNode::fromPath(const filesystem::path &path)
 {
     auto filename = path.filename();
-    auto configPath = path / ConfigFile;
 
     KeyringNode keyring;
 
     keyring.mId   = Buffer::fromString(filename.string());
     keyring.mPath = path;
 
-    property_tree::ptree config;
+    keyring.reloadConfig();
 
-    property_tree::read_xml(configPath.string(), config);
+    // NOTE: keyrings without a tree get one from the entry files
+    auto treePath = path / MerkleTree::TreeFile;
 
-    PropertyContainer<KeyringNode>::fromConfig(
-        keyring,
-        config.get_child("keymaker")
-    );
+    bool hasTree = filesystem::exists(treePath);
 
-    for (auto &node : config.get_child("keymaker.accessKeys")) {
-
-        if (node.first == "<xmlattr>") {
-            continue;
-        }
-
-        auto accessKey = AccessKey::fromConfig(node.second);
-        keyring.mAccessKeys[accessKey.getRecipient()] = AccessKey::fromConfig(node.second);
+    if (hasTree) {
+        keyring.mMerkleTree = MerkleTree::fromFile(treePath);
     }
 
+    for (filesystem::directory_iterator it(path / EntryDir); it != filesystem::directory_iterator(); ++it) {
 
-    // FIXME: move this into a function
-    {
-        Buffer id;
-
-        for (filesystem::directory_iterator it(path / EntryDir); it != filesystem::directory_iterator(); ++it) {
-
-            filesystem::path path, filename;
-            path = it->path();
-            filename = path.filename();
+        filesystem::path entryPath, entryFilename;
+        entryPath = it->path();
+        entryFilename = entryPath.filename();
 
-            if (filename.string()[0] != '.' && filesystem::is_regular_file(path)) {
+        if (entryFilename.string()[0] != '.' && filesystem::is_regular_file(entryPath)) {
 
-                id = Buffer::fromString(filename.string());
+            auto id = Buffer::fromString(entryFilename.string());
 
-                EntryNode entry = EntryNode::fromFile(path);
+            keyring.mEntries.insert_or_assign(id, EntryNode::fromFile(entryPath));
 
-                keyring.mEntries.insert_or_assign(id, entry);
+            if (!hasTree) {
+                keyring.mMerkleTree.setLeaf(id, MerkleTree::hashFile(entryPath));
             }
         }
     }
@@ -99,8 +93,15 @@ KeyringNode::toPath(const filesystem::path &path, const KeyringNode &keyring)
 
     config.put_child("keymaker", PropertyContainer<KeyringNode>::toConfig(keyring));
 
-    for (auto &it : keyring.mAccessKeys) {
-        config.add_child("keymaker.accessKeys.entry", AccessKey::toConfig(it.second));
+    for (auto &key : keyring.mKeyHistory) {
+        config.add_child("keymaker.keyHistory.key", PropertyNode::toConfig(key));
+    }
+
+    if (keyring.mLegacy) {
+
+        for (auto &it : keyring.getAccessKeys()) {
+            config.add_child("keymaker.accessKeys.entry", AccessKey::toConfig(it.second));
+        }
     }
 
     property_tree::write_xml
@@ -111,7 +112,60 @@ KeyringNode::toPath(const filesystem::path &path, const KeyringNode &keyring)
         property_tree::xml_writer_make_settings<std::string>(' ', 4)
     );
 
-    keyring.eachEntry([&path](const Buffer &id, const EntryNode &entry) {
+    if (!keyring.mLegacy) {
+
+        // NOTE: the files not read yet are already in place, unless the keyring is moved
+        auto &accessKeys = (path == keyring.mPath) ? keyring.mAccessKeys : keyring.getAccessKeys();
+
+        filesystem::create_directories(path / AccessDir);
+
+        for (auto &it : accessKeys) {
+
+            property_tree::ptree accessKeyConfig;
+            accessKeyConfig.put_child("accessKey", AccessKey::toConfig(it.second));
+
+            property_tree::write_xml
+            (
+                (path / AccessDir / it.first.toHex<std::string>()).string(),
+                accessKeyConfig,
+                std::locale(),
+                property_tree::xml_writer_make_settings<std::string>(' ', 4)
+            );
+        }
+
+        filesystem::ofstream manifest(path / AccessDir / ManifestFile, std::ios::binary | std::ios::trunc);
+
+        for (auto &recipient : keyring.mRecipients) {
+            manifest << recipient.toHex<std::string>() << "\n";
+        }
+
+        if (!manifest) {
+            throw Exception("Failed writing the access keys of %1%", path);
+        }
+
+        // Drop the access keys of the removed recipients
+        for (filesystem::directory_iterator it(path / AccessDir); it != filesystem::directory_iterator(); ++it) {
+
+            auto filename = it->path().filename();
+
+            if (filename == ManifestFile || filename.string()[0] == '.') {
+                continue;
+            }
+
+            if (!keyring.mRecipients.count(Buffer::fromHex(filename.string()))) {
+                filesystem::remove(it->path());
+            }
+        }
+    }
+
+    // NOTE: in place, only the modified entries are written again
+    bool inPlace = (path == keyring.mPath);
+
+    keyring.eachEntry([&path, &keyring, inPlace](const Buffer &id, const EntryNode &entry) {
+
+        if (inPlace && !keyring.mModifiedEntries.count(id)) {
+            return;
+        }
 
         auto entryPath = path / EntryDir / id.toString();
         EntryNode::toFile(entryPath, entry);
@@ -119,6 +173,9 @@ KeyringNode::toPath(const filesystem::path &path, const KeyringNode &keyring)
 }
 
 KeyringNode::KeyringNode()
+:
+    mLegacy(false),
+    mMerkleTree(MerkleTree::create())
 {
 
 }
@@ -128,10 +185,102 @@ KeyringNode::~KeyringNode()
 
 }
 
+KeyringNode &
+KeyringNode::reloadConfig()
+{
+    auto configPath = mPath / ConfigFile;
+
+    property_tree::ptree config;
+
+    property_tree::read_xml(configPath.string(), config);
+
+    PropertyContainer<KeyringNode>::mProperties.clear();
+    mAccessKeys.clear();
+    mRecipients.clear();
+    mKeyHistory.clear();
+
+    PropertyContainer<KeyringNode>::fromConfig(
+        *this,
+        config.get_child("keymaker")
+    );
+
+    auto keyHistory = config.get_child_optional("keymaker.keyHistory");
+
+    if (keyHistory) {
+
+        for (auto &node : *keyHistory) {
+
+            if (node.first == "key") {
+                mKeyHistory.push_back(PropertyNode::fromConfig(node.second));
+            }
+        }
+    }
+
+    auto accessKeys = config.get_child_optional("keymaker.accessKeys");
+
+    mLegacy = (bool) accessKeys;
+
+    if (mLegacy) {
+
+        for (auto &node : *accessKeys) {
+
+            if (node.first == "<xmlattr>") {
+                continue;
+            }
+
+            auto accessKey = AccessKey::fromConfig(node.second);
+
+            mAccessKeys[accessKey.getRecipient()] = accessKey;
+            mRecipients.insert(accessKey.getRecipient());
+        }
+
+        return *this;
+    }
+
+    // NOTE: only the recipients are read, the access keys are parsed on request
+    filesystem::ifstream manifest(mPath / AccessDir / ManifestFile, std::ios::binary);
+
+    if (!manifest) {
+        throw Exception("Failed reading the access keys of %1%", mPath);
+    }
+
+    std::string line;
+
+    while (std::getline(manifest, line)) {
+
+        if (!line.empty()) {
+            mRecipients.insert(Buffer::fromHex(line));
+        }
+    }
+
+    return *this;
+}
+
+KeyringNode &
+KeyringNode::reloadEntry(const Buffer &id)
+{
+    auto entryPath = mPath / EntryDir / id.toString();
+
+    mEntries.insert_or_assign(id, EntryNode::fromFile(entryPath));
+    mMerkleTree.setLeaf(id, MerkleTree::hashFile(entryPath));
+
+    return *this;
+}
+
+KeyringNode &
+KeyringNode::removeEntry(const Buffer &id)
+{
+    mEntries.erase(id);
+    mMerkleTree.removeLeaf(id);
+
+    return *this;
+}
+
 KeyringNode &
 KeyringNode::addAccessKey(const AccessKey &accessKey)
 {
     mAccessKeys[accessKey.getRecipient()] = accessKey;
+    mRecipients.insert(accessKey.getRecipient());
 
     return *this;
 }
@@ -142,17 +291,67 @@ KeyringNode::getAccessKey(const Buffer &recipient) const
     auto it  = mAccessKeys.find(recipient),
          end = mAccessKeys.end();
 
-    if (it == end) {
+    if (it != end) {
+        return it->second;
+    }
+
+    if (!mRecipients.count(recipient)) {
         throw Exception("Failed getting AccessKey");
     }
 
-    return it->second;
+    return loadAccessKey(recipient);
+}
+
+KeyringNode &
+KeyringNode::setAccessKeys(const AccessKeyMap &accessKeys)
+{
+    mAccessKeys = accessKeys;
+    mRecipients.clear();
+
+    for (auto &it : accessKeys) {
+        mRecipients.insert(it.first);
+    }
+
+    return *this;
+}
+
+const AccessKeyMap &
+KeyringNode::getAccessKeys() const
+{
+    for (auto &recipient : mRecipients) {
+
+        if (!mAccessKeys.count(recipient)) {
+            loadAccessKey(recipient);
+        }
+    }
+
+    return mAccessKeys;
+}
+
+const AccessKey &
+KeyringNode::loadAccessKey(const Buffer &recipient) const
+{
+    auto accessKeyPath = mPath / AccessDir / recipient.toHex<std::string>();
+
+    property_tree::ptree config;
+
+    property_tree::read_xml(accessKeyPath.string(), config);
+
+    auto accessKey = AccessKey::fromConfig(config.get_child("accessKey"));
+
+    // NOTE: the file name is not trusted
+    if (accessKey.getRecipient() != recipient) {
+        throw Exception("Malformed access key %1%", accessKeyPath);
+    }
+
+    return mAccessKeys[recipient] = accessKey;
 }
 
 KeyringNode &
 KeyringNode::setEntry(const EntryNode &entry)
 {
     mEntries.insert_or_assign(entry.getId(), entry);
+    mModifiedEntries.insert(entry.getId());
 
     return *this;
 }
@@ -190,4 +389,41 @@ KeyringNode::eachEntry(std::function<void (const Buffer &id, const EntryNode &)>
     return *this;
 }
 
+KeyringNode &
+KeyringNode::save(const filesystem::path &path)
+{
+    KeyringNode::toPath(path, *this);
+
+    // NOTE: the tree keeps its seal only if no entry changed
+    updateMerkleTree(path);
+
+    MerkleTree::toFile(path / MerkleTree::TreeFile, mMerkleTree);
+
+    return *this;
+}
+
+KeyringNode &
+KeyringNode::save(const filesystem::path &path, const Encrypter &encrypter)
+{
+    KeyringNode::toPath(path, *this);
+
+    updateMerkleTree(path);
+    encrypter.seal(mMerkleTree);
+
+    MerkleTree::toFile(path / MerkleTree::TreeFile, mMerkleTree);
+
+    return *this;
+}
+
+void
+KeyringNode::updateMerkleTree(const filesystem::path &path)
+{
+    // Update the integrity tree only along the modified entries
+    for (auto &id : mModifiedEntries) {
+        mMerkleTree.setLeaf(id, MerkleTree::hashFile(path / EntryDir / id.toString()));
+    }
+
+    mModifiedEntries.clear();
+}
+
 } // End of main namespace
\ No newline at end of file
@@ -0,0 +1,411 @@
+/*!
+ * Title ---- km/MerkleTree.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/MerkleTree.hpp>
+#include <km/TaskPool.hpp>
+
+#include <sstream>
+
+namespace km { // Begin main namespace
+
+const filesystem::path
+MerkleTree::TreeFile = "merkle.tree";
+
+/*!
+ * The digits used by the bucket prefixes.
+ */
+static const char NodeDigits[MerkleTree::TREE_FANOUT + 1] = "0123456789ABCDEF";
+
+/*!
+ * The tag of the seal line (the entry IDs never start with '#').
+ */
+static const std::string SealTag = "#seal";
+
+
+MerkleTree
+MerkleTree::create()
+{
+    MerkleTree tree;
+
+    return tree;
+}
+
+MerkleTree
+MerkleTree::fromBuffer(const Buffer &data)
+{
+    MerkleTree tree;
+
+    std::istringstream input(data.toString());
+    std::string line;
+
+    Buffer seal;
+    unsigned int sealVersion = 0;
+
+    while (std::getline(input, line)) {
+
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.compare(0, SealTag.size() + 1, SealTag + " ") == 0) {
+
+            std::istringstream fields(line.substr(SealTag.size() + 1));
+            std::string hex;
+
+            if (!(fields >> sealVersion >> hex)) {
+                throw Exception("Malformed integrity tree");
+            }
+
+            seal = Buffer::fromHex(hex);
+            continue;
+        }
+
+        auto separator = line.find(' ');
+
+        if (separator == std::string::npos) {
+            throw Exception("Malformed integrity tree");
+        }
+
+        tree.setLeaf(
+            Buffer::fromString(line.substr(0, separator)),
+            Buffer::fromHex(line.substr(separator + 1))
+        );
+    }
+
+    // NOTE: the seal is set last, the leaves above reset it
+    tree.setSeal(seal, sealVersion);
+
+    return tree;
+}
+
+Buffer
+MerkleTree::toBuffer(const MerkleTree &tree)
+{
+    std::string output;
+
+    if (!tree.getSeal().empty()) {
+        output += SealTag + " " + std::to_string(tree.getSealVersion()) + " " + tree.getSeal().toHex<std::string>() + "\n";
+    }
+
+    tree.eachLeaf([&output](const Buffer &id, const Buffer &hash) {
+        output += id.toString() + " " + hash.toHex<std::string>() + "\n";
+    });
+
+    return Buffer::fromString(output);
+}
+
+MerkleTree
+MerkleTree::fromFile(const filesystem::path &path)
+{
+    filesystem::ifstream file(path, std::ios::binary);
+
+    if (!file) {
+        throw Exception("Failed reading integrity tree %1%", path);
+    }
+
+    std::string data(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>()
+    );
+
+    return MerkleTree::fromBuffer(Buffer::fromString(data));
+}
+
+void
+MerkleTree::toFile(const filesystem::path &path, const MerkleTree &tree)
+{
+    auto data = MerkleTree::toBuffer(tree);
+
+    filesystem::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char *) data.data(), data.size());
+}
+
+Buffer
+MerkleTree::hash(const Buffer &data)
+{
+    Buffer output(HASH_LENGTH);
+
+    if (!EVP_Digest(data.data(), data.size(), output.data(), NULL, EVP_sha256(), NULL)) {
+        throw Exception("Failed hashing data");
+    }
+
+    return output;
+}
+
+Buffer
+MerkleTree::hashFile(const filesystem::path &path)
+{
+    filesystem::ifstream file(path, std::ios::binary);
+
+    if (!file) {
+        throw Exception("Failed reading %1%", path);
+    }
+
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> context(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+
+    if (!context || !EVP_DigestInit_ex(context.get(), EVP_sha256(), NULL)) {
+        throw Exception("Failed hashing %1%", path);
+    }
+
+    char chunk[8192];
+
+    while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+
+        if (!EVP_DigestUpdate(context.get(), chunk, (std::size_t) file.gcount())) {
+            throw Exception("Failed hashing %1%", path);
+        }
+    }
+
+    Buffer output(HASH_LENGTH);
+
+    if (!EVP_DigestFinal_ex(context.get(), output.data(), NULL)) {
+        throw Exception("Failed hashing %1%", path);
+    }
+
+    return output;
+}
+
+MerkleTree::MerkleTree()
+:
+    mSealVersion(0)
+{
+
+}
+
+MerkleTree::~MerkleTree()
+{
+
+}
+
+MerkleTree &
+MerkleTree::setLeaf(const Buffer &id, const Buffer &hash)
+{
+    auto leaf = mLeaves.find(id);
+
+    // NOTE: an unchanged leaf keeps the seal
+    if (leaf != mLeaves.end() && leaf->second == hash) {
+        return *this;
+    }
+
+    auto bucket = MerkleTree::getBucket(id);
+
+    mLeaves.insert_or_assign(id, hash);
+    mBuckets[bucket].insert(id);
+
+    invalidate(bucket);
+
+    return *this;
+}
+
+MerkleTree &
+MerkleTree::removeLeaf(const Buffer &id)
+{
+    if (mLeaves.erase(id) == 0) {
+        return *this;
+    }
+
+    auto bucket = MerkleTree::getBucket(id);
+
+    auto it = mBuckets.find(bucket);
+    it->second.erase(id);
+
+    if (it->second.empty()) {
+        mBuckets.erase(it);
+    }
+
+    invalidate(bucket);
+
+    return *this;
+}
+
+const Buffer &
+MerkleTree::getLeaf(const Buffer &id) const
+{
+    auto it  = mLeaves.find(id),
+         end = mLeaves.end();
+
+    if (it == end) {
+        throw Exception("Failed getting integrity leaf");
+    }
+
+    return it->second;
+}
+
+const MerkleTree &
+MerkleTree::eachLeaf(std::function<void (const Buffer &id, const Buffer &hash)> callback) const
+{
+    for (auto &node : mLeaves) {
+        callback(node.first, node.second);
+    }
+
+    return *this;
+}
+
+std::vector<Buffer>
+MerkleTree::diff(const MerkleTree &other) const
+{
+    std::vector<Buffer> output;
+
+    diff(other, "", output);
+
+    return output;
+}
+
+std::vector<Buffer>
+MerkleTree::verify(const filesystem::path &path, unsigned int numOfThreads) const
+{
+    std::vector<Buffer> ids;
+
+    for (auto &node : mLeaves) {
+        ids.push_back(node.first);
+    }
+
+    // Check the entry files in parallel
+    std::vector<char> failures(ids.size(), 0);
+
+    TaskPool::run(ids.size(), [this, &path, &ids, &failures](std::size_t i) {
+
+        try {
+            failures[i] = (MerkleTree::hashFile(path / ids[i].toString()) != getLeaf(ids[i]));
+
+        } catch (std::exception &e) {
+            failures[i] = 1;
+        }
+    }, std::max(numOfThreads, 1U));
+
+    std::vector<Buffer> output;
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+
+        if (failures[i]) {
+            output.push_back(ids[i]);
+        }
+    }
+
+    // Look for the entries not covered by the tree
+    for (filesystem::directory_iterator it(path); it != filesystem::directory_iterator(); ++it) {
+
+        auto filename = it->path().filename().string();
+
+        if (filename[0] != '.' && filesystem::is_regular_file(it->path()) && !hasLeaf(Buffer::fromString(filename))) {
+            output.push_back(Buffer::fromString(filename));
+        }
+    }
+
+    return output;
+}
+
+std::string
+MerkleTree::getBucket(const Buffer &id)
+{
+    return MerkleTree::hash(id).toHex<std::string>().substr(0, TREE_DEPTH);
+}
+
+const Buffer &
+MerkleTree::getNode(const std::string &prefix) const
+{
+    auto it = mNodes.find(prefix);
+
+    if (it != mNodes.end()) {
+        return it->second;
+    }
+
+    Buffer data;
+
+    if (prefix.size() == TREE_DEPTH) {
+
+        auto bucket = mBuckets.find(prefix);
+
+        if (bucket != mBuckets.end()) {
+
+            for (auto &id : bucket->second) {
+
+                auto &leaf = getLeaf(id);
+
+                data.insert(data.end(), id.begin(), id.end());
+                data.push_back('\0');
+                data.insert(data.end(), leaf.begin(), leaf.end());
+            }
+        }
+
+    } else {
+
+        // NOTE: empty subtrees are skipped without visiting them
+        auto first = mBuckets.lower_bound(prefix);
+
+        if (first != mBuckets.end() && first->first.compare(0, prefix.size(), prefix) == 0) {
+
+            for (int i = 0; i < TREE_FANOUT; ++i) {
+
+                auto &child = getNode(prefix + NodeDigits[i]);
+
+                if (!child.empty()) {
+                    data.push_back(NodeDigits[i]);
+                    data.insert(data.end(), child.begin(), child.end());
+                }
+            }
+        }
+    }
+
+    return mNodes.emplace(
+        prefix,
+        data.empty() ? Buffer() : MerkleTree::hash(data)
+    ).first->second;
+}
+
+void
+MerkleTree::invalidate(const std::string &bucket)
+{
+    mSeal.clear();
+
+    for (std::size_t i = 0; i <= bucket.size(); ++i) {
+        mNodes.erase(bucket.substr(0, i));
+    }
+}
+
+void
+MerkleTree::diff(const MerkleTree &other, const std::string &prefix, std::vector<Buffer> &output) const
+{
+    if (getNode(prefix) == other.getNode(prefix)) {
+        return;
+    }
+
+    if (prefix.size() < TREE_DEPTH) {
+
+        for (int i = 0; i < TREE_FANOUT; ++i) {
+            diff(other, prefix + NodeDigits[i], output);
+        }
+
+        return;
+    }
+
+    std::set<Buffer> ids;
+
+    auto bucket = mBuckets.find(prefix);
+
+    if (bucket != mBuckets.end()) {
+        ids.insert(bucket->second.begin(), bucket->second.end());
+    }
+
+    bucket = other.mBuckets.find(prefix);
+
+    if (bucket != other.mBuckets.end()) {
+        ids.insert(bucket->second.begin(), bucket->second.end());
+    }
+
+    for (auto &id : ids) {
+
+        if (!hasLeaf(id) || !other.hasLeaf(id) || getLeaf(id) != other.getLeaf(id)) {
+            output.push_back(id);
+        }
+    }
+}
+
+} // End of main namespace
@@ -9,6 +9,7 @@
  */
 
 #include <km/PrivateKey.hpp>
+#include <km/Encrypter.hpp>
 
 namespace km { // Begin main namespace
 
@@ -56,18 +57,40 @@ PrivateKey::PrivateKey(const PrivateKey &other) : RsaKey(other)
 
 PrivateKey::PrivateKey(BIO *bio, const Buffer &passphrase)
 {
-    RSA *rsa = NULL;
-
     Buffer password = passphrase;
     password.push_back('\0');
 
-    if (!PEM_read_bio_RSAPrivateKey(bio, &rsa, NULL, (void *) password.data())) {
-        throw Exception("Failed getting RSA");
+    EVP_PKEY *pkey = PEM_read_bio_PrivateKey(bio, NULL, NULL, (void *) password.data());
+
+    if (!pkey) {
+        throw Exception("Failed getting the private key");
+    }
+
+    auto type = EVP_PKEY_base_id(pkey);
+
+    if (type == EVP_PKEY_X25519 || type == EVP_PKEY_ED25519 || type == EVP_PKEY_EC) {
+
+        mPkey = std::shared_ptr<EVP_PKEY>(pkey, [](EVP_PKEY *data) {
+            EVP_PKEY_free(data);
+        });
+
+    } else {
+
+        RSA *rsa = EVP_PKEY_get1_RSA(pkey);
+
+        EVP_PKEY_free(pkey);
+
+        if (!rsa) {
+            throw Exception("Unsupported private key type");
+        }
+
+        mRsa = std::shared_ptr<RSA>(rsa, [](RSA *data) {
+            RSA_free(data);
+        });
     }
 
-    mRsa = std::shared_ptr<RSA>(rsa, [](RSA *data) {
-        RSA_free(data);
-    });
+    // NOTE: the fingerprint is looked up for every keyring
+    mFingerprint = Encrypter::getFingerprint(*this);
 }
 
 PrivateKey::~PrivateKey()
@@ -82,7 +105,11 @@ PrivateKey::getPkcsKey() const
 
     BIO *bio = BIO_new(BIO_s_mem());
 
-    PEM_write_bio_RSAPrivateKey(bio, mRsa.get(), NULL, NULL, 0, NULL, 0);
+    if (mPkey) {
+        PEM_write_bio_PKCS8PrivateKey(bio, mPkey.get(), NULL, NULL, 0, NULL, NULL);
+    } else {
+        PEM_write_bio_RSAPrivateKey(bio, mRsa.get(), NULL, NULL, 0, NULL, 0);
+    }
 
     size_t length = (size_t) BIO_read(
         bio,
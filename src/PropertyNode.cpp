@@ -52,6 +52,25 @@ PropertyNode::fromConfig(property_tree::ptree &config)
     node.mName    = Buffer::fromBase64(name);
     node.mContent = Buffer::fromBase64(content);
 
+    // NOTE: the nodes without a key version predate the key rotation
+    node.mKeyVersion = config.get<unsigned int>("keyVersion", 0);
+
+    auto compression = config.get<std::string>("compression", "");
+
+    if (compression == "zlib") {
+        node.mCompressed = true;
+    } else if (!compression.empty()) {
+        throw Exception("Unsupported property compression '%1%'", compression);
+    }
+
+    auto type = config.get<std::string>("type", "");
+
+    if (type == "attachment") {
+        node.mAttachment = true;
+    } else if (!type.empty()) {
+        throw Exception("Unsupported property type '%1%'", type);
+    }
+
     return node;
 }
 
@@ -69,10 +88,22 @@ PropertyNode::toConfig(const PropertyNode &node)
     config.put<std::string>("content", node.mContent.toBase64<std::string>());
     config.put<std::string>("content.<xmlattr>.encoding", "base64");
 
+    if (node.mKeyVersion) {
+        config.put<unsigned int>("keyVersion", node.mKeyVersion);
+    }
+
+    if (node.mCompressed) {
+        config.put<std::string>("compression", "zlib");
+    }
+
+    if (node.mAttachment) {
+        config.put<std::string>("type", "attachment");
+    }
+
     return config;
 }
 
-PropertyNode::PropertyNode()
+PropertyNode::PropertyNode() : mKeyVersion(0), mCompressed(false), mAttachment(false)
 {
 
 }
@@ -9,6 +9,7 @@
  */
 
 #include <km/PublicKey.hpp>
+#include <km/Encrypter.hpp>
 
 namespace km { // Begin main namespace
 
@@ -51,7 +52,11 @@ PublicKey::fromPrivateKey(const PrivateKey &privateKey)
 
     BIO *bio = BIO_new(BIO_s_mem());
 
-    PEM_write_bio_RSAPublicKey(bio, privateKey.mRsa.get());
+    if (privateKey.mPkey) {
+        PEM_write_bio_PUBKEY(bio, privateKey.mPkey.get());
+    } else {
+        PEM_write_bio_RSAPublicKey(bio, privateKey.mRsa.get());
+    }
 
     size_t length = (size_t) BIO_read(
         bio,
@@ -81,12 +86,45 @@ PublicKey::PublicKey(BIO *bio)
     RSA *rsa = NULL;
 
     if (!PEM_read_bio_RSAPublicKey(bio, &rsa, NULL, NULL)) {
-        throw Exception("Failed getting RSA");
+
+        // Not a PKCS#1 key, try a SubjectPublicKeyInfo one
+        ERR_clear_error();
+        BIO_reset(bio);
+
+        EVP_PKEY *pkey = PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL);
+
+        if (!pkey) {
+            throw Exception("Failed getting the public key");
+        }
+
+        auto type = EVP_PKEY_base_id(pkey);
+
+        if (type == EVP_PKEY_X25519 || type == EVP_PKEY_ED25519 || type == EVP_PKEY_EC) {
+
+            mPkey = std::shared_ptr<EVP_PKEY>(pkey, [](EVP_PKEY *data) {
+                EVP_PKEY_free(data);
+            });
+
+        } else {
+
+            rsa = EVP_PKEY_get1_RSA(pkey);
+
+            EVP_PKEY_free(pkey);
+
+            if (!rsa) {
+                throw Exception("Unsupported public key type");
+            }
+        }
     }
 
-    mRsa = std::shared_ptr<RSA>(rsa, [](RSA *data) {
-        RSA_free(data);
-    });
+    if (rsa) {
+        mRsa = std::shared_ptr<RSA>(rsa, [](RSA *data) {
+            RSA_free(data);
+        });
+    }
+
+    // NOTE: the fingerprint is looked up for every keyring
+    mFingerprint = Encrypter::getFingerprint(*this);
 }
 
 PublicKey::~PublicKey()
@@ -101,7 +139,11 @@ PublicKey::getPkcsKey() const
 
     BIO *bio = BIO_new(BIO_s_mem());
 
-    PEM_write_bio_RSAPublicKey(bio, mRsa.get());
+    if (mPkey) {
+        PEM_write_bio_PUBKEY(bio, mPkey.get());
+    } else {
+        PEM_write_bio_RSAPublicKey(bio, mRsa.get());
+    }
 
     size_t length = (size_t) BIO_read(
         bio,
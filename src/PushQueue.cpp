@@ -0,0 +1,418 @@
+/*!
+ * Title ---- km/PushQueue.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/PushQueue.hpp>
+
+namespace km { // Begin main namespace
+
+PushQueue::PushQueue(const filesystem::path &statePath, const std::vector<filesystem::path> &repositoryPaths)
+:
+    mStatePath(statePath),
+    mRepositoryPaths(repositoryPaths),
+    mActiveChanged(false),
+    mFlushing(false),
+    mRunning(false)
+{
+    load();
+}
+
+PushQueue::~PushQueue()
+{
+    stop();
+}
+
+PushQueue &
+PushQueue::start(const PrivateKey &privateKey)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mPrivateKey = privateKey;
+
+    if (!mRunning) {
+        mRunning = true;
+        mWorker  = std::thread(&PushQueue::run, this);
+    }
+
+    return *this;
+}
+
+PushQueue &
+PushQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning = false;
+    }
+
+    mCondition.notify_all();
+
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+
+    return *this;
+}
+
+PushQueue &
+PushQueue::enqueue(const Buffer &repositoryId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // NOTE: the running push may have missed the latest commits
+        if (repositoryId == mActive) {
+            mActiveChanged = true;
+        }
+
+        mFlushIds.insert(repositoryId);
+        mErrors.erase(repositoryId);
+
+        // NOTE: a rejected push is tried again once the repository is scheduled again
+        bool failed = mFailures.erase(repositoryId) > 0;
+
+        if (mPending.insert(repositoryId).second) {
+            mRetries[repositoryId].next = Clock::now();
+            store();
+
+        } else if (failed) {
+            store();
+        }
+    }
+
+    mCondition.notify_all();
+
+    return *this;
+}
+
+PushQueue &
+PushQueue::dequeue(const Buffer &repositoryId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // NOTE: the outcome of a running push is discarded
+        mPending.erase(repositoryId);
+        mRetries.erase(repositoryId);
+        mFailures.erase(repositoryId);
+        mFlushIds.erase(repositoryId);
+        mErrors.erase(repositoryId);
+
+        store();
+    }
+
+    mCondition.notify_all();
+
+    return *this;
+}
+
+PushQueue &
+PushQueue::flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // NOTE: the failures that will be retried get one more (immediate) attempt
+    for (auto &id : mPending) {
+        mErrors.erase(id);
+    }
+
+    // Waits only for the repositories of this run, which haven't failed yet
+    auto waiting = [this]() {
+
+        return std::any_of(mFlushIds.begin(), mFlushIds.end(), [this](const Buffer &id) {
+            return mPending.count(id) && !mErrors.count(id);
+        });
+    };
+
+    if (waiting()) {
+
+        if (!mRunning) {
+            throw Exception("The push queue is not running");
+        }
+
+        mFlushing = true;
+        mCondition.notify_all();
+
+        mCondition.wait(lock, [this, &waiting]() {
+            return !waiting() || !mRunning;
+        });
+
+        mFlushing = false;
+    }
+
+    std::size_t failures = 0;
+    std::string lastError;
+
+    for (auto &id : mFlushIds) {
+
+        if (mErrors.count(id)) {
+            failures++;
+            lastError = mErrors[id];
+
+        } else if (mPending.count(id)) {
+            failures++;
+        }
+    }
+
+    mFlushIds.clear();
+    mErrors.clear();
+
+    if (failures) {
+        throw Exception("Failed pushing %1% repositories: %2%", failures, lastError);
+    }
+
+    return *this;
+}
+
+bool
+PushQueue::isPermanentFailure(int error)
+{
+    return error == GIT_ENONFASTFORWARD || error == GIT_ENOTFOUND;
+}
+
+filesystem::path
+PushQueue::getRepositoryPath(const Buffer &repositoryId) const
+{
+    for (auto &path : mRepositoryPaths) {
+
+        auto repositoryPath = path / repositoryId.toString();
+
+        if (Repository::isValid(repositoryPath)) {
+            return repositoryPath;
+        }
+    }
+
+    return filesystem::path();
+}
+
+void
+PushQueue::run()
+{
+    Console::setQuiet(true);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (mRunning) {
+
+        // Look for the next due push
+        auto now = Clock::now();
+
+        auto next = Clock::time_point::max();
+
+        Buffer repositoryId;
+
+        for (auto &id : mPending) {
+
+            auto &retry = mRetries[id];
+
+            // NOTE: a flush skips the backoff only of the repositories it waits for
+            if ((mFlushing && mFlushIds.count(id) && !mErrors.count(id)) || retry.next <= now) {
+                repositoryId = id;
+                break;
+            }
+
+            next = std::min(next, retry.next);
+        }
+
+        if (repositoryId.empty()) {
+
+            if (next == Clock::time_point::max()) {
+                mCondition.wait(lock);
+            } else {
+                mCondition.wait_until(lock, next);
+            }
+
+            continue;
+        }
+
+        mActive        = repositoryId;
+        mActiveChanged = false;
+
+        lock.unlock();
+
+        std::string error;
+
+        bool dropped  = false;
+        bool rejected = false;
+
+        // NOTE: a repository removed from the disk has nothing left to push
+        if (getRepositoryPath(repositoryId).empty()) {
+            error   = "the local repository no longer exists";
+            dropped = true;
+
+        } else {
+
+            try {
+                push(repositoryId);
+
+            } catch (GitException &e) {
+                error    = e.what();
+                rejected = isPermanentFailure(e.getCode());
+
+                // Reconnect on the next attempt
+                mShell.reset();
+
+            } catch (std::exception &e) {
+                error = e.what();
+
+                mShell.reset();
+            }
+        }
+
+        lock.lock();
+
+        mActive.clear();
+
+        // Dequeued during the push
+        if (!mPending.count(repositoryId)) {
+            mCondition.notify_all();
+            continue;
+        }
+
+        auto &retry = mRetries[repositoryId];
+
+        if (error.empty()) {
+
+            if (mActiveChanged) {
+                retry = Retry();
+                retry.next = Clock::now();
+
+            } else {
+                mPending.erase(repositoryId);
+                mRetries.erase(repositoryId);
+            }
+
+        } else if (dropped || rejected) {
+
+            mPending.erase(repositoryId);
+            mRetries.erase(repositoryId);
+
+            // NOTE: the local commits are kept, the user has to fetch and push again
+            if (rejected) {
+                mFailures[repositoryId] = error;
+            }
+
+            if (mFlushIds.count(repositoryId)) {
+                mErrors[repositoryId] = error;
+            }
+
+            spdlog::get("km")->warn("Dropped the push of {}: {}", repositoryId.toString(), error);
+
+        } else {
+
+            // Exponential backoff
+            auto delay = std::min<unsigned int>(
+                RETRY_MAX_DELAY,
+                RETRY_MIN_DELAY << std::min<unsigned int>(retry.attempts, 16)
+            );
+
+            retry.attempts++;
+            retry.next = Clock::now() + std::chrono::seconds(delay);
+
+            if (mFlushIds.count(repositoryId)) {
+                mErrors[repositoryId] = error;
+            }
+
+            spdlog::get("km")->warn("Failed pushing {}: {}", repositoryId.toString(), error);
+        }
+
+        store();
+
+        mCondition.notify_all();
+    }
+
+    lock.unlock();
+
+    mShell.reset();
+}
+
+void
+PushQueue::push(const Buffer &repositoryId)
+{
+    auto repositoryPath = getRepositoryPath(repositoryId);
+
+    if (!mShell) {
+        mShell = std::make_unique<SshClient>(GIT_ADDRESS, GIT_PORT);
+        mShell->setDnsCache(mStatePath.parent_path() / SshClient::DnsCacheFile);
+        mShell->connect(GIT_USERNAME, mPrivateKey);
+    }
+
+    // NOTE: the worker uses its own repository handle and session
+    auto repository = Repository::fromPath(repositoryId, repositoryPath, mPrivateKey);
+
+    repository
+        .attach(mShell.get())
+        .push()
+    ;
+}
+
+void
+PushQueue::load()
+{
+    if (!filesystem::exists(mStatePath)) {
+        return;
+    }
+
+    filesystem::ifstream file(mStatePath);
+
+    std::string line;
+
+    while (std::getline(file, line)) {
+
+        if (line.empty()) {
+            continue;
+        }
+
+        // NOTE: the rejected pushes are stored as `<ID> failed <error>`
+        auto separator = line.find(' ');
+
+        auto repositoryId = Buffer::fromString(line.substr(0, separator));
+
+        if (separator != std::string::npos) {
+
+            auto status = line.substr(separator + 1);
+
+            if (status.compare(0, 7, "failed ") == 0) {
+                mFailures[repositoryId] = status.substr(7);
+            }
+
+            continue;
+        }
+
+        mPending.insert(repositoryId);
+        mRetries[repositoryId].next = Clock::now();
+    }
+}
+
+void
+PushQueue::store() const
+{
+    auto tempPath = mStatePath;
+    tempPath += ".tmp";
+
+    {
+        filesystem::ofstream file(tempPath, std::ios::trunc);
+
+        for (auto &id : mPending) {
+            file << id << "\n";
+        }
+
+        for (auto &failure : mFailures) {
+
+            auto error = failure.second;
+            std::replace(error.begin(), error.end(), '\n', ' ');
+
+            file << failure.first << " failed " << error << "\n";
+        }
+    }
+
+    filesystem::rename(tempPath, mStatePath);
+}
+
+} // End of main namespace
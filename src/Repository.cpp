@@ -9,14 +9,21 @@
  */
 
 #include <km/Repository.hpp>
+#include <km/SshTransport.hpp>
 
 namespace km { // Begin main namespace
 
+const std::string
+Repository::TrackingRef = "refs/remotes/origin/master";
+
 int
 Repository::acquireCredentials(git_cred **out, const char *, const char *, unsigned int, void *privateKey)
 {
     auto pkcsKey = static_cast<PrivateKey *>(privateKey)->getPkcsKey();
 
+    // NOTE: libgit2 reads the key as a C string
+    pkcsKey.push_back('\0');
+
     int error = git_cred_ssh_key_memory_new
     (
         out,
@@ -27,16 +34,32 @@ Repository::acquireCredentials(git_cred **out, const char *, const char *, unsig
     );
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     return error;
 }
 
 void
-Repository::throwGitException()
+Repository::setCallbacks(git_remote_callbacks &callbacks)
 {
-    throw Exception("Repository error: %1%, %2%", giterr_last()->klass, giterr_last()->message);
+    if (mShell && mShell->hasSession()) {
+
+        // The Git services run over the channels of the attached session
+        callbacks.transport = (git_transport_cb) &SshTransport::create;
+        callbacks.payload = (void *) mShell;
+
+    } else {
+
+        callbacks.credentials = (git_cred_acquire_cb) &Repository::acquireCredentials;
+        callbacks.payload = (void *) &mPrivateKey;
+    }
+}
+
+void
+Repository::throwGitException(int error)
+{
+    throw GitException(error, giterr_last()->klass, giterr_last()->message);
 }
 
 Repository
@@ -71,7 +94,7 @@ Repository::fromPath(const Buffer &id, const filesystem::path &path, const Priva
 }
 
 Repository
-Repository::fromRemote(const Buffer &id, const filesystem::path &path, const PrivateKey &privateKey)
+Repository::fromRemote(const Buffer &id, const filesystem::path &path, const PrivateKey &privateKey, SshClient *shell)
 {
     Repository repository(id, path);
 
@@ -79,6 +102,7 @@ Repository::fromRemote(const Buffer &id, const filesystem::path &path, const Pri
 
     repository
         .access(privateKey)
+        .attach(shell)
         .clone()
         .open()
     ;
@@ -98,7 +122,7 @@ Repository::isValid(const filesystem::path &path)
     return false;
 }
 
-Repository::Repository(const Buffer &id, const filesystem::path &path) : mId(id), mPath(path)
+Repository::Repository(const Buffer &id, const filesystem::path &path) : mId(id), mPath(path), mShell(nullptr)
 {
 
 }
@@ -108,6 +132,14 @@ Repository::~Repository()
 
 }
 
+Repository &
+Repository::attach(SshClient *shell)
+{
+    mShell = shell;
+
+    return *this;
+}
+
 Repository &
 Repository::add(const filesystem::path &path)
 {
@@ -118,13 +150,13 @@ Repository::add(const filesystem::path &path)
     error = git_repository_index(&idx, mGitRepository.get());
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     error = git_index_read(idx, 1);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     const char *paths[] = {
@@ -136,7 +168,7 @@ Repository::add(const filesystem::path &path)
     error = git_index_add_all(idx, &pathspec, GIT_INDEX_ADD_DEFAULT, NULL, NULL);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     git_index_write(idx);
@@ -155,13 +187,13 @@ Repository::update(const filesystem::path &path)
     error = git_repository_index(&idx, mGitRepository.get());
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     error = git_index_read(idx, 1);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     const char *paths[] = {
@@ -173,7 +205,7 @@ Repository::update(const filesystem::path &path)
     error = git_index_update_all(idx, &pathspec, NULL, NULL);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     git_index_write(idx);
@@ -192,13 +224,13 @@ Repository::remove(const filesystem::path &path)
     error = git_repository_index(&idx, mGitRepository.get());
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     error = git_index_read(idx, 1);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     const char *paths[] = {
@@ -210,7 +242,7 @@ Repository::remove(const filesystem::path &path)
     error = git_index_remove_all(idx, &pathspec, NULL, NULL);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     git_index_write(idx);
@@ -237,19 +269,19 @@ Repository::commit(const Buffer &message)
     error = git_repository_index(&idx, mGitRepository.get());
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     error = git_index_read(idx, 1);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     error = git_index_write_tree(&new_tree_id, idx);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     git_index_free(idx);
@@ -257,14 +289,14 @@ Repository::commit(const Buffer &message)
     error = git_tree_lookup(&tree, mGitRepository.get(), &new_tree_id);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     // FIXME: change this
     error = git_signature_now(&me, "Wicker25", "wicker25@gmail.com");
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
 
@@ -279,7 +311,7 @@ Repository::commit(const Buffer &message)
         error = git_commit_lookup(&parent_commit, mGitRepository.get(), &oid_parent_commit);
 
         if (error < 0) {
-            throwGitException();
+            throwGitException(error);
         }
 
         numOfParents = 1;
@@ -289,7 +321,7 @@ Repository::commit(const Buffer &message)
     } else if (error == GIT_ENOTFOUND) {
 
     } else {
-        throwGitException();
+        throwGitException(error);
     }
 
     git_oid new_commit_id;
@@ -309,7 +341,7 @@ Repository::commit(const Buffer &message)
     );
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     END_TASK();
@@ -317,27 +349,55 @@ Repository::commit(const Buffer &message)
     return *this;
 }
 
+Repository &
+Repository::setRemoteUrl(const std::string &url)
+{
+    git_remote *remote;
+
+    int error = git_remote_set_url(mGitRepository.get(), "origin", url.c_str());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    error = git_remote_lookup(&remote, mGitRepository.get(), "origin");
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    mGitRemote = std::shared_ptr<git_remote>(remote, [](git_remote *data) {
+        git_remote_free(data);
+    });
+
+    return *this;
+}
+
 Repository &
 Repository::fetch()
 {
     BEGIN_TASK("git", "Fetch changes");
 
-    git_reference *ref;
+    git_oid headId, trackedId, remoteId;
 
     int error;
 
-    error = git_reference_lookup(&ref, mGitRepository.get(), "refs/heads/master");
+    auto head = getHead();
 
-    if (error < 0) {
+    if (!lookupReference("HEAD", headId)) {
         throwGitException();
     }
 
+    // NOTE: the remote head of the last fetch (or push), missing in the older clones
+    bool tracked = lookupReference(TrackingRef, trackedId);
+
     git_fetch_options options = GIT_FETCH_OPTIONS_INIT;
 
-    options.callbacks.credentials = (git_cred_acquire_cb) &Repository::acquireCredentials;
-    options.callbacks.payload = (void *) &mPrivateKey;
+    setCallbacks(options.callbacks);
 
-    char *refspec = (char *) "refs/heads/master:refs/heads/master";
+    // NOTE: forced, a compaction rewrites the remote history
+    auto refspecName = "+refs/heads/master:" + TrackingRef;
+    char *refspec = (char *) refspecName.c_str();
 
     const git_strarray refspecs = {
         &refspec,
@@ -347,10 +407,34 @@ Repository::fetch()
     error = git_remote_fetch(mGitRemote.get(), &refspecs, &options, NULL);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
-    git_reference_free(ref);
+    // NOTE: nothing to do on an empty remote, when up to date or with only local commits
+    bool behind = lookupReference(TrackingRef, remoteId)
+               && !git_oid_equal(&headId, &remoteId)
+               && git_graph_descendant_of(mGitRepository.get(), &headId, &remoteId) != 1;
+
+    if (behind) {
+
+        bool fastForward = git_graph_descendant_of(mGitRepository.get(), &remoteId, &headId) == 1;
+
+        // A rewritten remote history replaces the local one only if no local commit would be lost
+        bool pushed = (tracked && (git_oid_equal(&headId, &trackedId) || git_graph_descendant_of(mGitRepository.get(), &trackedId, &headId) == 1))
+                   || hasSnapshot(remoteId, headId);
+
+        if (!fastForward && !pushed) {
+            throw Exception("The history of '%1%' has diverged from the remote one and has commits not pushed yet", mId);
+        }
+
+        char remoteHash[GIT_OID_HEXSZ + 1];
+        git_oid_tostr(remoteHash, sizeof(remoteHash), &remoteId);
+
+        setHead(Buffer::fromString(remoteHash));
+
+        // Bring the working directory up to date
+        checkout(head);
+    }
 
     END_TASK();
 
@@ -369,13 +453,12 @@ Repository::push()
     error = git_reference_lookup(&ref, mGitRepository.get(), "refs/heads/master");
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     git_push_options options = GIT_PUSH_OPTIONS_INIT;
 
-    options.callbacks.credentials = (git_cred_acquire_cb) &Repository::acquireCredentials;
-    options.callbacks.payload = (void *) &mPrivateKey;
+    setCallbacks(options.callbacks);
 
     char *refspec = (char *) "refs/heads/master:refs/heads/master";
 
@@ -387,13 +470,419 @@ Repository::push()
     error = git_remote_push(mGitRemote.get(), &refspecs, &options);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
+    }
+
+    git_reference_free(ref);
+
+    updateTrackingRef();
+
+    END_TASK();
+
+    return *this;
+}
+
+Repository &
+Repository::forcePush(const Buffer &lease)
+{
+    BEGIN_TASK("git", "Push rewritten history");
+
+    git_oid leaseId;
+
+    int error;
+
+    Buffer hash = lease;
+    hash.push_back('\0');
+
+    error = git_oid_fromstr(&leaseId, (const char *) hash.data());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    git_remote_callbacks callbacks = GIT_REMOTE_CALLBACKS_INIT;
+
+    setCallbacks(callbacks);
+
+    error = git_remote_connect(mGitRemote.get(), GIT_DIRECTION_PUSH, &callbacks, NULL, NULL);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    const git_remote_head **heads;
+    size_t numOfHeads;
+
+    error = git_remote_ls(&heads, &numOfHeads, mGitRemote.get());
+
+    if (error < 0) {
+        git_remote_disconnect(mGitRemote.get());
+        throwGitException(error);
+    }
+
+    // NOTE: the push reuses the advertisement of this connection, so the
+    //       remote rejects the update if the head moves in the meantime
+    bool leaseHeld = false;
+
+    for (size_t i = 0; i < numOfHeads; ++i) {
+
+        if (std::strcmp(heads[i]->name, "refs/heads/master") == 0) {
+            leaseHeld = git_oid_equal(&heads[i]->oid, &leaseId);
+            break;
+        }
+    }
+
+    if (!leaseHeld) {
+        git_remote_disconnect(mGitRemote.get());
+        throw Exception("Remote history has changed, fetch the repository before rewriting it");
+    }
+
+    git_push_options options = GIT_PUSH_OPTIONS_INIT;
+
+    options.callbacks = callbacks;
+
+    char *refspec = (char *) "+refs/heads/master:refs/heads/master";
+
+    const git_strarray refspecs = {
+        &refspec,
+        1
+    };
+
+    error = git_remote_push(mGitRemote.get(), &refspecs, &options);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    updateTrackingRef();
+
+    END_TASK();
+
+    return *this;
+}
+
+bool
+Repository::compact(std::time_t time, const Buffer &message)
+{
+    BEGIN_TASK("git", "Compact history");
+
+    git_oid headId, oid;
+    git_revwalk *walker;
+    git_commit *commit;
+
+    int error;
+
+    error = git_reference_name_to_id(&headId, mGitRepository.get(), "HEAD");
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    error = git_revwalk_new(&walker, mGitRepository.get());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    git_revwalk_sorting(walker, GIT_SORT_TOPOLOGICAL);
+    git_revwalk_simplify_first_parent(walker);
+
+    error = git_revwalk_push(walker, &headId);
+
+    if (error < 0) {
+        git_revwalk_free(walker);
+        throwGitException(error);
+    }
+
+    // Collect the commits inside the retention window (newest first)
+    std::vector<git_oid> recentIds;
+
+    git_oid baseId;
+    unsigned int numOfBaseParents = 0;
+
+    bool found = false;
+
+    while (!git_revwalk_next(&oid, walker)) {
+
+        error = git_commit_lookup(&commit, mGitRepository.get(), &oid);
+
+        if (error < 0) {
+            git_revwalk_free(walker);
+            throwGitException(error);
+        }
+
+        if ((std::time_t) git_commit_time(commit) < time) {
+
+            baseId           = oid;
+            numOfBaseParents = git_commit_parentcount(commit);
+
+            found = true;
+        }
+
+        git_commit_free(commit);
+
+        if (found) {
+            break;
+        }
+
+        recentIds.push_back(oid);
+    }
+
+    git_revwalk_free(walker);
+
+    // Nothing to squash
+    if (!found || numOfBaseParents == 0) {
+        return false;
+    }
+
+    // Build the snapshot commit from the tree of the newest expired commit
+    git_commit *baseCommit;
+    git_tree *tree;
+    git_oid newHeadId;
+
+    error = git_commit_lookup(&baseCommit, mGitRepository.get(), &baseId);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    error = git_commit_tree(&tree, baseCommit);
+
+    if (error < 0) {
+        git_commit_free(baseCommit);
+        throwGitException(error);
+    }
+
+    error = git_commit_create
+    (
+        &newHeadId,
+        mGitRepository.get(),
+        NULL,
+        git_commit_author(baseCommit),
+        git_commit_committer(baseCommit),
+        "UTF-8",
+        (const char *) message.toString().c_str(),
+        tree,
+        0,
+        NULL
+    );
+
+    git_tree_free(tree);
+    git_commit_free(baseCommit);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    // Replay the recent commits on top of the snapshot
+    for (auto it = recentIds.rbegin(); it != recentIds.rend(); ++it) {
+
+        git_commit *parent;
+
+        error = git_commit_lookup(&commit, mGitRepository.get(), &(*it));
+
+        if (error < 0) {
+            throwGitException(error);
+        }
+
+        error = git_commit_lookup(&parent, mGitRepository.get(), &newHeadId);
+
+        if (error < 0) {
+            git_commit_free(commit);
+            throwGitException(error);
+        }
+
+        error = git_commit_tree(&tree, commit);
+
+        if (error < 0) {
+            git_commit_free(parent);
+            git_commit_free(commit);
+            throwGitException(error);
+        }
+
+        const git_commit *parents[] = { parent };
+
+        error = git_commit_create
+        (
+            &newHeadId,
+            mGitRepository.get(),
+            NULL,
+            git_commit_author(commit),
+            git_commit_committer(commit),
+            git_commit_message_encoding(commit),
+            git_commit_message(commit),
+            tree,
+            1,
+            parents
+        );
+
+        git_tree_free(tree);
+        git_commit_free(parent);
+        git_commit_free(commit);
+
+        if (error < 0) {
+            throwGitException(error);
+        }
+    }
+
+    // Move the branch only if nobody else has moved it
+    git_reference *ref;
+
+    error = git_reference_create_matching
+    (
+        &ref,
+        mGitRepository.get(),
+        "refs/heads/master",
+        &newHeadId,
+        1,
+        &headId,
+        "km: compact history"
+    );
+
+    if (error < 0) {
+        throwGitException(error);
     }
 
     git_reference_free(ref);
 
     END_TASK();
 
+    return true;
+}
+
+git_tree *
+Repository::lookupTree(const Buffer &hash) const
+{
+    git_oid oid;
+    git_commit *commit;
+    git_tree *tree;
+
+    int error;
+
+    Buffer input = hash;
+    input.push_back('\0');
+
+    error = git_oid_fromstr(&oid, (const char *) input.data());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    error = git_commit_lookup(&commit, mGitRepository.get(), &oid);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    error = git_commit_tree(&tree, commit);
+
+    git_commit_free(commit);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    return tree;
+}
+
+bool
+Repository::lookupReference(const std::string &name, git_oid &oid) const
+{
+    return git_reference_name_to_id(&oid, mGitRepository.get(), name.c_str()) == 0;
+}
+
+bool
+Repository::hasSnapshot(const git_oid &head, const git_oid &commit) const
+{
+    git_commit *target;
+    git_revwalk *walker;
+    git_oid oid;
+
+    int error = git_commit_lookup(&target, mGitRepository.get(), &commit);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    git_oid treeId = *git_commit_tree_id(target);
+    git_commit_free(target);
+
+    error = git_revwalk_new(&walker, mGitRepository.get());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    git_revwalk_simplify_first_parent(walker);
+
+    error = git_revwalk_push(walker, &head);
+
+    if (error < 0) {
+        git_revwalk_free(walker);
+        throwGitException(error);
+    }
+
+    bool found = false;
+
+    while (!found && !git_revwalk_next(&oid, walker)) {
+
+        git_commit *current;
+
+        error = git_commit_lookup(&current, mGitRepository.get(), &oid);
+
+        if (error < 0) {
+            git_revwalk_free(walker);
+            throwGitException(error);
+        }
+
+        found = git_oid_equal(git_commit_tree_id(current), &treeId);
+
+        git_commit_free(current);
+    }
+
+    git_revwalk_free(walker);
+
+    return found;
+}
+
+Repository &
+Repository::updateTrackingRef()
+{
+    git_oid headId;
+    git_reference *ref;
+
+    if (!lookupReference("HEAD", headId)) {
+        throwGitException();
+    }
+
+    int error = git_reference_create(&ref, mGitRepository.get(), TrackingRef.c_str(), &headId, 1, "km: push");
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    git_reference_free(ref);
+
+    return *this;
+}
+
+Repository &
+Repository::checkout(const Buffer &from)
+{
+    git_checkout_options options = GIT_CHECKOUT_OPTIONS_INIT;
+
+    // NOTE: the baseline lets the checkout touch only the fetched changes
+    options.checkout_strategy = GIT_CHECKOUT_SAFE;
+    options.baseline = lookupTree(from);
+
+    int error = git_checkout_head(mGitRepository.get(), &options);
+
+    git_tree_free(options.baseline);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
     return *this;
 }
 
@@ -407,7 +896,7 @@ Repository::init()
     error = git_repository_init(&repository, mPath.c_str(), 0);
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     mGitRepository = std::shared_ptr<git_repository>(repository, [](git_repository *data) {
@@ -424,7 +913,7 @@ Repository::init()
     );
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     // Create the directories
@@ -450,8 +939,7 @@ Repository::clone()
 
     git_clone_options options = GIT_CLONE_OPTIONS_INIT;
 
-    options.fetch_opts.callbacks.credentials = (git_cred_acquire_cb) &Repository::acquireCredentials;
-    options.fetch_opts.callbacks.payload = (void *) &mPrivateKey;
+    setCallbacks(options.fetch_opts.callbacks);
 
     error = git_clone
     (
@@ -462,7 +950,7 @@ Repository::clone()
     );
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     mGitRepository = std::shared_ptr<git_repository>(repository, [](git_repository *data) {
@@ -483,7 +971,7 @@ Repository::open()
     error = git_repository_open(&repository, mPath.c_str());
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     mGitRepository = std::shared_ptr<git_repository>(repository, [](git_repository *data) {
@@ -493,7 +981,7 @@ Repository::open()
     error = git_remote_lookup(&remote, mGitRepository.get(), "origin");
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     mGitRemote = std::shared_ptr<git_remote>(remote, [](git_remote *data) {
@@ -503,6 +991,140 @@ Repository::open()
     return *this;
 }
 
+Buffer
+Repository::getHead() const
+{
+    git_oid oid;
+
+    int error = git_reference_name_to_id(&oid, mGitRepository.get(), "HEAD");
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    Buffer hash(GIT_OID_HEXSZ + 1);
+
+    git_oid_tostr
+    (
+        (char *) hash.data(),
+        (size_t) hash.size(),
+        &oid
+    );
+
+    hash.resize(GIT_OID_HEXSZ);
+
+    return hash;
+}
+
+Repository &
+Repository::setHead(const Buffer &hash)
+{
+    git_oid oid;
+    git_reference *ref;
+
+    int error;
+
+    Buffer input = hash;
+    input.push_back('\0');
+
+    error = git_oid_fromstr(&oid, (const char *) input.data());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    error = git_reference_create(&ref, mGitRepository.get(), "refs/heads/master", &oid, 1, "km: reset head");
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    git_reference_free(ref);
+
+    return *this;
+}
+
+Buffer
+Repository::readFile(const Buffer &revision, const filesystem::path &path) const
+{
+    git_object *object;
+
+    std::string spec = revision.toString() + ":" + path.generic_string();
+
+    int error = git_revparse_single(&object, mGitRepository.get(), spec.c_str());
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    if (git_object_type(object) != GIT_OBJ_BLOB) {
+        git_object_free(object);
+        throw Exception("Failed reading %1%: not a file", spec);
+    }
+
+    git_blob *blob = (git_blob *) object;
+
+    Buffer output = Buffer::fromArray(
+        (std::uint8_t *) git_blob_rawcontent(blob),
+        (Buffer::size_type) git_blob_rawsize(blob)
+    );
+
+    git_object_free(object);
+
+    return output;
+}
+
+Repository &
+Repository::eachChange(const Buffer &from, const Buffer &to, std::function<void (const filesystem::path &, ChangeType)> callback)
+{
+    git_tree *oldTree = lookupTree(from);
+    git_tree *newTree = lookupTree(to);
+
+    git_diff *diff;
+
+    int error = git_diff_tree_to_tree(&diff, mGitRepository.get(), oldTree, newTree, NULL);
+
+    git_tree_free(oldTree);
+    git_tree_free(newTree);
+
+    if (error < 0) {
+        throwGitException(error);
+    }
+
+    std::size_t numOfDeltas = git_diff_num_deltas(diff);
+
+    try {
+
+        for (std::size_t i = 0; i < numOfDeltas; ++i) {
+
+            const git_diff_delta *delta = git_diff_get_delta(diff, i);
+
+            switch (delta->status) {
+
+                case GIT_DELTA_ADDED:
+                    callback(delta->new_file.path, CHANGE_ADDED);
+                    break;
+
+                case GIT_DELTA_DELETED:
+                    callback(delta->old_file.path, CHANGE_DELETED);
+                    break;
+
+                default:
+                    callback(delta->new_file.path, CHANGE_MODIFIED);
+                    break;
+            }
+        }
+
+    } catch (...) {
+        git_diff_free(diff);
+        throw;
+    }
+
+    git_diff_free(diff);
+
+    return *this;
+}
+
 Repository &
 Repository::eachCommits(const std::string &range, std::function<void (const Buffer &id, const Commit &)> callback)
 {
@@ -523,7 +1145,7 @@ Repository::eachCommits(const std::string &range, std::function<void (const Buff
     error = git_revwalk_push_glob(walker, "*");
 
     if (error < 0) {
-        throwGitException();
+        throwGitException(error);
     }
 
     while (!git_revwalk_next(&oid, walker)) {
@@ -531,7 +1153,7 @@ Repository::eachCommits(const std::string &range, std::function<void (const Buff
         error = git_commit_lookup(&commit, mGitRepository.get(), &oid);
 
         if (error < 0) {
-            throwGitException();
+            throwGitException(error);
         }
 
         auto repositoryCommit = Commit::fromGitCommit(commit);
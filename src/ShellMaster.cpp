@@ -0,0 +1,296 @@
+/*!
+ * Title ---- km/ShellMaster.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/ShellMaster.hpp>
+
+namespace km { // Begin main namespace
+
+const filesystem::path
+ShellMaster::SocketFile = "shell.sock";
+
+ShellMaster::ShellMaster(const filesystem::path &socketPath, const PrivateKey &privateKey)
+:
+    IpcServer(socketPath),
+    mPrivateKey(privateKey)
+{
+
+}
+
+ShellMaster::~ShellMaster()
+{
+    shutdown();
+}
+
+ShellMaster &
+ShellMaster::run(std::chrono::seconds idleTimeout)
+{
+    BEGIN_TASK("master", "Open control socket");
+    listen();
+    END_TASK();
+
+    auto lastActivity = Clock::now();
+
+    while (true) {
+
+        std::deque<Job> jobs;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+
+            if (mJobs.empty() && mPending.empty()) {
+
+                auto now = Clock::now();
+
+                if (mConnections.empty() && now >= lastActivity + idleTimeout) {
+                    break;
+                }
+
+                mCondition.wait_until(lock, std::min(
+                    lastActivity + idleTimeout,
+                    now + std::chrono::seconds(SshClient::KEEPALIVE_INTERVAL)
+                ));
+            }
+
+            jobs.swap(mJobs);
+        }
+
+        if (!jobs.empty() || !mPending.empty()) {
+            lastActivity = Clock::now();
+        }
+
+        for (auto &job : jobs) {
+            dispatch(job);
+        }
+
+        poll();
+        keepAlive();
+    }
+
+    shutdown();
+
+    return *this;
+}
+
+void
+ShellMaster::receive(Connection connection, IpcChannel::Message &message)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back({ connection, std::move(message) });
+    }
+
+    mCondition.notify_all();
+}
+
+void
+ShellMaster::shutdown()
+{
+    stop();
+
+    mJobs.clear();
+    mPending.clear();
+    mRetired.clear();
+    mSessions.clear();
+}
+
+void
+ShellMaster::dispatch(Job &job)
+{
+    auto &request = job.request;
+
+    if (request.size() != 6) {
+        reply(job.connection, {
+            request.empty() ? Buffer() : request[0],
+            Buffer::fromString("-1"),
+            Buffer(),
+            Buffer(),
+            Buffer::fromString("ShellMaster: malformed request")
+        });
+
+        return;
+    }
+
+    auto pending = std::make_shared<Pending>();
+
+    pending->connection = job.connection;
+    pending->id         = request[0];
+    pending->session    = format_buffer("%1%@%2%:%3%", request[3], request[1], request[2]);
+
+    try {
+
+        auto &session = getSession(pending->session, request[1], request[2], request[3]);
+
+        auto timeout = std::chrono::milliseconds(std::stoll(request[5].toString()));
+
+        // NOTE: the output is collected as it is, without the NUL terminator
+        pending->result = session.execAsync(request[4], [pending](const char *data, std::size_t size) {
+            pending->output.insert(pending->output.end(), data, data + size);
+        }, timeout);
+
+    } catch (std::exception &e) {
+
+        reply(job.connection, {
+            pending->id,
+            Buffer::fromString("-1"),
+            Buffer(),
+            Buffer(),
+            Buffer::fromString(e.what())
+        });
+
+        return;
+    }
+
+    mPending.push_back(pending);
+}
+
+void
+ShellMaster::poll()
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(POLL_INTERVAL);
+
+    for (auto it = mSessions.begin(); it != mSessions.end(); ) {
+
+        auto current = it++;
+
+        if (!current->second->getNumberOfRequests()) {
+            continue;
+        }
+
+        try {
+            current->second->runOnce(deadline);
+
+        } catch (std::exception &) {
+            retire(Buffer(current->first));
+        }
+    }
+
+    for (auto it = mRetired.begin(); it != mRetired.end(); ) {
+
+        try {
+
+            if ((*it)->getNumberOfRequests()) {
+                (*it)->runOnce(deadline);
+                ++it;
+                continue;
+            }
+
+        } catch (std::exception &) {
+            // The requests left fail with the session
+        }
+
+        it = mRetired.erase(it);
+    }
+
+    // Answer the completed requests
+    for (auto it = mPending.begin(); it != mPending.end(); ) {
+
+        auto &pending = **it;
+
+        if (pending.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        try {
+
+            auto result = pending.result.get();
+
+            reply(pending.connection, {
+                pending.id,
+                Buffer::fromString(std::to_string(result.returnCode)),
+                pending.output,
+                result.errors,
+                Buffer()
+            });
+
+        } catch (std::exception &e) {
+
+            // The next requests reconnect the server
+            retire(pending.session);
+
+            reply(pending.connection, {
+                pending.id,
+                Buffer::fromString("-1"),
+                Buffer(),
+                Buffer(),
+                Buffer::fromString(e.what())
+            });
+        }
+
+        it = mPending.erase(it);
+    }
+}
+
+void
+ShellMaster::keepAlive()
+{
+    for (auto it = mSessions.begin(); it != mSessions.end(); ) {
+
+        auto &session = *(it->second);
+
+        if (session.getNumberOfRequests()) {
+            ++it;
+            continue;
+        }
+
+        try {
+            session.keepAlive();
+            ++it;
+
+        } catch (std::exception &) {
+            it = mSessions.erase(it);
+        }
+    }
+}
+
+SshClient &
+ShellMaster::getSession(const Buffer &key, const Buffer &hostname, const Buffer &port, const Buffer &username)
+{
+    auto it = mSessions.find(key);
+
+    if (it != mSessions.end()) {
+        return *(it->second);
+    }
+
+    std::unique_ptr<SshClient> session;
+
+    for (int attempt = 0; ; ++attempt) {
+
+        try {
+            session = std::make_unique<SshClient>(hostname, port);
+            session->setDnsCache(mSocketPath.parent_path() / SshClient::DnsCacheFile);
+            session->connect(username, mPrivateKey);
+            break;
+
+        } catch (std::exception &) {
+
+            if (attempt >= CONNECT_RETRIES) {
+                throw;
+            }
+        }
+    }
+
+    return *(mSessions[key] = std::move(session));
+}
+
+void
+ShellMaster::retire(const Buffer &key)
+{
+    auto it = mSessions.find(key);
+
+    if (it == mSessions.end()) {
+        return;
+    }
+
+    mRetired.push_back(std::move(it->second));
+    mSessions.erase(it);
+}
+
+} // End of main namespace
@@ -12,7 +12,10 @@
 
 namespace km { // Begin main namespace
 
-SshClient::SshClient(const Buffer &hostname, const Buffer &port) : mHostname(hostname), mPort(port)
+const filesystem::path
+SshClient::DnsCacheFile = "dns.cache";
+
+SshClient::SshClient(const Buffer &hostname, const Buffer &port) : mHostname(hostname), mPort(port), mLastRequestId(0)
 {
 
 }
@@ -30,6 +33,8 @@ SshClient::connect(const Buffer &username, const Buffer &password)
 
     BEGIN_TASK("shell", "Authenticate user");
 
+    mUsername = username;
+
     checkAuthMethod(username, "password");
 
     int error = libssh2_userauth_password_ex
@@ -46,6 +51,9 @@ SshClient::connect(const Buffer &username, const Buffer &password)
         throw Exception("SshClient: authentication failed");
     }
 
+    // NOTE: the channels are multiplexed from here on
+    libssh2_session_set_blocking(mSession.get(), 0);
+
     END_TASK();
 }
 
@@ -57,6 +65,12 @@ SshClient::connect(const Buffer &username, const PrivateKey &privateKey)
 
     BEGIN_TASK("shell", "Authenticate user");
 
+    if (privateKey.getAlgorithm() == RsaKey::ALGORITHM_X25519) {
+        throw Exception("SshClient: X25519 keys can't authenticate");
+    }
+
+    mUsername = username;
+
     checkAuthMethod(username, "publickey");
 
     auto pkcsKey = privateKey.getPkcsKey();
@@ -77,9 +91,368 @@ SshClient::connect(const Buffer &username, const PrivateKey &privateKey)
         throw Exception("SshClient: authentication failed");
     }
 
+    // NOTE: the channels are multiplexed from here on
+    libssh2_session_set_blocking(mSession.get(), 0);
+
     END_TASK();
 }
 
+std::future<SshClient::Result>
+SshClient::execAsync(const Buffer &command, Clock::duration timeout)
+{
+    return execAsync(command, OutputCallback(), timeout);
+}
+
+std::future<SshClient::Result>
+SshClient::execAsync(const Buffer &command, OutputCallback callback, Clock::duration timeout)
+{
+    if (!isConnected()) {
+        throw Exception("SshClient: not connected");
+    }
+
+    auto request = std::make_shared<Request>();
+
+    request->callback = callback;
+
+    request->command = command;
+    request->command.push_back('\0');
+
+    request->timeout = timeout;
+    request->result.returnCode = -1;
+
+    mRequests.push_back(request);
+
+    return request->promise.get_future();
+}
+
+SshClient &
+SshClient::run()
+{
+    while (!mRequests.empty()) {
+        runOnce(Clock::time_point::max());
+    }
+
+    return *this;
+}
+
+SshClient &
+SshClient::runOnce(Clock::time_point deadline)
+{
+    if (mMaster) {
+
+        sendToMaster();
+
+        if (mMaster && !mRequests.empty()) {
+            receiveFromMaster();
+        }
+
+        return *this;
+    }
+
+    if (!mSession) {
+        throw Exception("SshClient: not connected");
+    }
+
+    auto now = Clock::now();
+
+    // NOTE: the other commands wait for a free slot, the server limits the channels per session
+    std::size_t active = std::count_if(mRequests.begin(), mRequests.end(), [](const std::shared_ptr<Request> &request) {
+        return request->started;
+    });
+
+    for (auto it = mRequests.begin(); it != mRequests.end(); ) {
+
+        auto &request = **it;
+
+        if (!request.started) {
+
+            if (active >= MAX_CHANNELS) {
+                ++it;
+                continue;
+            }
+
+            request.started  = true;
+            request.deadline = now + request.timeout;
+
+            ++active;
+        }
+
+        bool done;
+
+        try {
+
+            if (now >= request.deadline) {
+
+                // NOTE: a channel that does not close in time is left to the session
+                if (request.abandoned) {
+                    it = mRequests.erase(it);
+                    --active;
+                    continue;
+                }
+
+                abandon(request, std::make_exception_ptr(
+                    Exception("SshClient: command timed out")
+                ));
+            }
+
+            done = step(request);
+
+        } catch (...) {
+
+            if (!request.abandoned) {
+                abandon(request, std::current_exception());
+            }
+
+            done = (request.state == REQUEST_DONE);
+        }
+
+        if (done) {
+            it = mRequests.erase(it);
+            --active;
+
+        } else {
+            deadline = std::min(deadline, request.deadline);
+            ++it;
+        }
+    }
+
+    if (!mRequests.empty()) {
+        wait(deadline);
+    }
+
+    return *this;
+}
+
+bool
+SshClient::attachMaster(const filesystem::path &path, const Buffer &username)
+{
+    mMaster   = IpcChannel::connect(path);
+    mUsername = username;
+
+    return (bool) mMaster;
+}
+
+void
+SshClient::sendToMaster()
+{
+    std::size_t active = std::count_if(mRequests.begin(), mRequests.end(), [](const std::shared_ptr<Request> &request) {
+        return request->started;
+    });
+
+    for (auto &request : mRequests) {
+
+        if (active >= MAX_CHANNELS) {
+            break;
+        }
+
+        if (request->started) {
+            continue;
+        }
+
+        request->id       = Buffer::fromString(std::to_string(++mLastRequestId));
+        request->started  = true;
+        request->deadline = Clock::now() + request->timeout;
+
+        auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(request->timeout).count();
+
+        try {
+
+            // NOTE: the control master enforces the timeout
+            mMaster->send({
+                request->id,
+                mHostname,
+                mPort,
+                mUsername,
+                Buffer(request->command.begin(), request->command.end() - 1),
+                Buffer::fromString(std::to_string(milliseconds))
+            });
+
+        } catch (std::exception &e) {
+            detachMaster(e.what());
+            return;
+        }
+
+        ++active;
+    }
+}
+
+void
+SshClient::detachMaster(const std::string &reason)
+{
+    // Without the control master the pending commands are lost, and the client is disconnected
+    auto error = std::make_exception_ptr(
+        Exception("SshClient: control master disconnected: %1%", reason)
+    );
+
+    for (auto &request : mRequests) {
+        request->promise.set_exception(error);
+    }
+
+    mRequests.clear();
+    mMaster.reset();
+}
+
+void
+SshClient::receiveFromMaster()
+{
+    IpcChannel::Message message;
+
+    auto deadline = Clock::time_point::max();
+
+    for (auto &request : mRequests) {
+        deadline = std::min(deadline, request->deadline);
+    }
+
+    try {
+        // NOTE: a master that hangs must not hang its clients
+        message = mMaster->receive(deadline + std::chrono::seconds(CLOSE_TIMEOUT));
+
+    } catch (std::exception &e) {
+        detachMaster(e.what());
+        return;
+    }
+
+    if (message.size() != 5) {
+        throw Exception("SshClient: malformed control master response");
+    }
+
+    auto it = std::find_if(mRequests.begin(), mRequests.end(), [&message](const std::shared_ptr<Request> &request) {
+        return request->id == message[0];
+    });
+
+    if (it == mRequests.end()) {
+        return;
+    }
+
+    auto request = *it;
+
+    mRequests.erase(it);
+
+    if (!message[4].empty()) {
+        request->promise.set_exception(std::make_exception_ptr(
+            Exception(message[4].toString())
+        ));
+
+        return;
+    }
+
+    auto &result = request->result;
+
+    result.returnCode = std::stoi(message[1].toString());
+    result.errors     = message[3];
+
+    try {
+
+        if (request->callback) {
+            request->callback((const char *) message[2].data(), message[2].size());
+
+        } else {
+            result.output = message[2];
+            result.output.push_back('\0');
+        }
+
+    } catch (...) {
+        request->promise.set_exception(std::current_exception());
+        return;
+    }
+
+    request->promise.set_value(result);
+}
+
+void
+SshClient::wait(Clock::time_point deadline)
+{
+    int directions = libssh2_session_block_directions(mSession.get());
+
+    if (!directions) {
+        return;
+    }
+
+    auto handler = [](const system::error_code &, std::size_t) {};
+
+    mIoService->reset();
+
+    if (directions & LIBSSH2_SESSION_BLOCK_INBOUND) {
+        mSocket->async_read_some(asio::null_buffers(), handler);
+    }
+
+    if (directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) {
+        mSocket->async_write_some(asio::null_buffers(), handler);
+    }
+
+    asio::steady_timer timer(*mIoService);
+
+    if (deadline != Clock::time_point::max()) {
+        timer.expires_at(deadline);
+        timer.async_wait([](const system::error_code &) {});
+    }
+
+    // Wake up on the first event and discard the others
+    mIoService->run_one();
+
+    system::error_code error;
+
+    mSocket->cancel(error);
+    timer.cancel();
+
+    mIoService->run();
+}
+
+void
+SshClient::keepAlive()
+{
+    if (!mSession) {
+        throw Exception("SshClient: no session available");
+    }
+
+    int next;
+
+    int error = libssh2_keepalive_send(mSession.get(), &next);
+
+    if (error && error != LIBSSH2_ERROR_EAGAIN) {
+        throw Exception("SshClient: keepalive failed (%1%)", error);
+    }
+}
+
+LIBSSH2_CHANNEL *
+SshClient::openChannel(const Buffer &command)
+{
+    if (!mSession) {
+        throw Exception("SshClient: no session available");
+    }
+
+    LIBSSH2_CHANNEL *channel;
+
+    while (!(channel = libssh2_channel_open_session(mSession.get()))) {
+
+        if (libssh2_session_last_errno(mSession.get()) != LIBSSH2_ERROR_EAGAIN) {
+            throw Exception("SshClient: failed to open the channel");
+        }
+
+        wait();
+    }
+
+    Buffer planCommand = command;
+    planCommand.push_back('\0');
+
+    int error;
+
+    while ((error = libssh2_channel_exec(channel, (const char *) planCommand.data())) == LIBSSH2_ERROR_EAGAIN) {
+        wait();
+    }
+
+    if (error) {
+
+        while (libssh2_channel_free(channel) == LIBSSH2_ERROR_EAGAIN) {
+            wait();
+        }
+
+        throw Exception("SshClient: failed to exec the command");
+    }
+
+    return channel;
+}
+
 void
 SshClient::openSession()
 {
@@ -99,6 +472,8 @@ SshClient::openSession()
         throw Exception("SshClient: session handshake failed");
     }
 
+    libssh2_keepalive_config(mSession.get(), 1, KEEPALIVE_INTERVAL);
+
     END_TASK();
 }
 
@@ -122,10 +497,9 @@ SshClient::closeSession()
 {
     BEGIN_TASK("shell", "Stop SSH session");
 
-    if (libssh2_session_disconnect(mSession.get(), "Shutdown ...")) {
-        throw Exception("SshClient: failed to disconnect the session");
-    }
-
+    // NOTE: this runs in the deleter, a broken session is just freed
+    libssh2_session_set_blocking(mSession.get(), 1);
+    libssh2_session_disconnect(mSession.get(), "Shutdown ...");
     libssh2_session_free(mSession.get());
 
     END_TASK();
@@ -134,19 +508,51 @@ SshClient::closeSession()
 void
 SshClient::openSocket()
 {
-    using query = tcp::resolver::query;
-
     mIoService = std::make_shared<asio::io_service>();
 
     mSocket = std::shared_ptr<tcp::socket>(new tcp::socket(*mIoService), [this](tcp::socket *) {
         closeSocket();
     });
 
-    system::error_code error;
-    tcp::resolver::iterator end, endpoint_iterator;
+    std::vector<tcp::endpoint> endpoints;
+
+    bool cached = readDnsCache(endpoints);
+
+    if (!cached) {
+        endpoints = resolve();
+        writeDnsCache(endpoints);
+    }
+
+    if (connectSocket(endpoints)) {
+        return;
+    }
+
+    // NOTE: the cached addresses may be outdated
+    if (cached) {
+
+        endpoints = resolve();
+        writeDnsCache(endpoints);
+
+        if (connectSocket(endpoints)) {
+            return;
+        }
+    }
+
+    throw Exception("SshClient: failed to connect to '%1%'", mHostname.toString());
+}
+
+std::vector<tcp::endpoint>
+SshClient::resolve()
+{
+    using query = tcp::resolver::query;
+
+    std::vector<tcp::endpoint> endpoints;
 
     BEGIN_TASK("shell", "Resolve " << mHostname);
 
+    system::error_code error;
+    tcp::resolver::iterator end, endpoint_iterator;
+
     tcp::resolver resolver(*mIoService);
 
     endpoint_iterator = resolver.resolve(
@@ -158,24 +564,254 @@ SshClient::openSocket()
         throw Exception("SshClient: unable to resolve '" + mHostname.toString() + "'");
     }
 
+    endpoints.assign(endpoint_iterator, end);
+
     END_TASK();
 
-    while (endpoint_iterator != end)
-    {
-        tcp::endpoint endpoint = *endpoint_iterator++;
+    return sortEndpoints(endpoints);
+}
+
+bool
+SshClient::connectSocket(const std::vector<tcp::endpoint> &endpoints)
+{
+    bool connected = false;
+
+    BEGIN_TASK("shell", "Connect to " << mHostname);
+
+    std::vector<std::unique_ptr<tcp::socket>> attempts;
+
+    std::size_t next    = 0;
+    std::size_t running = 0;
+    std::size_t winner  = 0;
+
+    bool done = false;
 
-        BEGIN_TASK("shell", "Connect to " << endpoint.address());
+    asio::steady_timer delayTimer(*mIoService);
+    asio::steady_timer deadlineTimer(*mIoService);
 
-        if (!mSocket->connect(endpoint, error)) {
+    std::function<void ()> startAttempt;
+
+    startAttempt = [&]() {
+
+        if (done || next >= endpoints.size()) {
             return;
         }
 
+        auto index = next++;
+
+        attempts.push_back(std::make_unique<tcp::socket>(*mIoService));
+        ++running;
+
+        attempts[index]->async_connect(endpoints[index], [&, index](const system::error_code &error) {
+
+            --running;
+
+            if (done) {
+                return;
+            }
+
+            if (!error) {
+                winner = index;
+                done   = connected = true;
+                return;
+            }
+
+            // Don't wait for the delay after a failure
+            startAttempt();
+        });
+
+        // The next attempt starts if this one doesn't complete in time
+        delayTimer.expires_from_now(std::chrono::milliseconds(CONNECT_DELAY));
+        delayTimer.async_wait([&](const system::error_code &error) {
+            if (!error) {
+                startAttempt();
+            }
+        });
+    };
+
+    deadlineTimer.expires_from_now(std::chrono::seconds(CONNECT_TIMEOUT));
+    deadlineTimer.async_wait([&](const system::error_code &error) {
+        if (!error) {
+            done = true;
+        }
+    });
+
+    mIoService->reset();
+
+    startAttempt();
+
+    while (!done && (running || next < endpoints.size())) {
+        mIoService->run_one();
+    }
+
+    done = true;
+
+    // Discard the other attempts
+    system::error_code error;
+
+    for (std::size_t i = 0; i < attempts.size(); ++i) {
+        if (!connected || i != winner) {
+            attempts[i]->close(error);
+        }
+    }
+
+    delayTimer.cancel();
+    deadlineTimer.cancel();
+
+    mIoService->run();
+
+    if (connected) {
+        *mSocket = std::move(*attempts[winner]);
+    } else {
         throw TaskException("SshClient: unable to connect");
+    }
+
+    END_TASK();
+
+    return connected;
+}
+
+std::vector<tcp::endpoint>
+SshClient::sortEndpoints(const std::vector<tcp::endpoint> &endpoints)
+{
+    std::vector<tcp::endpoint> preferred, others;
+
+    for (auto &endpoint : endpoints) {
+
+        if (preferred.empty() || endpoint.protocol() == preferred.front().protocol()) {
+            preferred.push_back(endpoint);
+        } else {
+            others.push_back(endpoint);
+        }
+    }
+
+    // Alternate the families, starting from the preferred one
+    std::vector<tcp::endpoint> sorted;
+
+    for (std::size_t i = 0; i < std::max(preferred.size(), others.size()); ++i) {
+
+        if (i < preferred.size()) {
+            sorted.push_back(preferred[i]);
+        }
+
+        if (i < others.size()) {
+            sorted.push_back(others[i]);
+        }
+    }
+
+    return sorted;
+}
+
+bool
+SshClient::readDnsCache(std::vector<tcp::endpoint> &endpoints) const
+{
+    if (mDnsCachePath.empty()) {
+        return false;
+    }
+
+    filesystem::ifstream file(mDnsCachePath);
+
+    std::string line;
+
+    while (std::getline(file, line)) {
+
+        std::istringstream fields(line);
+
+        std::string hostname, port;
+        std::time_t expiry;
+
+        if (!(fields >> hostname >> port >> expiry)) {
+            continue;
+        }
 
-        END_TASK();
+        if (hostname != mHostname.toString() || port != mPort.toString()) {
+            continue;
+        }
+
+        if (expiry <= std::time(nullptr)) {
+            return false;
+        }
+
+        std::string address;
+
+        endpoints.clear();
+
+        while (fields >> address) {
+
+            system::error_code error;
+
+            auto ip = asio::ip::address::from_string(address, error);
+
+            if (error) {
+                return false;
+            }
+
+            endpoints.emplace_back(ip, (unsigned short) std::stoi(port));
+        }
+
+        return !endpoints.empty();
+    }
+
+    return false;
+}
+
+void
+SshClient::writeDnsCache(const std::vector<tcp::endpoint> &endpoints) const
+{
+    if (mDnsCachePath.empty()) {
+        return;
+    }
+
+    auto now = std::time(nullptr);
+
+    std::ostringstream output;
+
+    // Keep the fresh entries of the other servers
+    {
+        filesystem::ifstream file(mDnsCachePath);
+
+        std::string line;
+
+        while (std::getline(file, line)) {
+
+            std::istringstream fields(line);
+
+            std::string hostname, port;
+            std::time_t expiry;
+
+            if (!(fields >> hostname >> port >> expiry) || expiry <= now) {
+                continue;
+            }
+
+            if (hostname != mHostname.toString() || port != mPort.toString()) {
+                output << line << std::endl;
+            }
+        }
+    }
+
+    output << mHostname.toString() << " " << mPort.toString() << " " << (now + DNS_CACHE_TTL);
+
+    for (auto &endpoint : endpoints) {
+        output << " " << endpoint.address().to_string();
     }
 
-    throw Exception("SshClient: failed to connect");
+    output << std::endl;
+
+    // NOTE: the file is replaced at once, other clients may be reading it
+    auto tempPath = mDnsCachePath;
+    tempPath += filesystem::unique_path(".%%%%%%%%");
+
+    {
+        filesystem::ofstream file(tempPath);
+        file << output.str();
+    }
+
+    system::error_code error;
+    filesystem::rename(tempPath, mDnsCachePath, error);
+
+    if (error) {
+        filesystem::remove(tempPath, error);
+    }
 }
 
 void
@@ -183,27 +819,150 @@ SshClient::closeSocket()
 {
     BEGIN_TASK("shell", "Close connection");
 
-    mSocket->close();
+    system::error_code error;
+    mSocket->close(error);
 
     END_TASK();
 }
 
-Buffer
-SshClient::readFromChannel(LIBSSH2_CHANNEL *channel)
+bool
+SshClient::step(Request &request)
 {
-    Buffer response, buffer(1024);
+    Buffer buffer(4096);
+
+    ssize_t length, errorLength;
 
-    ssize_t length;
+    int error;
 
-    do {
-        length = libssh2_channel_read(channel, (char *) buffer.data(), 1024);
-        response.insert(response.end(), buffer.begin(), buffer.begin() + length);
+    for (;;) {
 
-    } while (length != LIBSSH2_ERROR_EAGAIN && length > 0);
+        switch (request.state) {
 
-    response.push_back('\0');
+            case REQUEST_OPEN:
 
-    return response;
+                request.channel = libssh2_channel_open_session(mSession.get());
+
+                if (!request.channel) {
+
+                    if (libssh2_session_last_errno(mSession.get()) == LIBSSH2_ERROR_EAGAIN) {
+                        return false;
+                    }
+
+                    throw Exception("SshClient: failed to open the channel");
+                }
+
+                request.state = REQUEST_EXEC;
+                break;
+
+            case REQUEST_EXEC:
+
+                error = libssh2_channel_exec(request.channel, (const char *) request.command.data());
+
+                if (error == LIBSSH2_ERROR_EAGAIN) {
+                    return false;
+                }
+
+                if (error) {
+                    throw Exception("SshClient: failed to exec the command");
+                }
+
+                request.state = REQUEST_READ;
+                break;
+
+            case REQUEST_READ:
+
+                length = libssh2_channel_read(request.channel, (char *) buffer.data(), buffer.size());
+
+                if (length > 0) {
+
+                    if (request.callback) {
+                        request.callback((const char *) buffer.data(), (std::size_t) length);
+
+                    } else {
+                        request.result.output.insert(request.result.output.end(), buffer.begin(), buffer.begin() + length);
+                    }
+
+                    break;
+                }
+
+                // NOTE: a full stderr window would stall the channel
+                errorLength = libssh2_channel_read_stderr(request.channel, (char *) buffer.data(), buffer.size());
+
+                if (errorLength > 0) {
+                    request.result.errors.insert(request.result.errors.end(), buffer.begin(), buffer.begin() + errorLength);
+                    break;
+                }
+
+                if (length < 0 && length != LIBSSH2_ERROR_EAGAIN) {
+                    throw Exception("SshClient: failed reading from the channel");
+                }
+
+                if (!libssh2_channel_eof(request.channel)) {
+                    return false;
+                }
+
+                request.state = REQUEST_CLOSE;
+                break;
+
+            case REQUEST_CLOSE:
+
+                if (libssh2_channel_close(request.channel) == LIBSSH2_ERROR_EAGAIN) {
+                    return false;
+                }
+
+                request.state = REQUEST_WAIT;
+                break;
+
+            case REQUEST_WAIT:
+
+                if (libssh2_channel_wait_closed(request.channel) == LIBSSH2_ERROR_EAGAIN) {
+                    return false;
+                }
+
+                request.result.returnCode = libssh2_channel_get_exit_status(request.channel);
+                request.state = REQUEST_FREE;
+                break;
+
+            case REQUEST_FREE:
+
+                if (libssh2_channel_free(request.channel) == LIBSSH2_ERROR_EAGAIN) {
+                    return false;
+                }
+
+                request.channel = nullptr;
+                request.state   = REQUEST_DONE;
+
+                if (!request.abandoned) {
+
+                    if (!request.callback) {
+                        request.result.output.push_back('\0');
+                    }
+
+                    request.promise.set_value(request.result);
+                }
+
+                return true;
+
+            case REQUEST_DONE:
+                return true;
+        }
+    }
+}
+
+void
+SshClient::abandon(Request &request, std::exception_ptr error)
+{
+    request.promise.set_exception(error);
+
+    request.abandoned = true;
+    request.deadline  = Clock::now() + std::chrono::seconds(CLOSE_TIMEOUT);
+
+    if (!request.channel) {
+        request.state = REQUEST_DONE;
+
+    } else if (request.state < REQUEST_CLOSE) {
+        request.state = REQUEST_CLOSE;
+    }
 }
 
 } // End of main namespace
\ No newline at end of file
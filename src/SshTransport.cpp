@@ -0,0 +1,214 @@
+/*!
+ * Title ---- km/SshTransport.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/SshTransport.hpp>
+
+namespace km { // Begin main namespace
+
+int
+SshTransport::create(git_transport **out, git_remote *owner, void *client)
+{
+    // NOTE: the smart transport builds the subtransport right away
+    git_smart_subtransport_definition definition = {
+        &SshTransport::createSubtransport,
+        0,
+        client
+    };
+
+    return git_transport_smart(out, owner, &definition);
+}
+
+int
+SshTransport::createSubtransport(git_smart_subtransport **out, git_transport *, void *client)
+{
+    auto subtransport = new Subtransport();
+
+    subtransport->parent.action = &SshTransport::action;
+    subtransport->parent.close  = &SshTransport::close;
+    subtransport->parent.free   = &SshTransport::free;
+
+    subtransport->client  = static_cast<SshClient *>(client);
+    subtransport->current = nullptr;
+
+    *out = &subtransport->parent;
+
+    return 0;
+}
+
+int
+SshTransport::action(git_smart_subtransport_stream **out, git_smart_subtransport *subtransport, const char *url, git_smart_service_t service)
+{
+    auto self = reinterpret_cast<Subtransport *>(subtransport);
+
+    const char *command;
+
+    switch (service) {
+
+        case GIT_SERVICE_UPLOADPACK_LS:
+            command = "git-upload-pack";
+            break;
+
+        case GIT_SERVICE_RECEIVEPACK_LS:
+            command = "git-receive-pack";
+            break;
+
+        default:
+
+            // NOTE: the service continues on the stream of the reference listing
+            if (!self->current) {
+                giterr_set_str(GITERR_SSH, "SshTransport: the references must be listed first");
+                return -1;
+            }
+
+            *out = &self->current->parent;
+
+            return 0;
+    }
+
+    LIBSSH2_CHANNEL *channel;
+
+    try {
+
+        auto path = SshTransport::getRepositoryPath(url);
+
+        channel = self->client->openChannel(
+            Buffer::fromString(std::string(command) + " '" + path + "'")
+        );
+
+    } catch (std::exception &e) {
+        giterr_set_str(GITERR_SSH, e.what());
+        return -1;
+    }
+
+    auto stream = new Stream();
+
+    stream->parent.subtransport = subtransport;
+    stream->parent.read  = &SshTransport::read;
+    stream->parent.write = &SshTransport::write;
+    stream->parent.free  = &SshTransport::freeStream;
+
+    stream->channel = channel;
+
+    self->current = stream;
+
+    *out = &stream->parent;
+
+    return 0;
+}
+
+int
+SshTransport::close(git_smart_subtransport *)
+{
+    return 0;
+}
+
+void
+SshTransport::free(git_smart_subtransport *subtransport)
+{
+    delete reinterpret_cast<Subtransport *>(subtransport);
+}
+
+int
+SshTransport::read(git_smart_subtransport_stream *stream, char *buffer, size_t size, size_t *bytesRead)
+{
+    auto self  = reinterpret_cast<Stream *>(stream);
+    auto owner = reinterpret_cast<Subtransport *>(stream->subtransport);
+
+    ssize_t length;
+
+    // NOTE: the session is non-blocking, libgit2 expects a blocking stream
+    while ((length = libssh2_channel_read(self->channel, buffer, size)) == LIBSSH2_ERROR_EAGAIN) {
+        owner->client->wait();
+    }
+
+    if (length < 0) {
+        giterr_set_str(GITERR_SSH, "SshTransport: failed reading from the channel");
+        return -1;
+    }
+
+    *bytesRead = (size_t) length;
+
+    return 0;
+}
+
+int
+SshTransport::write(git_smart_subtransport_stream *stream, const char *buffer, size_t size)
+{
+    auto self  = reinterpret_cast<Stream *>(stream);
+    auto owner = reinterpret_cast<Subtransport *>(stream->subtransport);
+
+    size_t offset = 0;
+
+    while (offset < size) {
+
+        ssize_t length = libssh2_channel_write(self->channel, buffer + offset, size - offset);
+
+        if (length == LIBSSH2_ERROR_EAGAIN) {
+            owner->client->wait();
+            continue;
+        }
+
+        if (length < 0) {
+            giterr_set_str(GITERR_SSH, "SshTransport: failed writing into the channel");
+            return -1;
+        }
+
+        offset += (size_t) length;
+    }
+
+    return 0;
+}
+
+void
+SshTransport::freeStream(git_smart_subtransport_stream *stream)
+{
+    auto self  = reinterpret_cast<Stream *>(stream);
+    auto owner = reinterpret_cast<Subtransport *>(stream->subtransport);
+
+    if (owner->current == self) {
+        owner->current = nullptr;
+    }
+
+    // NOTE: only the channel goes away, the session is still in use
+    while (libssh2_channel_close(self->channel) == LIBSSH2_ERROR_EAGAIN) {
+        owner->client->wait();
+    }
+
+    while (libssh2_channel_free(self->channel) == LIBSSH2_ERROR_EAGAIN) {
+        owner->client->wait();
+    }
+
+    delete self;
+}
+
+std::string
+SshTransport::getRepositoryPath(const std::string &url)
+{
+    std::string::size_type start;
+
+    if (url.compare(0, 6, "ssh://") == 0) {
+        start = url.find('/', 6);
+
+    } else {
+        start = url.find(':');
+
+        if (start != std::string::npos) {
+            start++;
+        }
+    }
+
+    if (start == std::string::npos || start == url.size() || url.find('\'', start) != std::string::npos) {
+        throw Exception("SshTransport: invalid remote URL '%1%'", url);
+    }
+
+    return url.substr(start);
+}
+
+} // End of main namespace
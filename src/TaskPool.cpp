@@ -0,0 +1,103 @@
+/*!
+ * Title ---- km/TaskPool.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/TaskPool.hpp>
+
+namespace km { // Begin main namespace
+
+void
+TaskPool::run(std::size_t count, std::function<void (std::size_t)> task, unsigned int numOfThreads)
+{
+    TaskPool pool(count, task, numOfThreads);
+
+    pool
+        .join()
+        .rethrow()
+    ;
+}
+
+TaskPool::TaskPool(std::size_t count, std::function<void (std::size_t)> task, unsigned int numOfThreads)
+:
+    mCount(count),
+    mTask(task),
+    mNext(0),
+    mStopped(false),
+    mErrors(count)
+{
+    if (numOfThreads == 0) {
+        numOfThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    auto size = std::min<std::size_t>(numOfThreads, count);
+
+    for (std::size_t i = 0; i < size; ++i) {
+
+        try {
+            mWorkers.emplace_back(&TaskPool::work, this);
+
+        } catch (std::system_error &e) {
+            // NOTE: out of threads, the workers already started take all the indexes
+            break;
+        }
+    }
+
+    if (mWorkers.empty()) {
+        work();
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    stop();
+    join();
+}
+
+TaskPool &
+TaskPool::join()
+{
+    for (auto &thread : mWorkers) {
+        thread.join();
+    }
+
+    mWorkers.clear();
+
+    return *this;
+}
+
+TaskPool &
+TaskPool::rethrow()
+{
+    for (auto &error : mErrors) {
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    return *this;
+}
+
+void
+TaskPool::work()
+{
+    std::size_t i;
+
+    while (!mStopped && (i = mNext++) < mCount) {
+
+        try {
+            mTask(i);
+
+        } catch (...) {
+            mErrors[i] = std::current_exception();
+        }
+    }
+}
+
+} // End of main namespace
@@ -45,8 +45,15 @@ TextNode::fromBuffer(const Buffer &data)
         throw Exception("Unable to parse text node");
     }
 
+    // NOTE: the key version is appended only after a key rotation
+    auto next = std::find(it + 1, end, ':');
+
     node.mContent = Buffer::fromBase64(data.cbegin(), it);
-    node.mNonce   = Buffer::fromBase64(it + 1, data.cend());
+    node.mNonce   = Buffer::fromBase64(it + 1, next);
+
+    if (next != end) {
+        node.mKeyVersion = (unsigned int) std::stoul(std::string(next + 1, end));
+    }
 
     return node;
 }
@@ -64,10 +71,17 @@ TextNode::toBuffer(const TextNode &node)
 
     buffer[content.size()] = ':';
 
+    if (node.getKeyVersion()) {
+        auto version = std::to_string(node.getKeyVersion());
+
+        buffer.push_back(':');
+        buffer.insert(buffer.end(), version.begin(), version.end());
+    }
+
     return buffer;
 }
 
-TextNode::TextNode()
+TextNode::TextNode() : mKeyVersion(0)
 {
 
 }
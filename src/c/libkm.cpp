@@ -0,0 +1,369 @@
+/*!
+ * Title ---- km/c/libkm.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include <km/c/libkm.h>
+
+#include <km/Core.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <openssl/crypto.h>
+
+using namespace km;
+
+/*!
+ * The session state.
+ */
+struct km_session
+{
+    /*!
+     * The last error.
+     */
+    std::string error;
+
+    /*!
+     * Indicates whether a repository has been opened.
+     */
+    bool hasRepository = false;
+};
+
+/*!
+ * The iterator state.
+ */
+struct km_iterator
+{
+    /*!
+     * The entry IDs and names.
+     */
+    std::vector<std::pair<SafeString, SafeString>> entries;
+
+    /*!
+     * The position of the next entry.
+     */
+    std::size_t index;
+};
+
+namespace km { // Begin main namespace
+
+namespace c { // Begin C namespace
+
+/*!
+ * Serializes the access to the core (a process-wide singleton).
+ */
+static std::mutex CoreMutex;
+
+/*!
+ * The open session (the core state is process-wide, so there is one at most).
+ */
+static km_session *OpenSession = nullptr;
+
+/*!
+ * Stops an iteration over the repository entries.
+ */
+struct StopIteration { };
+
+/*!
+ * Runs a call on the core, turning the exceptions into return codes.
+ */
+template <typename T_FUNCTION>
+static int
+call(km_session *session, T_FUNCTION function)
+{
+    if (!session) {
+        return KM_ERROR;
+    }
+
+    std::lock_guard<std::mutex> lock(CoreMutex);
+
+    session->error.clear();
+
+    try {
+        return function(Core::get());
+
+    } catch (PropertyNotFoundException &e) {
+        session->error = e.what();
+        return KM_NOT_FOUND;
+
+    } catch (std::exception &e) {
+        session->error = e.what();
+        return KM_ERROR;
+    }
+}
+
+/*!
+ * Rejects a null argument.
+ */
+static void
+checkArgument(const void *argument, const char *name)
+{
+    if (!argument) {
+        throw Exception("Invalid argument '%1%'", name);
+    }
+}
+
+/*!
+ * Checks that the session has a repository open.
+ */
+static void
+checkRepository(const km_session *session)
+{
+    if (!session->hasRepository) {
+        throw Exception("No repository open (see `km_repository_open()`)");
+    }
+}
+
+/*!
+ * Looks up an entry of the open repository by ID or by name.
+ */
+static bool
+findEntry(Core &core, const Buffer &reference, EntryNode &output)
+{
+    Buffer id;
+
+    // NOTE: only the names are decrypted while matching, then the matched entry
+    if (!core.findRepositoryEntry(reference, id)) {
+        return false;
+    }
+
+    output = core.getRepositoryEntry(id);
+
+    return true;
+}
+
+} // End of C namespace
+
+} // End of main namespace
+
+int
+km_abi_version(void)
+{
+    return KM_ABI_VERSION;
+}
+
+km_session *
+km_session_open(void)
+{
+    std::lock_guard<std::mutex> lock(c::CoreMutex);
+
+    if (c::OpenSession) {
+        return nullptr;
+    }
+
+    try {
+
+        // NOTE: the library never writes to the terminal
+        Console::setDebug(false);
+
+        Core::get();
+
+        c::OpenSession = new km_session();
+
+        return c::OpenSession;
+
+    } catch (std::exception &e) {
+        return nullptr;
+    }
+}
+
+void
+km_session_close(km_session *session)
+{
+    std::lock_guard<std::mutex> lock(c::CoreMutex);
+
+    if (session == c::OpenSession) {
+        c::OpenSession = nullptr;
+    }
+
+    delete session;
+}
+
+const char *
+km_last_error(const km_session *session)
+{
+    return session ? session->error.c_str() : "Invalid session";
+}
+
+int
+km_authenticate(km_session *session, const char *passphrase, size_t length)
+{
+    return c::call(session, [passphrase, length](Core &core) {
+
+        c::checkArgument(passphrase, "passphrase");
+
+        core.authenticate(Buffer::fromArray((std::uint8_t *) passphrase, length));
+        return KM_OK;
+    });
+}
+
+int
+km_repository_open(km_session *session, const char *repository_id)
+{
+    return c::call(session, [session, repository_id](Core &core) {
+
+        c::checkArgument(repository_id, "repository_id");
+
+        // NOTE: a failed open leaves the core without a repository
+        session->hasRepository = false;
+
+        core.openRepository(Buffer::fromString(repository_id));
+
+        session->hasRepository = true;
+
+        return KM_OK;
+    });
+}
+
+int
+km_entry_get(km_session *session, const char *entry, const char *property, char **value, size_t *length)
+{
+    return c::call(session, [session, entry, property, value, length](Core &core) {
+
+        c::checkArgument(entry,    "entry");
+        c::checkArgument(property, "property");
+        c::checkArgument(value,    "value");
+        c::checkArgument(length,   "length");
+
+        c::checkRepository(session);
+
+        auto output = EntryNode::create();
+
+        if (!c::findEntry(core, Buffer::fromString(entry), output)) {
+            session->error = "Entry not found";
+            return KM_NOT_FOUND;
+        }
+
+        auto &content = output.getProperty(Buffer::fromString(property)).getContent();
+
+        *value = (char *) std::malloc(content.size() + 1);
+
+        if (!*value) {
+            throw std::bad_alloc();
+        }
+
+        std::memcpy(*value, content.data(), content.size());
+
+        (*value)[content.size()] = '\0';
+        *length = content.size();
+
+        return KM_OK;
+    });
+}
+
+int
+km_entry_list(km_session *session, km_iterator **iterator)
+{
+    return c::call(session, [session, iterator](Core &core) {
+
+        c::checkArgument(iterator, "iterator");
+
+        c::checkRepository(session);
+
+        auto output = std::make_unique<km_iterator>();
+        output->index = 0;
+
+        core.eachRepositoryEntry([&output](const Buffer &id, EntryNode &entry) {
+
+            SafeString name;
+
+            try {
+                auto &content = entry.getProperty("name").getContent();
+                name.assign(content.begin(), content.end());
+
+            } catch (PropertyNotFoundException &e) {
+                // Unnamed entry
+            }
+
+            output->entries.emplace_back(SafeString(id.begin(), id.end()), name);
+        });
+
+        *iterator = output.release();
+
+        return KM_OK;
+    });
+}
+
+int
+km_iterator_next(km_iterator *iterator, const char **entry_id, const char **name)
+{
+    if (!iterator || !entry_id || !name) {
+        return KM_ERROR;
+    }
+
+    if (iterator->index >= iterator->entries.size()) {
+        return KM_END;
+    }
+
+    auto &entry = iterator->entries[iterator->index++];
+
+    *entry_id = entry.first.c_str();
+    *name     = entry.second.c_str();
+
+    return KM_OK;
+}
+
+void
+km_iterator_free(km_iterator *iterator)
+{
+    // NOTE: the strings are wiped by their allocator
+    delete iterator;
+}
+
+int
+km_each_property(km_session *session, km_property_cb callback, void *payload)
+{
+    return c::call(session, [session, callback, payload](Core &core) {
+
+        c::checkArgument((const void *) callback, "callback");
+
+        c::checkRepository(session);
+
+        try {
+
+            core.eachRepositoryEntry([callback, payload](const Buffer &id, EntryNode &entry) {
+
+                SafeString entryId(id.begin(), id.end());
+
+                entry.eachProperty([&entryId, callback, payload](const Buffer &name, PropertyNode &property) {
+
+                    SafeString propertyName(name.begin(), name.end());
+                    SafeString value(property.getContent().begin(), property.getContent().end());
+
+                    if (callback(entryId.c_str(), propertyName.c_str(), value.c_str(), value.size(), payload)) {
+                        throw c::StopIteration();
+                    }
+                });
+            });
+
+        } catch (c::StopIteration &) {
+            // Stopped by the caller
+        }
+
+        return KM_OK;
+    });
+}
+
+void
+km_secret_free(char *value, size_t length)
+{
+    if (!value) {
+        return;
+    }
+
+    OPENSSL_cleanse(value, length);
+    std::free(value);
+}
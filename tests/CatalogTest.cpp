@@ -0,0 +1,189 @@
+/*!
+ * Title ---- tests/CatalogTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "CatalogTest.hpp"
+
+namespace tests { // Begin test namespace
+
+std::unique_ptr<PrivateKey> CatalogTest::mPrivateKey;
+std::unique_ptr<PublicKey>  CatalogTest::mPublicKey;
+
+
+void
+CatalogTest::SetUpTestCase()
+{
+    OpenSSL_add_all_ciphers();
+
+    mPrivateKey = std::make_unique<PrivateKey>(
+        PrivateKey::fromPath("tests/fixtures/mykey", Buffer::fromString("passphrase"))
+    );
+
+    mPublicKey = std::make_unique<PublicKey>(
+        PublicKey::fromPath("tests/fixtures/mykey.pub")
+    );
+}
+
+
+TEST(BloomFilterTest, mayContain)
+{
+    auto filter = BloomFilter::create(1000);
+
+    for (int i = 0; i < 1000; ++i) {
+        filter.add(Buffer::fromString("item" + std::to_string(i)));
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(filter.mayContain(Buffer::fromString("item" + std::to_string(i))));
+    }
+
+    int falsePositives = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        falsePositives += filter.mayContain(Buffer::fromString("other" + std::to_string(i)));
+    }
+
+    ASSERT_LT(falsePositives, 50);
+}
+
+TEST(BloomFilterTest, toBuffer)
+{
+    auto filter = BloomFilter::create(10);
+    filter.add("a");
+
+    auto other = BloomFilter::fromBuffer(BloomFilter::toBuffer(filter));
+
+    ASSERT_EQ((std::size_t) BloomFilter::MIN_CAPACITY, other.getCapacity());
+    ASSERT_TRUE(other.mayContain("a"));
+    ASSERT_FALSE(other.mayContain("b"));
+}
+
+TEST_F(CatalogTest, locate)
+{
+    auto catalog = Catalog::create(*mPublicKey, *mPrivateKey);
+
+    catalog
+        .setRepository("r1", "first", 2)
+        .setEntry("r1", "e1", "mail")
+        .setEntry("r1", "e2", "")
+        .setRepository("r2", "second", 1)
+        .setEntry("r2", "e3", "bank")
+    ;
+
+    bool exact;
+
+    auto result = catalog.locate("e3", exact);
+
+    ASSERT_TRUE(exact);
+    ASSERT_EQ(std::vector<Buffer>({ "r2" }), result);
+
+    result = catalog.locate("mail", exact);
+
+    ASSERT_FALSE(exact);
+    ASSERT_EQ(std::vector<Buffer>({ "r1" }), result);
+
+    catalog.removeRepository("r1");
+
+    ASSERT_FALSE(catalog.hasRepository("r1"));
+    ASSERT_TRUE(catalog.locate("e1", exact).empty());
+}
+
+TEST_F(CatalogTest, setEntry_EntryNode)
+{
+    auto catalog = Catalog::create(*mPublicKey, *mPrivateKey);
+
+    auto entry = EntryNode::create();
+    entry.setProperty("name", "mail");
+
+    catalog
+        .setRepository("r1", "first", 1)
+        .setEntry("r1", entry)
+    ;
+
+    // A renamed entry is found by its new name
+    entry.setProperty("name", "webmail");
+    catalog.setEntry("r1", entry);
+
+    bool exact;
+
+    ASSERT_EQ(std::vector<Buffer>({ "r1" }), catalog.locate("webmail", exact));
+    ASSERT_EQ(std::vector<Buffer>({ "r1" }), catalog.locate(entry.getId(), exact));
+    ASSERT_TRUE(exact);
+}
+
+TEST_F(CatalogTest, setKeyring)
+{
+    auto catalog = Catalog::create(*mPublicKey, *mPrivateKey);
+
+    auto encrypter = Encrypter::create(
+        Encrypter::encrypt<AccessKey>(
+            AccessKey::create(Encrypter::getFingerprint(*mPublicKey), Buffer::fromRandom(32)),
+            *mPublicKey
+        ),
+        *mPrivateKey
+    );
+
+    auto entry = EntryNode::create();
+    entry.setProperty("name", "mail");
+
+    auto keyring = KeyringNode::create();
+    keyring.setProperty("name", "personal");
+    keyring.setEntry(encrypter.encrypt<EntryNode>(entry));
+
+    // The names are read from the encrypted keyring and entries
+    catalog.setKeyring("r1", encrypter.encrypt<KeyringNode>(keyring), encrypter);
+
+    catalog.eachRepository([](const Buffer &id, const Buffer &name, std::size_t numOfEntries) {
+        ASSERT_EQ(Buffer("r1"), id);
+        ASSERT_EQ(Buffer("personal"), name);
+        ASSERT_EQ(1U, numOfEntries);
+    });
+
+    bool exact;
+
+    ASSERT_EQ(std::vector<Buffer>({ "r1" }), catalog.locate("mail", exact));
+    ASSERT_EQ(std::vector<Buffer>({ "r1" }), catalog.locate(entry.getId(), exact));
+    ASSERT_TRUE(exact);
+}
+
+TEST_F(CatalogTest, toFile)
+{
+    auto path = filesystem::temp_directory_path() / filesystem::unique_path();
+
+    auto catalog = Catalog::create(*mPublicKey, *mPrivateKey);
+
+    catalog
+        .setRepository("r1", "first repository", 1)
+        .setEntry("r1", "e1", "mail")
+    ;
+
+    Catalog::toFile(path, catalog);
+
+    auto other = Catalog::fromFile(path, *mPrivateKey);
+
+    filesystem::remove(path);
+
+    std::size_t count = 0;
+
+    other.eachRepository([&count](const Buffer &id, const Buffer &name, std::size_t numOfEntries) {
+
+        ASSERT_EQ(Buffer("r1"), id);
+        ASSERT_EQ(Buffer("first repository"), name);
+        ASSERT_EQ(1u, numOfEntries);
+
+        ++count;
+    });
+
+    bool exact;
+
+    ASSERT_EQ(1u, count);
+    ASSERT_EQ(std::vector<Buffer>({ "r1" }), other.locate("mail", exact));
+}
+
+} // End of test namespace
@@ -0,0 +1,60 @@
+/*!
+ * Title ---- tests/CatalogTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_CATALOG_TEST_HPP__
+#define __KM_CATALOG_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/BloomFilter.hpp>
+#include <km/Catalog.hpp>
+#include <km/AccessKey.hpp>
+#include <km/Encrypter.hpp>
+#include <km/EntryNode.hpp>
+#include <km/KeyringNode.hpp>
+
+#include <memory>
+
+using namespace km;
+
+namespace tests { // Begin test namespace
+
+/*!
+ * The Catalog test case.
+ */
+class CatalogTest : public testing::Test
+{
+
+public:
+
+    /*!
+     * Sets up the test case.
+     */
+    static void SetUpTestCase();
+
+protected:
+
+    /*!
+     * The private key.
+     */
+    static std::unique_ptr<PrivateKey> mPrivateKey;
+
+    /*!
+     * The public key.
+     */
+    static std::unique_ptr<PublicKey> mPublicKey;
+};
+
+} // End of test namespace
+
+#endif /* __KM_CATALOG_TEST_HPP__ */
@@ -0,0 +1,153 @@
+/*!
+ * Title ---- tests/ChunkStoreTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "ChunkStoreTest.hpp"
+
+namespace tests { // Begin test namespace
+
+std::unique_ptr<Encrypter> ChunkStoreTest::mEncrypter;
+
+
+void
+ChunkStoreTest::SetUpTestCase()
+{
+    OpenSSL_add_all_ciphers();
+
+    auto privateKey = PrivateKey::fromPath("tests/fixtures/mykey", Buffer::fromString("passphrase"));
+
+    auto accessKey = AccessKey::create
+    (
+        Buffer::fromBase64<std::string>("BjwrC0p6oIoJxe3ECoJULVyi1Z9xDJReP0N4VIPAqg4="),
+        Buffer::fromBase64<std::string>
+        (
+            "H/Surhx0Coat/pzngo5TlME/TA9HvGs2C4kg82evSSkRr8VapgxWRwoGG4xFTOYl5s0gGxzONWJqc1h5DTApqS"
+            "ga7expYo9uu5zw4aPpGcBSZn2b+LKhBLX8IN+3/6416YBwSiF+wiGFM9PkXp06CrAvlhhWQEc9zdIXVG9Cm8DI"
+            "wJPC61Xj3qWg07L4EJOKl9Hx7G7lt60Gjr4OtqlOq5J3k+a5ijrbBhsJeigc/g4Gp07hcJXp7r3FD0g4ofSZsQ"
+            "cahDElHOZhptN6YjRZ/ABqxyrsh3pF7kIqMwgo0sbQ6lQsII4dIkqq2wDu4ex9Fxu3FMJWD9JXdFHjohWcFA=="
+        )
+    );
+
+    mEncrypter = std::make_unique<Encrypter>(
+        Encrypter::create(accessKey, privateKey)
+    );
+}
+
+void
+ChunkStoreTest::SetUp()
+{
+    mPath = filesystem::temp_directory_path() / filesystem::unique_path();
+
+    filesystem::create_directories(mPath);
+}
+
+void
+ChunkStoreTest::TearDown()
+{
+    filesystem::remove_all(mPath);
+}
+
+std::size_t
+ChunkStoreTest::countChunks() const
+{
+    auto path = mPath / ChunkStore::ChunkDir;
+
+    return (std::size_t) std::distance(filesystem::directory_iterator(path), filesystem::directory_iterator());
+}
+
+
+TEST_F(ChunkStoreTest, write)
+{
+    ChunkStore chunkStore(mPath, *mEncrypter);
+
+    auto content = Buffer::fromRandom(1024 * 1024).toString();
+
+    std::istringstream input(content);
+    auto manifest = chunkStore.write(input);
+
+    ASSERT_TRUE(ChunkStore::isManifest(manifest));
+    ASSERT_GE(countChunks(), 1024 * 1024 / ChunkStore::CHUNK_MAX_SIZE);
+
+    std::ostringstream output;
+    chunkStore.read(manifest, output);
+
+    ASSERT_EQ(content, output.str());
+}
+
+TEST_F(ChunkStoreTest, write_Deduplication)
+{
+    ChunkStore chunkStore(mPath, *mEncrypter);
+
+    // NOTE: a fixed content, the chunk boundaries are the same on every run
+    std::mt19937 generator(42);
+    std::string content(2 * 1024 * 1024, '\0');
+
+    for (auto &byte : content) {
+        byte = (char) generator();
+    }
+
+    std::istringstream first(content);
+    chunkStore.write(first);
+
+    auto count = countChunks();
+
+    // NOTE: an edit changes only the chunks around it
+    content.insert(content.size() / 2, "inserted");
+
+    std::istringstream second(content);
+    auto manifest = chunkStore.write(second);
+
+    ASSERT_LE(countChunks(), count + 2);
+
+    std::ostringstream output;
+    chunkStore.read(manifest, output);
+
+    ASSERT_EQ(content, output.str());
+}
+
+TEST_F(ChunkStoreTest, read_Corrupted)
+{
+    ChunkStore chunkStore(mPath, *mEncrypter);
+
+    std::istringstream input("secret file");
+    auto manifest = chunkStore.write(input);
+
+    auto path = filesystem::directory_iterator(mPath / ChunkStore::ChunkDir)->path();
+
+    {
+        filesystem::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put('\0');
+    }
+
+    std::ostringstream output;
+
+    ASSERT_THROW(chunkStore.read(manifest, output), Exception);
+}
+
+TEST_F(ChunkStoreTest, copy)
+{
+    auto targetPath = mPath / "target";
+    auto targetEncrypter = mEncrypter->rotate();
+
+    ChunkStore chunkStore(mPath, *mEncrypter);
+    ChunkStore targetChunkStore(targetPath, targetEncrypter);
+
+    auto content = Buffer::fromRandom(512 * 1024).toString();
+
+    std::istringstream input(content);
+    auto manifest = chunkStore.copy(chunkStore.write(input), targetChunkStore);
+
+    std::ostringstream output;
+    targetChunkStore.read(manifest, output);
+
+    ASSERT_EQ(content, output.str());
+}
+
+} // End of test namespace
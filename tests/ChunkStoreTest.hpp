@@ -0,0 +1,76 @@
+/*!
+ * Title ---- tests/ChunkStoreTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_CHUNK_STORE_TEST_HPP__
+#define __KM_CHUNK_STORE_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/Encrypter.hpp>
+#include <km/ChunkStore.hpp>
+
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+
+using namespace km;
+
+namespace tests { // Begin test namespace
+
+/*!
+ * The ChunkStore test case.
+ */
+class ChunkStoreTest : public testing::Test
+{
+
+public:
+
+    /*!
+     * Sets up the test case.
+     */
+    static void SetUpTestCase();
+
+protected:
+
+    /*!
+     * Sets up a test.
+     */
+    virtual void SetUp() override;
+
+    /*!
+     * Cleans up a test.
+     */
+    virtual void TearDown() override;
+
+    /*!
+     * Returns the number of stored chunks.
+     */
+    std::size_t countChunks() const;
+
+
+    /*!
+     * The encrypter.
+     */
+    static std::unique_ptr<Encrypter> mEncrypter;
+
+    /*!
+     * The path to the repository.
+     */
+    filesystem::path mPath;
+};
+
+} // End of test namespace
+
+#endif /* __KM_CHUNK_STORE_TEST_HPP__ */
@@ -34,6 +34,21 @@ CoreTest::TearDownTestCase()
     Console::setDebug(true);
 }
 
+std::map<Buffer, std::map<Buffer, Buffer>>
+CoreTest::readEntries(Core &app)
+{
+    std::map<Buffer, std::map<Buffer, Buffer>> entries;
+
+    app.eachRepositoryEntry([&entries](const Buffer &id, EntryNode &entry) {
+
+        entry.eachProperty([&entries, &id](const Buffer &name, const PropertyNode &property) {
+            entries[id][name] = property.getContent();
+        });
+    });
+
+    return entries;
+}
+
 
 TEST_F(CoreTest, authenticate)
 {
@@ -56,6 +71,7 @@ TEST_F(CoreTest, createRepository)
         app
             .authenticate(mPassphrase)
             .createRepository(repositoryName)
+            .flush()
         ;
     });
 }
@@ -83,6 +99,7 @@ TEST_F(CoreTest, shareRepository)
             .authenticate(mPassphrase)
             .openRepository(mRepositoryId)
             .shareRepository(mUserId)
+            .flush()
         ;
     });
 }
@@ -149,6 +166,7 @@ TEST_F(CoreTest, pushRepository)
             .authenticate(mPassphrase)
             .openRepository(mRepositoryId)
             .pushRepository()
+            .flush()
         ;
     });
 }
@@ -167,6 +185,60 @@ TEST_F(CoreTest, fetchRepository)
     });
 }
 
+TEST_F(CoreTest, compactRepository)
+{
+    auto &app = Core::get();
+
+    app
+        .authenticate(mPassphrase)
+        .openRepository(mRepositoryId)
+    ;
+
+    auto limit = std::time(nullptr) - (std::time_t) app.getHistoryRetention() * 24 * 60 * 60;
+
+    // The history is walked from the newest commit
+    std::vector<Buffer> summaries, recentSummaries;
+    std::size_t numOfExpired = 0;
+
+    app.eachRepositoryLogs("HEAD", [&](const Buffer &id, const Commit &commit) {
+
+        // NOTE: the commit time is the local time of the author
+        std::tm time = *commit.getTime();
+
+        if (timegm(&time) - commit.getTime()->tm_gmtoff < limit) {
+            numOfExpired++;
+
+        } else if (numOfExpired == 0) {
+            recentSummaries.push_back(commit.getSummary());
+        }
+
+        summaries.push_back(commit.getSummary());
+    });
+
+    auto entries = readEntries(app);
+
+    ASSERT_NO_THROW(app.compactRepository(app.getHistoryRetention()));
+
+    // The expired commits are squashed only if there are at least two of them
+    if (numOfExpired > 1) {
+        summaries = recentSummaries;
+        summaries.push_back(Buffer::fromString("Compacted history"));
+    }
+
+    std::vector<Buffer> result;
+
+    app.eachRepositoryLogs("HEAD", [&result](const Buffer &id, const Commit &commit) {
+        result.push_back(commit.getSummary());
+    });
+
+    ASSERT_EQ(summaries, result);
+
+    // The snapshot holds the same tree of the head
+    app.openRepository(mRepositoryId);
+
+    ASSERT_EQ(entries, readEntries(app));
+}
+
 TEST_F(CoreTest, logRepository)
 {
     auto &app = Core::get();
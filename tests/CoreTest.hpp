@@ -17,7 +17,12 @@
 #include <km/Exception.hpp>
 #include <km/Console.hpp>
 #include <km/Core.hpp>
+#include <km/Commit.hpp>
+#include <km/EntryNode.hpp>
 
+#include <map>
+#include <ctime>
+#include <vector>
 #include <memory>
 
 using namespace km;
@@ -44,6 +49,12 @@ public:
 
 protected:
 
+    /*!
+     * Reads the properties of the entries of the open repository.
+     */
+    static std::map<Buffer, std::map<Buffer, Buffer>> readEntries(Core &app);
+
+
     /*!
      * The user ID.
      */
@@ -67,6 +67,14 @@ TEST_F(EncrypterTest, getFingerprint)
     ASSERT_EQ(expected, result);
 }
 
+TEST_F(EncrypterTest, getFingerprint_PrivateKey)
+{
+    auto result = Encrypter::getFingerprint(*mPrivateKey);
+
+    ASSERT_EQ(Encrypter::getFingerprint(*mPublicKey), result);
+    ASSERT_EQ(result, Encrypter::getFingerprint(PublicKey::fromPrivateKey(*mPrivateKey)));
+}
+
 TEST_F(EncrypterTest, encrypt_AccessKey)
 {
     auto accessKey = AccessKey::create
@@ -84,6 +92,91 @@ TEST_F(EncrypterTest, encrypt_AccessKey)
     ASSERT_EQ(accessKey.getData(), result.getData());
 }
 
+TEST_F(EncrypterTest, encrypt_AccessKey_X25519)
+{
+    auto privateKey = PrivateKey::fromPath("tests/fixtures/mykey-x25519", Buffer::fromString("passphrase"));
+    auto publicKey  = PublicKey::fromPath("tests/fixtures/mykey-x25519.pub");
+
+    ASSERT_EQ(RsaKey::ALGORITHM_X25519, publicKey.getAlgorithm());
+    ASSERT_EQ(Encrypter::getFingerprint(privateKey), Encrypter::getFingerprint(publicKey));
+
+    auto accessKey = AccessKey::create(Encrypter::getFingerprint(publicKey), Buffer::fromRandom(32));
+
+    auto wrapped = Encrypter::encrypt<AccessKey>(accessKey, publicKey);
+
+    ASSERT_EQ(RsaKey::ALGORITHM_X25519, wrapped.getAlgorithm());
+    ASSERT_EQ(accessKey.getData(), Encrypter::decrypt<AccessKey>(wrapped, privateKey).getData());
+
+    // The RSA key can't unwrap it
+    ASSERT_THROW(Encrypter::decrypt<AccessKey>(wrapped, *mPrivateKey), Exception);
+
+    // The recipient is authenticated
+    wrapped.setRecipient(Encrypter::getFingerprint(*mPublicKey));
+
+    ASSERT_THROW(Encrypter::decrypt<AccessKey>(wrapped, privateKey), Exception);
+}
+
+TEST_F(EncrypterTest, encrypt_AccessKey_Group)
+{
+    auto groupId   = Buffer::fromString("group");
+    auto accessKey = AccessKey::create(Encrypter::getGroupFingerprint(groupId), Buffer::fromRandom(32));
+
+    // NOTE: the encrypter of the test plays the group
+    auto wrapped = mEncrypter->encrypt<AccessKey>(accessKey);
+
+    ASSERT_EQ(RsaKey::ALGORITHM_GROUP, wrapped.getAlgorithm());
+    ASSERT_NE(accessKey.getData(), wrapped.getData());
+
+    // The algorithm is stored with the key
+    auto config = AccessKey::toConfig(wrapped);
+    auto loaded = AccessKey::fromConfig(config);
+
+    ASSERT_EQ(RsaKey::ALGORITHM_GROUP, loaded.getAlgorithm());
+
+    auto encrypter = Encrypter::create(loaded, *mEncrypter);
+
+    ASSERT_EQ(accessKey.getData(), encrypter.getAccessKey().getData());
+
+    // The recipient is authenticated
+    loaded.setRecipient(Encrypter::getGroupFingerprint(Buffer::fromString("other")));
+
+    ASSERT_THROW(Encrypter::create(loaded, *mEncrypter), Exception);
+
+    // The RSA key can't unwrap it
+    ASSERT_THROW(Encrypter::decrypt<AccessKey>(wrapped, *mPrivateKey), Exception);
+}
+
+TEST_F(EncrypterTest, getFingerprint_SigningKeys)
+{
+    struct { const char *path; RsaKey::Algorithm algorithm; } keys[] = {
+        { "tests/fixtures/mykey-ed25519", RsaKey::ALGORITHM_ED25519 },
+        { "tests/fixtures/mykey-ecdsa",   RsaKey::ALGORITHM_ECDSA   }
+    };
+
+    for (auto &key : keys) {
+
+        auto privateKey = PrivateKey::fromPath(key.path, Buffer::fromString("passphrase"));
+        auto publicKey  = PublicKey::fromPath(std::string(key.path) + ".pub");
+
+        ASSERT_EQ(key.algorithm, privateKey.getAlgorithm());
+        ASSERT_EQ(key.algorithm, publicKey.getAlgorithm());
+        ASSERT_FALSE(publicKey.canWrap());
+
+        ASSERT_EQ(Encrypter::getFingerprint(privateKey), Encrypter::getFingerprint(publicKey));
+        ASSERT_EQ(Encrypter::getFingerprint(publicKey), Encrypter::getFingerprint(PublicKey::fromPrivateKey(privateKey)));
+
+        // The PKCS#8 key is loaded back as it is
+        auto reloaded = PrivateKey::fromMemory(privateKey.getPkcsKey(), Buffer());
+
+        ASSERT_EQ(Encrypter::getFingerprint(privateKey), Encrypter::getFingerprint(reloaded));
+
+        // The access keys can't be wrapped for a signing key
+        auto accessKey = AccessKey::create(Encrypter::getFingerprint(publicKey), Buffer::fromRandom(32));
+
+        ASSERT_THROW(Encrypter::encrypt<AccessKey>(accessKey, publicKey), Exception);
+    }
+}
+
 TEST_F(EncrypterTest, encrypt_Buffer)
 {
     auto data = Buffer::fromString("abcde");
@@ -126,6 +219,311 @@ TEST_F(EncrypterTest, encrypt_PropertyNode)
     ASSERT_EQ(property.getContent(), result.getContent());
 }
 
+TEST_F(EncrypterTest, encrypt_PropertyNode_Padding)
+{
+    auto property = PropertyNode::create
+    (
+        Buffer::fromString("name"),
+        Buffer::fromArray((std::uint8_t *) "value\0\0", 7)
+    );
+
+    auto encrypted = mEncrypter->encrypt<PropertyNode>(property);
+
+    // The short values share the smallest size class
+    ASSERT_EQ(Encrypter::getPaddingSize(), encrypted.getName().size());
+    ASSERT_EQ(Encrypter::getPaddingSize(), encrypted.getContent().size());
+
+    ASSERT_EQ(property.getContent(), mEncrypter->decrypt<PropertyNode>(encrypted).getContent());
+
+    // The long values take the next classes (instead of overflowing)
+    auto value = Buffer::fromRandom(200);
+
+    encrypted = mEncrypter->encrypt<PropertyNode>(PropertyNode::create(Buffer::fromString("name"), value));
+
+    ASSERT_EQ(256U, encrypted.getContent().size());
+    ASSERT_EQ(value, mEncrypter->decrypt<PropertyNode>(encrypted).getContent());
+
+    ASSERT_THROW(Encrypter::setPaddingSize(48), Exception);
+    ASSERT_THROW(Encrypter::setPaddingSize(8),  Exception);
+}
+
+TEST_F(EncrypterTest, encrypt_PropertyNode_Compression)
+{
+    std::string text;
+
+    for (int i = 0; i < 100; ++i) {
+        text += "-----BEGIN CERTIFICATE-----\n";
+    }
+
+    auto property = PropertyNode::create(Buffer::fromString("name"), Buffer::fromString(text));
+
+    auto encrypted = mEncrypter->encrypt<PropertyNode>(property);
+
+    ASSERT_TRUE(encrypted.isCompressed());
+    ASSERT_LT(encrypted.getContent().size(), property.getContent().size());
+
+    // The flag is stored with the node
+    auto config = PropertyNode::toConfig(encrypted);
+    auto loaded = PropertyNode::fromConfig(config);
+
+    ASSERT_TRUE(loaded.isCompressed());
+    ASSERT_EQ(property.getContent(), mEncrypter->decrypt<PropertyNode>(loaded).getContent());
+
+    // The incompressible values are stored as they are
+    auto random = PropertyNode::create(Buffer::fromString("name"), Buffer::fromRandom(1000));
+
+    encrypted = mEncrypter->encrypt<PropertyNode>(random);
+
+    ASSERT_FALSE(encrypted.isCompressed());
+    ASSERT_EQ(random.getContent(), mEncrypter->decrypt<PropertyNode>(encrypted).getContent());
+}
+
+TEST_F(EncrypterTest, encrypt_PropertyNode_Attachment)
+{
+    auto manifest = PropertyNode::create(Buffer::fromString("file"), Buffer::fromString(ChunkStore::ManifestHeader + "0\n"));
+
+    // A value starting with the header of the manifests is not an attachment
+    auto encrypted = mEncrypter->encrypt<PropertyNode>(manifest);
+
+    ASSERT_FALSE(encrypted.isAttachment());
+    ASSERT_FALSE(mEncrypter->decrypt<PropertyNode>(encrypted).isAttachment());
+
+    // The flag is stored with the node
+    encrypted = mEncrypter->encrypt<PropertyNode>(manifest.setAttachment(true));
+
+    auto config = PropertyNode::toConfig(encrypted);
+    auto loaded = PropertyNode::fromConfig(config);
+
+    ASSERT_TRUE(loaded.isAttachment());
+    ASSERT_TRUE(mEncrypter->decrypt<PropertyNode>(loaded).isAttachment());
+
+    // The unchanged values are re-encrypted when the flag changes
+    auto previous = EntryNode::create().setProperty(manifest.getName(), encrypted);
+    auto entry    = EntryNode::create().setProperty(manifest.getName(), manifest.getContent());
+
+    mEncrypter->reencrypt(entry, previous).eachProperty([](const Buffer &name, const PropertyNode &property) {
+        ASSERT_FALSE(property.isAttachment());
+    });
+}
+
+TEST_F(EncrypterTest, decrypt_PropertyNode_CompressionLimit)
+{
+    auto nonce = Buffer::fromRandom(Encrypter::ENCRYPT_IV_LENGTH);
+
+    // A few kilobytes inflating past the limit (deflated a block at a time)
+    Buffer block(64 * 1024, 'a');
+    Buffer bomb(1024 * 1024);
+
+    z_stream stream = {};
+    ASSERT_EQ(Z_OK, deflateInit(&stream, Z_BEST_COMPRESSION));
+
+    stream.next_out  = bomb.data();
+    stream.avail_out = (uInt) bomb.size();
+
+    for (std::size_t size = 0; size <= Encrypter::COMPRESSION_LIMIT; size += block.size()) {
+
+        stream.next_in  = block.data();
+        stream.avail_in = (uInt) block.size();
+
+        ASSERT_EQ(Z_OK, deflate(&stream, Z_NO_FLUSH));
+    }
+
+    ASSERT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+
+    bomb.resize((std::size_t) stream.total_out);
+    deflateEnd(&stream);
+
+    // The smallest size class holding the value and the marker
+    auto pad = [](const Buffer &buffer) {
+
+        std::size_t size = Encrypter::PADDING_SIZE;
+
+        while (size < buffer.size() + 2) {
+            size <<= 1;
+        }
+
+        Buffer output(size - 1);
+
+        std::copy(buffer.begin(), buffer.end(), output.begin());
+        output[buffer.size()] = Encrypter::PADDING_MARKER;
+
+        return output;
+    };
+
+    auto encrypted = PropertyNode::create
+    (
+        mEncrypter->encrypt(pad(Buffer::fromString("name")), nonce),
+        mEncrypter->encrypt(pad(bomb), nonce),
+        nonce
+    );
+
+    encrypted.setCompressed(true);
+
+    ASSERT_THROW(mEncrypter->decrypt<PropertyNode>(encrypted), Exception);
+}
+
+TEST_F(EncrypterTest, decrypt_PropertyNode_LegacyPadding)
+{
+    auto nonce = Buffer::fromRandom(Encrypter::ENCRYPT_IV_LENGTH);
+
+    // The fixed size blocks (128 bytes, a divisor and random bytes)
+    auto pad = [](const Buffer &buffer) {
+
+        auto output = Buffer::fromRandom(128 + 1);
+
+        std::copy(buffer.begin(), buffer.end(), output.begin());
+        output[buffer.size()] = Encrypter::PADDING_DIVISOR;
+
+        return output;
+    };
+
+    auto encrypted = PropertyNode::create
+    (
+        mEncrypter->encrypt(pad(Buffer::fromString("name")),  nonce),
+        mEncrypter->encrypt(pad(Buffer::fromString("value")), nonce),
+        nonce
+    );
+
+    auto result = mEncrypter->decrypt<PropertyNode>(encrypted);
+
+    ASSERT_EQ(Buffer::fromString("name"),  result.getName());
+    ASSERT_EQ(Buffer::fromString("value"), result.getContent());
+}
+
+TEST_F(EncrypterTest, reencrypt_EntryNode)
+{
+    auto entry = EntryNode::create();
+
+    entry
+        .setProperty("name",     "mail")
+        .setProperty("password", "first")
+    ;
+
+    auto previous = mEncrypter->encrypt<EntryNode>(entry);
+
+    auto modified = mEncrypter->decrypt<EntryNode>(previous);
+    modified.setProperty("password", "second");
+
+    auto current = mEncrypter->reencrypt(modified, previous);
+
+    std::size_t kept = 0;
+
+    current.eachProperty([&previous, &kept](const Buffer &key, const PropertyNode &property) {
+
+        try {
+            kept += previous.getProperty(key).getContent() == property.getContent();
+
+        } catch (PropertyNotFoundException &e) {
+            // Re-encrypted property
+        }
+    });
+
+    // Only the modified property gets a new ciphertext
+    ASSERT_EQ(1U, kept);
+
+    auto result = mEncrypter->decrypt<EntryNode>(current);
+
+    ASSERT_EQ(Buffer("mail"),   result.getProperty("name").getContent());
+    ASSERT_EQ(Buffer("second"), result.getProperty("password").getContent());
+}
+
+TEST_F(EncrypterTest, decryptProperty)
+{
+    auto entry = EntryNode::create();
+
+    entry
+        .setProperty("name",     "mail")
+        .setProperty("password", "secret")
+    ;
+
+    auto encrypted = mEncrypter->encrypt<EntryNode>(entry);
+
+    // The encrypted properties are keyed by their encrypted names
+    ASSERT_THROW(encrypted.getProperty("name"), PropertyNotFoundException);
+
+    ASSERT_EQ(Buffer("mail"),   mEncrypter->decryptProperty(encrypted, "name").getContent());
+    ASSERT_EQ(Buffer("secret"), mEncrypter->decryptProperty(encrypted, "password").getContent());
+
+    ASSERT_THROW(mEncrypter->decryptProperty(encrypted, "username"), PropertyNotFoundException);
+}
+
+TEST_F(EncrypterTest, rotate)
+{
+    auto property = PropertyNode::create
+    (
+        Buffer::fromString("name"),
+        Buffer::fromString("value")
+    );
+
+    auto previous = mEncrypter->encrypt<PropertyNode>(property);
+
+    auto rotated = mEncrypter->rotate();
+
+    ASSERT_EQ(1U, rotated.getAccessKey().getVersion());
+    ASSERT_NE(mEncrypter->getAccessKey().getData(), rotated.getAccessKey().getData());
+
+    auto current = rotated.encrypt<PropertyNode>(property);
+
+    ASSERT_EQ(1U, current.getKeyVersion());
+    ASSERT_THROW(mEncrypter->decrypt<PropertyNode>(current), Exception);
+
+    // The nodes not re-encrypted yet are read by the previous key
+    ASSERT_EQ(property.getContent(), rotated.decrypt<PropertyNode>(previous).getContent());
+
+    auto wrapped = Encrypter::encrypt<AccessKey>
+    (
+        AccessKey::create(Encrypter::getFingerprint(*mPublicKey), rotated.getAccessKey().getData()).setVersion(1),
+        *mPublicKey
+    );
+
+    auto loaded = Encrypter::create(wrapped, *mPrivateKey);
+
+    ASSERT_EQ(1U, loaded.getAccessKey().getVersion());
+    ASSERT_THROW(loaded.decrypt<PropertyNode>(previous), Exception);
+
+    loaded.setKeyHistory(rotated.getKeyHistory());
+
+    ASSERT_EQ(property.getContent(), loaded.decrypt<PropertyNode>(previous).getContent());
+
+    auto text = TextNode::fromBuffer(
+        rotated.encrypt<TextNode>(TextNode::create(Buffer::fromString("abcde"))).toBuffer()
+    );
+
+    ASSERT_EQ(1U, text.getKeyVersion());
+    ASSERT_EQ(Buffer::fromString("abcde"), loaded.decrypt<TextNode>(text).getContent());
+}
+
+TEST_F(EncrypterTest, seal)
+{
+    auto tree = MerkleTree::create();
+
+    tree.setLeaf("a", MerkleTree::hash("a"));
+    tree.setLeaf("b", MerkleTree::hash("b"));
+
+    ASSERT_FALSE(mEncrypter->isSealed(tree));
+
+    mEncrypter->seal(tree);
+    ASSERT_TRUE(mEncrypter->isSealed(tree));
+
+    auto loaded = MerkleTree::fromBuffer(MerkleTree::toBuffer(tree));
+    ASSERT_TRUE(mEncrypter->isSealed(loaded));
+
+    // The unchanged leaves keep the seal
+    loaded.setLeaf("a", MerkleTree::hash("a"));
+    ASSERT_TRUE(mEncrypter->isSealed(loaded));
+
+    // A tree rebuilt without the access key is rejected
+    auto forged = MerkleTree::fromBuffer(MerkleTree::toBuffer(tree));
+    forged.setLeaf("b", MerkleTree::hash("c"));
+    forged.setSeal(tree.getSeal(), tree.getSealVersion());
+
+    ASSERT_FALSE(mEncrypter->isSealed(forged));
+
+    // The trees sealed by a previous key are still checked after a rotation
+    auto rotated = mEncrypter->rotate();
+    ASSERT_TRUE(rotated.isSealed(loaded));
+}
+
 // TODO: add the `*crypt_KeyringNode` tests
 
 } // End of test namespace
\ No newline at end of file
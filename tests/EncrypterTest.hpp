@@ -16,6 +16,7 @@
 #include <km.hpp>
 #include <km/Exception.hpp>
 #include <km/Encrypter.hpp>
+#include <km/ChunkStore.hpp>
 
 #include <memory>
 
@@ -0,0 +1,97 @@
+/*!
+ * Title ---- tests/JsonReaderTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "JsonReaderTest.hpp"
+
+namespace tests { // Begin test namespace
+
+static std::map<std::string, std::string>
+parse(const std::string &input, std::size_t chunkSize)
+{
+    std::map<std::string, std::string> values;
+
+    JsonReader reader([&values](const JsonReader::Path &path, const std::string &value) {
+
+        std::string key;
+
+        for (auto &name : path) {
+            key += "/" + name;
+        }
+
+        values[key] = value;
+    });
+
+    for (std::size_t i = 0; i < input.size(); i += chunkSize) {
+        reader.feed(input.substr(i, chunkSize));
+    }
+
+    reader.finish();
+
+    return values;
+}
+
+TEST(JsonReaderTest, parse_paths)
+{
+    std::string input = R"({"status": 200, "content": [{"id": "a"}, {"id": "b", "tags": []}], "more": {}})";
+
+    auto values = parse(input, input.size());
+
+    ASSERT_EQ(3u, values.size());
+    ASSERT_EQ("200", values["/status"]);
+    ASSERT_EQ("a", values["/content/0/id"]);
+    ASSERT_EQ("b", values["/content/1/id"]);
+}
+
+TEST(JsonReaderTest, parse_chunks)
+{
+    std::string input = R"({"key": "va\"lue\u00e8\ud83d\ude00", "list": [true, false, null, -1.5e3]})";
+
+    for (std::size_t chunkSize = 1; chunkSize < 8; ++chunkSize) {
+
+        auto values = parse(input, chunkSize);
+
+        ASSERT_EQ("va\"lue\xc3\xa8\xf0\x9f\x98\x80", values["/key"]);
+        ASSERT_EQ("true",    values["/list/0"]);
+        ASSERT_EQ("false",   values["/list/1"]);
+        ASSERT_EQ("null",    values["/list/2"]);
+        ASSERT_EQ("-1.5e3",  values["/list/3"]);
+    }
+}
+
+TEST(JsonReaderTest, parse_scalar)
+{
+    auto values = parse("42", 1);
+
+    ASSERT_EQ("42", values[""]);
+}
+
+TEST(JsonReaderTest, parse_invalid)
+{
+    ASSERT_THROW(parse(R"({"a": 1,})", 1), Exception);
+    ASSERT_THROW(parse(R"([1, 2)", 1), Exception);
+    ASSERT_THROW(parse(R"({"a" 1})", 1), Exception);
+    ASSERT_THROW(parse(R"([1] 2)", 1), Exception);
+    ASSERT_THROW(parse(R"([tru])", 1), Exception);
+    ASSERT_THROW(parse(R"(["a\x"])", 1), Exception);
+    ASSERT_THROW(parse(R"({"a": [}])", 1), Exception);
+}
+
+TEST(JsonReaderTest, parse_number)
+{
+    for (auto number : { "0", "-0", "7", "-12", "0.5", "-1.25", "1e3", "1E+3", "2.5e-10" }) {
+        ASSERT_EQ(number, parse(number, 1)[""]);
+    }
+
+    for (auto number : { "nan", "-inf", "inf", "0x10", "1e", "1e+", "007", "-", "1.", ".5", "+1", "-.5", "1.e3", "01.5" }) {
+        ASSERT_THROW(parse(std::string("[") + number + "]", 1), Exception) << number;
+    }
+}
+
+} // End of test namespace
@@ -0,0 +1,233 @@
+/*!
+ * Title ---- tests/KeyringNodeTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "KeyringNodeTest.hpp"
+
+namespace tests { // Begin test namespace
+
+void
+KeyringNodeTest::SetUp()
+{
+    mPath = filesystem::temp_directory_path() / filesystem::unique_path();
+
+    filesystem::create_directories(mPath / KeyringNode::EntryDir);
+}
+
+void
+KeyringNodeTest::TearDown()
+{
+    filesystem::remove_all(mPath);
+}
+
+
+TEST_F(KeyringNodeTest, save_AccessKeys)
+{
+    auto keyring = KeyringNode::create();
+    keyring.setProperty("name", "keyring");
+
+    keyring
+        .addAccessKey(AccessKey::create("alice", "first key"))
+        .addAccessKey(AccessKey::create("bob",   "second key"))
+        .save(mPath)
+    ;
+
+    ASSERT_TRUE(filesystem::exists(mPath / KeyringNode::AccessDir / KeyringNode::ManifestFile));
+    ASSERT_TRUE(filesystem::exists(mPath / KeyringNode::AccessDir / Buffer("alice").toHex<std::string>()));
+
+    auto other = KeyringNode::fromPath(mPath);
+
+    ASSERT_FALSE(other.isLegacy());
+    ASSERT_EQ(2u, other.getRecipients().size());
+    ASSERT_TRUE(other.hasAccessKey("bob"));
+    ASSERT_FALSE(other.hasAccessKey("carol"));
+
+    // Only the requested file is read
+    filesystem::remove(mPath / KeyringNode::AccessDir / Buffer("alice").toHex<std::string>());
+
+    ASSERT_EQ(Buffer("second key"), other.getAccessKey("bob").getData());
+    ASSERT_THROW(other.getAccessKey("alice"), std::exception);
+    ASSERT_THROW(other.getAccessKey("carol"), Exception);
+}
+
+TEST_F(KeyringNodeTest, upgrade)
+{
+    // A keyring storing the access keys in its configuration
+    {
+        auto keyring = KeyringNode::create();
+        keyring.setProperty("name", "keyring");
+        keyring.save(mPath);
+
+        property_tree::ptree config;
+        property_tree::read_xml((mPath / KeyringNode::ConfigFile).string(), config);
+
+        config.add_child("keymaker.accessKeys.entry", AccessKey::toConfig(AccessKey::create("alice", "first key")));
+
+        property_tree::write_xml((mPath / KeyringNode::ConfigFile).string(), config);
+
+        filesystem::remove_all(mPath / KeyringNode::AccessDir);
+    }
+
+    auto keyring = KeyringNode::fromPath(mPath);
+
+    ASSERT_TRUE(keyring.isLegacy());
+    ASSERT_EQ(Buffer("first key"), keyring.getAccessKey("alice").getData());
+
+    // Still stored in the configuration until upgraded
+    keyring.save(mPath);
+
+    ASSERT_FALSE(filesystem::exists(mPath / KeyringNode::AccessDir));
+
+    keyring
+        .upgrade()
+        .addAccessKey(AccessKey::create("bob", "second key"))
+        .save(mPath)
+    ;
+
+    auto other = KeyringNode::fromPath(mPath);
+
+    ASSERT_FALSE(other.isLegacy());
+    ASSERT_EQ(Buffer("first key"),  other.getAccessKey("alice").getData());
+    ASSERT_EQ(Buffer("second key"), other.getAccessKey("bob").getData());
+}
+
+TEST_F(KeyringNodeTest, save_KeyHistory)
+{
+    auto keyring = KeyringNode::create();
+    keyring.setProperty("name", "keyring");
+
+    keyring
+        .addAccessKey(AccessKey::create("alice", "first key"))
+        .addAccessKey(AccessKey::create("bob",   "first key"))
+        .save(mPath)
+    ;
+
+    auto rotated = KeyringNode::fromPath(mPath);
+
+    AccessKeyMap accessKeys;
+    accessKeys["alice"] = AccessKey::create("alice", "second key").setVersion(1);
+
+    rotated
+        .setAccessKeys(accessKeys)
+        .setKeyHistory({ PropertyNode::create("0", "first key").setKeyVersion(1) })
+        .save(mPath)
+    ;
+
+    // The access key of the removed recipient is dropped
+    ASSERT_FALSE(filesystem::exists(mPath / KeyringNode::AccessDir / Buffer("bob").toHex<std::string>()));
+
+    auto other = KeyringNode::fromPath(mPath);
+
+    ASSERT_EQ(1u, other.getRecipients().size());
+    ASSERT_EQ(1u, other.getAccessKey("alice").getVersion());
+    ASSERT_EQ(1u, other.getKeyHistory().size());
+    ASSERT_EQ(1u, other.getKeyHistory().front().getKeyVersion());
+    ASSERT_EQ(Buffer("first key"), other.getKeyHistory().front().getContent());
+}
+
+TEST_F(KeyringNodeTest, save_Entries)
+{
+    auto keyring = KeyringNode::create();
+    keyring.setProperty("name", "keyring");
+
+    auto first  = EntryNode::create();
+    auto second = EntryNode::create();
+
+    first.setProperty("name",  "first");
+    second.setProperty("name", "second");
+
+    keyring
+        .setEntry(first)
+        .save(mPath)
+    ;
+
+    auto other = KeyringNode::fromPath(mPath);
+
+    ASSERT_TRUE(other.hasEntry(first.getId()));
+    ASSERT_FALSE(other.hasEntry(second.getId()));
+
+    // In place, only the new entries are written
+    filesystem::remove(mPath / KeyringNode::EntryDir / first.getId().toString());
+
+    other
+        .setEntry(second)
+        .save(mPath)
+    ;
+
+    ASSERT_FALSE(filesystem::exists(mPath / KeyringNode::EntryDir / first.getId().toString()));
+    ASSERT_TRUE(filesystem::exists(mPath / KeyringNode::EntryDir / second.getId().toString()));
+}
+
+TEST_F(KeyringNodeTest, reloadEntry)
+{
+    auto keyring = KeyringNode::create();
+    keyring.setProperty("name", "keyring");
+
+    auto first  = EntryNode::create();
+    auto second = EntryNode::create();
+
+    first.setProperty("name",  "first");
+    second.setProperty("name", "second");
+
+    keyring
+        .setEntry(first)
+        .setEntry(second)
+        .save(mPath)
+    ;
+
+    auto other = KeyringNode::fromPath(mPath);
+
+    first.setProperty("name", "renamed");
+
+    keyring
+        .setEntry(first)
+        .save(mPath)
+    ;
+
+    // Only the changed entry is read again
+    filesystem::ofstream(mPath / KeyringNode::EntryDir / second.getId().toString()) << "corrupted";
+
+    other.reloadEntry(first.getId());
+
+    ASSERT_EQ(Buffer("renamed"), other.getEntry(first.getId()).getProperty("name").getContent());
+    ASSERT_EQ(Buffer("second"),  other.getEntry(second.getId()).getProperty("name").getContent());
+
+    ASSERT_EQ(keyring.getMerkleTree().getRoot(), other.getMerkleTree().getRoot());
+}
+
+TEST_F(KeyringNodeTest, removeEntry)
+{
+    auto keyring = KeyringNode::create();
+    keyring.setProperty("name", "keyring");
+
+    auto first  = EntryNode::create();
+    auto second = EntryNode::create();
+
+    first.setProperty("name",  "first");
+    second.setProperty("name", "second");
+
+    keyring
+        .setEntry(first)
+        .setEntry(second)
+        .save(mPath)
+    ;
+
+    auto other = KeyringNode::fromPath(mPath);
+
+    filesystem::remove(mPath / KeyringNode::EntryDir / second.getId().toString());
+
+    other.removeEntry(second.getId());
+
+    // The removed entry disappears, with its leaf
+    ASSERT_TRUE(other.hasEntry(first.getId()));
+    ASSERT_FALSE(other.hasEntry(second.getId()));
+    ASSERT_FALSE(other.getMerkleTree().hasLeaf(second.getId()));
+}
+
+} // End of test namespace
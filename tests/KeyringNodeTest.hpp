@@ -0,0 +1,55 @@
+/*!
+ * Title ---- tests/KeyringNodeTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_KEYRING_NODE_TEST_HPP__
+#define __KM_KEYRING_NODE_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/AccessKey.hpp>
+#include <km/KeyringNode.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+using namespace km;
+
+namespace tests { // Begin test namespace
+
+/*!
+ * The KeyringNode test case.
+ */
+class KeyringNodeTest : public testing::Test
+{
+
+protected:
+
+    /*!
+     * Creates the keyring directory.
+     */
+    virtual void SetUp() override;
+
+    /*!
+     * Removes the keyring directory.
+     */
+    virtual void TearDown() override;
+
+    /*!
+     * The keyring directory.
+     */
+    filesystem::path mPath;
+};
+
+} // End of test namespace
+
+#endif /* __KM_KEYRING_NODE_TEST_HPP__ */
@@ -0,0 +1,120 @@
+/*!
+ * Title ---- tests/LibkmTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "LibkmTest.hpp"
+
+namespace tests { // Begin test namespace
+
+void
+LibkmTest::SetUp()
+{
+    mSession = km_session_open();
+
+    ASSERT_NE(nullptr, mSession);
+}
+
+void
+LibkmTest::TearDown()
+{
+    km_session_close(mSession);
+}
+
+
+TEST(LibkmSessionTest, invalidSession)
+{
+    ASSERT_EQ(KM_ABI_VERSION, km_abi_version());
+
+    ASSERT_EQ(KM_ERROR, km_authenticate(nullptr, "passphrase", 10));
+    ASSERT_EQ(KM_ERROR, km_repository_open(nullptr, "repository"));
+    ASSERT_STREQ("Invalid session", km_last_error(nullptr));
+}
+
+TEST_F(LibkmTest, session_open_Twice)
+{
+    // The core state is process-wide
+    ASSERT_EQ(nullptr, km_session_open());
+
+    km_session_close(mSession);
+
+    mSession = km_session_open();
+    ASSERT_NE(nullptr, mSession);
+}
+
+TEST_F(LibkmTest, entry_get_NoRepository)
+{
+    char *value = nullptr;
+    std::size_t length = 0;
+
+    ASSERT_EQ(KM_ERROR, km_entry_get(mSession, "entry", "password", &value, &length));
+    ASSERT_NE(std::string::npos, std::string(km_last_error(mSession)).find("No repository open"));
+    ASSERT_EQ(nullptr, value);
+
+    km_iterator *iterator = nullptr;
+
+    ASSERT_EQ(KM_ERROR, km_entry_list(mSession, &iterator));
+    ASSERT_EQ(nullptr, iterator);
+
+    auto callback = [](const char *, const char *, const char *, std::size_t, void *) {
+        return 0;
+    };
+
+    ASSERT_EQ(KM_ERROR, km_each_property(mSession, callback, nullptr));
+    ASSERT_NE(std::string::npos, std::string(km_last_error(mSession)).find("No repository open"));
+}
+
+TEST_F(LibkmTest, entry_list_FailedOpen)
+{
+    ASSERT_EQ(KM_ERROR, km_repository_open(mSession, "00000000-0000-0000-0000-000000000000"));
+
+    km_iterator *iterator = nullptr;
+
+    ASSERT_EQ(KM_ERROR, km_entry_list(mSession, &iterator));
+    ASSERT_NE(std::string::npos, std::string(km_last_error(mSession)).find("No repository open"));
+}
+
+TEST_F(LibkmTest, nullArguments)
+{
+    char *value = nullptr;
+    std::size_t length = 0;
+
+    ASSERT_EQ(KM_ERROR, km_authenticate(mSession, nullptr, 0));
+    ASSERT_STREQ("Invalid argument 'passphrase'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_repository_open(mSession, nullptr));
+    ASSERT_STREQ("Invalid argument 'repository_id'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_entry_get(mSession, nullptr, "password", &value, &length));
+    ASSERT_STREQ("Invalid argument 'entry'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_entry_get(mSession, "entry", nullptr, &value, &length));
+    ASSERT_STREQ("Invalid argument 'property'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_entry_get(mSession, "entry", "password", nullptr, &length));
+    ASSERT_STREQ("Invalid argument 'value'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_entry_get(mSession, "entry", "password", &value, nullptr));
+    ASSERT_STREQ("Invalid argument 'length'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_entry_list(mSession, nullptr));
+    ASSERT_STREQ("Invalid argument 'iterator'", km_last_error(mSession));
+
+    ASSERT_EQ(KM_ERROR, km_each_property(mSession, nullptr, nullptr));
+    ASSERT_STREQ("Invalid argument 'callback'", km_last_error(mSession));
+
+    const char *entryId, *name;
+
+    ASSERT_EQ(KM_ERROR, km_iterator_next(nullptr, &entryId, &name));
+
+    // The release functions accept null pointers
+    km_iterator_free(nullptr);
+    km_secret_free(nullptr, 0);
+}
+
+} // End of test namespace
@@ -0,0 +1,49 @@
+/*!
+ * Title ---- tests/LibkmTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_LIBKM_TEST_HPP__
+#define __KM_LIBKM_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km/c/libkm.h>
+
+#include <string>
+
+namespace tests { // Begin test namespace
+
+/*!
+ * The C interface test case.
+ */
+class LibkmTest : public testing::Test
+{
+
+protected:
+
+    /*!
+     * Opens the session.
+     */
+    virtual void SetUp();
+
+    /*!
+     * Closes the session.
+     */
+    virtual void TearDown();
+
+
+    /*!
+     * The session.
+     */
+    km_session *mSession;
+};
+
+} // End of test namespace
+
+#endif /* __KM_LIBKM_TEST_HPP__ */
@@ -0,0 +1,87 @@
+/*!
+ * Title ---- tests/MerkleTreeTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "MerkleTreeTest.hpp"
+
+namespace tests { // Begin test namespace
+
+TEST(MerkleTreeTest, root_empty)
+{
+    auto tree = MerkleTree::create();
+
+    ASSERT_EQ(0u, tree.size());
+    ASSERT_TRUE(tree.getRoot().empty());
+}
+
+TEST(MerkleTreeTest, root_order)
+{
+    auto first  = MerkleTree::create();
+    auto second = MerkleTree::create();
+
+    for (int i = 0; i < 100; ++i) {
+        first.setLeaf(Buffer::fromString(std::to_string(i)), MerkleTree::hash(std::to_string(i)));
+    }
+
+    for (int i = 99; i >= 0; --i) {
+        second.setLeaf(Buffer::fromString(std::to_string(i)), MerkleTree::hash(std::to_string(i)));
+    }
+
+    ASSERT_EQ(MerkleTree::HASH_LENGTH, first.getRoot().size());
+    ASSERT_EQ(first.getRoot(), second.getRoot());
+}
+
+TEST(MerkleTreeTest, root_update)
+{
+    auto tree = MerkleTree::create();
+
+    tree.setLeaf("a", MerkleTree::hash("a"));
+    tree.setLeaf("b", MerkleTree::hash("b"));
+
+    auto root = tree.getRoot();
+
+    tree.setLeaf("b", MerkleTree::hash("c"));
+    ASSERT_NE(root, tree.getRoot());
+
+    tree.setLeaf("b", MerkleTree::hash("b"));
+    ASSERT_EQ(root, tree.getRoot());
+
+    tree.removeLeaf("b");
+    ASSERT_NE(root, tree.getRoot());
+    ASSERT_EQ(1u, tree.size());
+}
+
+TEST(MerkleTreeTest, diff)
+{
+    auto local = MerkleTree::create();
+
+    for (int i = 0; i < 1000; ++i) {
+        local.setLeaf(Buffer::fromString(std::to_string(i)), MerkleTree::hash(std::to_string(i)));
+    }
+
+    auto remote = MerkleTree::fromBuffer(MerkleTree::toBuffer(local));
+
+    ASSERT_EQ(local.getRoot(), remote.getRoot());
+    ASSERT_TRUE(local.diff(remote).empty());
+
+    remote.setLeaf("10", MerkleTree::hash("changed"));
+    remote.removeLeaf("20");
+    remote.setLeaf("added", MerkleTree::hash("added"));
+
+    auto changes = local.diff(remote);
+
+    std::sort(changes.begin(), changes.end());
+
+    ASSERT_EQ(3u, changes.size());
+    ASSERT_EQ("10",    changes[0].toString());
+    ASSERT_EQ("20",    changes[1].toString());
+    ASSERT_EQ("added", changes[2].toString());
+}
+
+} // End of test namespace
@@ -0,0 +1,27 @@
+/*!
+ * Title ---- tests/MerkleTreeTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_MERKLE_TREE_TEST_HPP__
+#define __KM_MERKLE_TREE_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/MerkleTree.hpp>
+
+using namespace km;
+
+namespace tests { // Begin test namespace
+
+} // End of test namespace
+
+#endif /* __KM_MERKLE_TREE_TEST_HPP__ */
@@ -0,0 +1,176 @@
+/*!
+ * Title ---- tests/PushQueueTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "PushQueueTest.hpp"
+
+namespace tests { // Begin test namespace
+
+std::unique_ptr<PrivateKey> PushQueueTest::mPrivateKey;
+
+
+void
+PushQueueTest::SetUpTestCase()
+{
+    git_libgit2_init();
+
+    // NOTE: the queue logs its failures
+    if (!spdlog::get("km")) {
+        spdlog::create<spdlog::sinks::null_sink_mt>("km");
+    }
+
+    mPrivateKey = std::make_unique<PrivateKey>(
+        PrivateKey::fromPath("tests/fixtures/mykey", Buffer::fromString("passphrase"))
+    );
+}
+
+void
+PushQueueTest::SetUp()
+{
+    mPath = filesystem::temp_directory_path() / filesystem::unique_path();
+
+    filesystem::create_directories(mPath);
+
+    Repository::create("test", mPath / "test", *mPrivateKey);
+}
+
+void
+PushQueueTest::TearDown()
+{
+    filesystem::remove_all(mPath);
+}
+
+std::unique_ptr<TestPushQueue>
+PushQueueTest::createQueue() const
+{
+    return std::make_unique<TestPushQueue>(mPath / "push-queue", std::vector<filesystem::path>({ mPath }));
+}
+
+
+TEST_F(PushQueueTest, isPermanentFailure)
+{
+    ASSERT_TRUE(TestPushQueue::isPermanentFailure(GIT_ENONFASTFORWARD));
+    ASSERT_TRUE(TestPushQueue::isPermanentFailure(GIT_ENOTFOUND));
+
+    ASSERT_FALSE(TestPushQueue::isPermanentFailure(GIT_ERROR));
+    ASSERT_FALSE(TestPushQueue::isPermanentFailure(GIT_EUSER));
+}
+
+TEST_F(PushQueueTest, enqueue_Restart)
+{
+    auto queue = createQueue();
+
+    // The pushes are coalesced by repository
+    queue->enqueue("test").enqueue("test");
+
+    ASSERT_EQ(1U, queue->size());
+
+    queue.reset();
+
+    // The pending pushes survive a restart
+    queue = createQueue();
+
+    ASSERT_EQ(1U, queue->size());
+
+    queue->dequeue("test");
+    queue.reset();
+
+    ASSERT_EQ(0U, createQueue()->size());
+}
+
+TEST_F(PushQueueTest, flush)
+{
+    auto queue = createQueue();
+
+    unsigned int pushes = 0;
+
+    queue->mPush = [&pushes](const Buffer &) {
+        pushes++;
+    };
+
+    queue->start(*mPrivateKey);
+    queue->enqueue("test");
+
+    ASSERT_NO_THROW(queue->flush());
+    ASSERT_EQ(1U, pushes);
+    ASSERT_EQ(0U, queue->size());
+}
+
+TEST_F(PushQueueTest, push_Retry)
+{
+    auto queue = createQueue();
+
+    queue->mPush = [](const Buffer &) {
+        throw GitException(GIT_ERROR, GITERR_NET, "failed to send request: Connection refused");
+    };
+
+    queue->start(*mPrivateKey);
+    queue->enqueue("test");
+
+    ASSERT_THROW(queue->flush(), Exception);
+
+    // A failure schedules a retry with backoff (the flush may add an immediate attempt)
+    ASSERT_EQ(1U, queue->size());
+    ASSERT_GE(queue->getAttempts("test"), 1U);
+    ASSERT_TRUE(queue->isDelayed("test"));
+    ASSERT_TRUE(queue->getFailures().empty());
+}
+
+TEST_F(PushQueueTest, push_UnreachableHost)
+{
+    auto queue = createQueue();
+
+    // NOTE: the resolver error of an offline host mentions "not found"
+    queue->mPush = [](const Buffer &) {
+        throw boost::system::system_error(boost::asio::error::host_not_found);
+    };
+
+    queue->start(*mPrivateKey);
+    queue->enqueue("test");
+
+    ASSERT_THROW(queue->flush(), Exception);
+
+    ASSERT_EQ(1U, queue->size());
+    ASSERT_TRUE(queue->getFailures().empty());
+
+    queue.reset();
+
+    ASSERT_EQ(1U, createQueue()->size());
+}
+
+TEST_F(PushQueueTest, push_Rejected)
+{
+    auto queue = createQueue();
+
+    queue->mPush = [](const Buffer &) {
+        throw GitException(GIT_ENONFASTFORWARD, GITERR_NET, "cannot push non-fastforwardable reference");
+    };
+
+    queue->start(*mPrivateKey);
+    queue->enqueue("test");
+
+    ASSERT_THROW(queue->flush(), Exception);
+
+    // A rejected push isn't retried, but it is kept as failed
+    ASSERT_EQ(0U, queue->size());
+    ASSERT_EQ(1U, queue->getFailures().count("test"));
+
+    queue.reset();
+
+    queue = createQueue();
+
+    ASSERT_EQ(1U, queue->getFailures().count("test"));
+
+    // Scheduling the repository again clears the failure
+    queue->enqueue("test");
+
+    ASSERT_TRUE(queue->getFailures().empty());
+}
+
+} // End of test namespace
@@ -0,0 +1,136 @@
+/*!
+ * Title ---- tests/PushQueueTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_PUSH_QUEUE_TEST_HPP__
+#define __KM_PUSH_QUEUE_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/PrivateKey.hpp>
+#include <km/Repository.hpp>
+#include <km/PushQueue.hpp>
+
+#include <memory>
+#include <functional>
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+using namespace km;
+
+namespace tests { // Begin test namespace
+
+/*!
+ * A push queue running a given push.
+ */
+class TestPushQueue : public PushQueue
+{
+
+public:
+
+    using PushQueue::PushQueue;
+    using PushQueue::isPermanentFailure;
+
+    /*!
+     * Destructor method.
+     */
+    virtual ~TestPushQueue()
+    {
+        // NOTE: the worker must be stopped before the push goes away
+        stop();
+    }
+
+    /*!
+     * Returns the number of failed attempts of a push.
+     */
+    unsigned int getAttempts(const Buffer &repositoryId) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto it = mRetries.find(repositoryId);
+        return it != mRetries.end() ? it->second.attempts : 0;
+    }
+
+    /*!
+     * Indicates whether the next attempt of a push is scheduled later.
+     */
+    bool isDelayed(const Buffer &repositoryId) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto it = mRetries.find(repositoryId);
+        return it != mRetries.end() && it->second.next > Clock::now();
+    }
+
+
+    /*!
+     * The push.
+     */
+    std::function<void (const Buffer &)> mPush;
+
+protected:
+
+    virtual void push(const Buffer &repositoryId) override
+    {
+        mPush(repositoryId);
+    }
+};
+
+/*!
+ * The PushQueue test case.
+ */
+class PushQueueTest : public testing::Test
+{
+
+public:
+
+    /*!
+     * Sets up the test case.
+     */
+    static void SetUpTestCase();
+
+protected:
+
+    /*!
+     * Creates a local repository.
+     */
+    virtual void SetUp() override;
+
+    /*!
+     * Removes the repository and the queue state.
+     */
+    virtual void TearDown() override;
+
+    /*!
+     * Creates a queue.
+     */
+    std::unique_ptr<TestPushQueue> createQueue() const;
+
+
+    /*!
+     * The private key.
+     */
+    static std::unique_ptr<PrivateKey> mPrivateKey;
+
+    /*!
+     * The path to the keyrings and the queue state.
+     */
+    filesystem::path mPath;
+};
+
+} // End of test namespace
+
+#endif /* __KM_PUSH_QUEUE_TEST_HPP__ */
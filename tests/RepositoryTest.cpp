@@ -0,0 +1,190 @@
+/*!
+ * Title ---- tests/RepositoryTest.cpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#include "RepositoryTest.hpp"
+
+namespace tests { // Begin test namespace
+
+std::unique_ptr<PrivateKey> RepositoryTest::mPrivateKey;
+
+
+void
+RepositoryTest::SetUpTestCase()
+{
+    git_libgit2_init();
+
+    mPrivateKey = std::make_unique<PrivateKey>(
+        PrivateKey::fromPath("tests/fixtures/mykey", Buffer::fromString("passphrase"))
+    );
+}
+
+void
+RepositoryTest::SetUp()
+{
+    mPath = filesystem::temp_directory_path() / filesystem::unique_path();
+
+    filesystem::create_directories(mPath);
+
+    git_repository *remote;
+
+    ASSERT_EQ(0, git_repository_init(&remote, (mPath / "remote.git").c_str(), 1));
+
+    git_repository_free(remote);
+
+    auto first = Repository::create("test", mPath / "first", *mPrivateKey);
+    first.setRemoteUrl((mPath / "remote.git").string());
+
+    commitFile(first, "a", "first");
+    commitFile(first, "b", "second");
+
+    first.push();
+}
+
+void
+RepositoryTest::TearDown()
+{
+    filesystem::remove_all(mPath);
+}
+
+Repository
+RepositoryTest::clone(const std::string &name)
+{
+    git_repository *repository;
+
+    if (git_clone(&repository, (mPath / "remote.git").c_str(), (mPath / name).c_str(), NULL) < 0) {
+        throw Exception("Failed cloning the test repository");
+    }
+
+    git_repository_free(repository);
+
+    return Repository::fromPath("test", mPath / name, *mPrivateKey);
+}
+
+void
+RepositoryTest::commitFile(Repository &repository, const std::string &name, const std::string &content)
+{
+    filesystem::ofstream(repository.getPath() / "entries" / name) << content;
+
+    repository
+        .add("entries/*")
+        .commit(Buffer::fromString("Update " + name))
+    ;
+}
+
+
+TEST_F(RepositoryTest, fetch)
+{
+    auto first  = Repository::fromPath("test", mPath / "first", *mPrivateKey);
+    auto second = clone("second");
+
+    commitFile(first, "c", "third");
+    first.push();
+
+    second.fetch();
+
+    ASSERT_EQ(first.getHead(), second.getHead());
+    ASSERT_TRUE(filesystem::exists(second.getPath() / "entries" / "c"));
+}
+
+TEST_F(RepositoryTest, fetch_Changes)
+{
+    auto first  = Repository::fromPath("test", mPath / "first", *mPrivateKey);
+    auto second = clone("second");
+
+    commitFile(first, "b", "changed");
+    commitFile(first, "c", "third");
+
+    filesystem::remove(first.getPath() / "entries" / "a");
+
+    first
+        .update("entries/*")
+        .commit(Buffer::fromString("Remove a"))
+        .push()
+    ;
+
+    auto head = second.getHead();
+
+    second.fetch();
+
+    // Only the files changed by the fetch are reported (for the refresh of the keyring)
+    std::map<std::string, Repository::ChangeType> changes;
+
+    second.eachChange(head, second.getHead(), [&changes](const filesystem::path &path, Repository::ChangeType type) {
+        changes[path.string()] = type;
+    });
+
+    ASSERT_EQ(3U, changes.size());
+    ASSERT_EQ(Repository::CHANGE_DELETED,  changes["entries/a"]);
+    ASSERT_EQ(Repository::CHANGE_MODIFIED, changes["entries/b"]);
+    ASSERT_EQ(Repository::CHANGE_ADDED,    changes["entries/c"]);
+
+    ASSERT_FALSE(filesystem::exists(second.getPath() / "entries" / "a"));
+}
+
+TEST_F(RepositoryTest, fetch_Diverged)
+{
+    auto first  = Repository::fromPath("test", mPath / "first", *mPrivateKey);
+    auto second = clone("second");
+
+    commitFile(first, "c", "pushed");
+    first.push();
+
+    commitFile(second, "d", "not pushed");
+
+    auto head = second.getHead();
+
+    // The local commits are never dropped
+    ASSERT_THROW(second.fetch(), Exception);
+    ASSERT_EQ(head, second.getHead());
+    ASSERT_TRUE(filesystem::exists(second.getPath() / "entries" / "d"));
+}
+
+TEST_F(RepositoryTest, fetch_Compacted)
+{
+    auto first  = Repository::fromPath("test", mPath / "first", *mPrivateKey);
+    auto second = clone("second");
+
+    auto lease = first.getHead();
+
+    ASSERT_TRUE(first.compact(std::time(nullptr) + 1, Buffer::fromString("Compacted history")));
+
+    first.forcePush(lease);
+
+    // The rewritten history replaces the local one (nothing to lose)
+    ASSERT_NO_THROW(second.fetch());
+    ASSERT_EQ(first.getHead(), second.getHead());
+
+    commitFile(first, "c", "third");
+    first.push();
+
+    ASSERT_NO_THROW(second.fetch());
+    ASSERT_EQ(first.getHead(), second.getHead());
+}
+
+TEST_F(RepositoryTest, fetch_CompactedWithLocalCommits)
+{
+    auto first  = Repository::fromPath("test", mPath / "first", *mPrivateKey);
+    auto second = clone("second");
+
+    commitFile(second, "c", "not pushed");
+
+    auto head = second.getHead();
+
+    auto lease = first.getHead();
+
+    ASSERT_TRUE(first.compact(std::time(nullptr) + 1, Buffer::fromString("Compacted history")));
+
+    first.forcePush(lease);
+
+    ASSERT_THROW(second.fetch(), Exception);
+    ASSERT_EQ(head, second.getHead());
+}
+
+} // End of test namespace
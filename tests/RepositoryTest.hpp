@@ -0,0 +1,89 @@
+/*!
+ * Title ---- tests/RepositoryTest.hpp
+ * Author --- Giacomo Trudu aka `Wicker25` - wicker25[at]gmail[dot]com
+ *
+ * Copyright (C) 2017 by Giacomo Trudu.
+ * All rights reserved.
+ *
+ * This file is part of KeyMaker software.
+ */
+
+#ifndef __KM_REPOSITORY_TEST_HPP__
+#define __KM_REPOSITORY_TEST_HPP__
+
+#include <gtest/gtest.h>
+
+#include <km.hpp>
+#include <km/Exception.hpp>
+#include <km/Buffer.hpp>
+#include <km/PrivateKey.hpp>
+#include <km/Repository.hpp>
+
+#include <memory>
+#include <string>
+#include <map>
+#include <ctime>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+using namespace km;
+
+namespace tests { // Begin test namespace
+
+/*!
+ * The Repository test case (on a local remote).
+ */
+class RepositoryTest : public testing::Test
+{
+
+public:
+
+    /*!
+     * Sets up the test case.
+     */
+    static void SetUpTestCase();
+
+protected:
+
+    /*!
+     * Creates the remote and a first clone.
+     */
+    virtual void SetUp() override;
+
+    /*!
+     * Removes the repositories.
+     */
+    virtual void TearDown() override;
+
+    /*!
+     * Clones the remote.
+     *
+     * @param[in] name The clone name.
+     */
+    Repository clone(const std::string &name);
+
+    /*!
+     * Commits a file.
+     *
+     * @param[in] repository The repository.
+     * @param[in] name       The file name.
+     * @param[in] content    The file content.
+     */
+    static void commitFile(Repository &repository, const std::string &name, const std::string &content);
+
+
+    /*!
+     * The private key.
+     */
+    static std::unique_ptr<PrivateKey> mPrivateKey;
+
+    /*!
+     * The path to the repositories.
+     */
+    filesystem::path mPath;
+};
+
+} // End of test namespace
+
+#endif /* __KM_REPOSITORY_TEST_HPP__ */